@@ -244,6 +244,29 @@ bool Buffer::ReadAllWithProgress(int fd, int knownSize, float *progress, bool *c
 	return true;
 }
 
+bool Buffer::ReadUntilSizeWithProgress(int fd, size_t totalSize, float *progress, bool *cancelled) {
+	static constexpr float CANCEL_INTERVAL = 0.25f;
+	std::vector<char> buf(std::min(totalSize, (size_t)65536));
+	while (data_.size() < totalSize) {
+		bool ready = false;
+		while (!ready && cancelled) {
+			if (*cancelled)
+				return false;
+			ready = fd_util::WaitUntilReady(fd, CANCEL_INTERVAL, false);
+		}
+		int retval = recv(fd, &buf[0], (int)std::min(buf.size(), totalSize - data_.size()), MSG_NOSIGNAL);
+		if (retval <= 0) {
+			ERROR_LOG(IO, "Error reading from buffer: %i", retval);
+			return false;
+		}
+		char *p = Append((size_t)retval);
+		memcpy(p, &buf[0], retval);
+		if (progress)
+			*progress = (float)data_.size() / (float)totalSize;
+	}
+	return true;
+}
+
 int Buffer::Read(int fd, size_t sz) {
 	char buf[1024];
 	int retval;
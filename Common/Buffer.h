@@ -65,6 +65,8 @@ class Buffer {
 
   bool ReadAll(int fd, int hintSize = 0);
   bool ReadAllWithProgress(int fd, int knownSize, float *progress, bool *cancelled);
+  // Reads until the buffer holds totalSize bytes, without waiting for the other end to close.
+  bool ReadUntilSizeWithProgress(int fd, size_t totalSize, float *progress, bool *cancelled);
 
 	// < 0: error
 	// >= 0: number of bytes read
@@ -278,46 +278,114 @@ void ConvertRGBA8888ToRGBA4444(u16 *dst, const u32 *src, u32 numPixels) {
 	}
 }
 
-void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
+// These each expand 8 pixels to 8888, returning the first two bytes of each pixel in lo and the last two in hi.
+// With swapRB, the result is BGRA rather than RGBA.
+template <bool swapRB>
+static inline void ExpandRGB565SSE2(const __m128i &c, __m128i &lo, __m128i &hi) {
 	const __m128i mask5 = _mm_set1_epi16(0x001f);
 	const __m128i mask6 = _mm_set1_epi16(0x003f);
 	const __m128i mask8 = _mm_set1_epi16(0x00ff);
 
-	const __m128i *srcp = (const __m128i *)src;
-	__m128i *dstp = (__m128i *)dst32;
-	u32 sseChunks = numPixels / 8;
-	if (((intptr_t)src & 0xF) || ((intptr_t)dst32 & 0xF)) {
-		sseChunks = 0;
-	}
-	for (u32 i = 0; i < sseChunks; ++i) {
-		const __m128i c = _mm_load_si128(&srcp[i]);
+	// Swizzle, resulting in RR00 RR00.
+	__m128i r = _mm_and_si128(c, mask5);
+	r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+	r = _mm_and_si128(r, mask8);
+
+	// This one becomes 00GG 00GG.
+	__m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask6);
+	g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+	g = _mm_slli_epi16(g, 8);
 
-		// Swizzle, resulting in RR00 RR00.
-		__m128i r = _mm_and_si128(c, mask5);
-		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
-		r = _mm_and_si128(r, mask8);
+	// Almost done, we aim for BB00 BB00 again here.
+	__m128i b = _mm_and_si128(_mm_srli_epi16(c, 11), mask5);
+	b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+	b = _mm_and_si128(b, mask8);
 
-		// This one becomes 00GG 00GG.
-		__m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask6);
-		g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
-		g = _mm_slli_epi16(g, 8);
+	// Always set alpha to 00FF 00FF.
+	__m128i a = _mm_slli_epi16(mask8, 8);
 
-		// Almost done, we aim for BB00 BB00 again here.
-		__m128i b = _mm_and_si128(_mm_srli_epi16(c, 11), mask5);
-		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
-		b = _mm_and_si128(b, mask8);
+	// Now combine them, RRGG RRGG and BBAA BBAA.
+	lo = _mm_or_si128(swapRB ? b : r, g);
+	hi = _mm_or_si128(swapRB ? r : b, a);
+}
 
-		// Always set alpha to 00FF 00FF.
-		__m128i a = _mm_slli_epi16(mask8, 8);
+template <bool swapRB>
+static inline void ExpandRGBA5551SSE2(const __m128i &c, __m128i &lo, __m128i &hi) {
+	const __m128i mask5 = _mm_set1_epi16(0x001f);
+	const __m128i mask8 = _mm_set1_epi16(0x00ff);
 
-		// Now combine them, RRGG RRGG and BBAA BBAA, and then interleave.
-		const __m128i rg = _mm_or_si128(r, g);
-		const __m128i ba = _mm_or_si128(b, a);
-		_mm_store_si128(&dstp[i * 2 + 0], _mm_unpacklo_epi16(rg, ba));
-		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
+	// Swizzle, resulting in RR00 RR00.
+	__m128i r = _mm_and_si128(c, mask5);
+	r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+	r = _mm_and_si128(r, mask8);
+
+	// This one becomes 00GG 00GG.
+	__m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask5);
+	g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+	g = _mm_slli_epi16(g, 8);
+
+	// Almost done, we aim for BB00 BB00 again here.
+	__m128i b = _mm_and_si128(_mm_srli_epi16(c, 10), mask5);
+	b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+	b = _mm_and_si128(b, mask8);
+
+	// 1 bit A to 00AA 00AA.
+	__m128i a = _mm_srai_epi16(c, 15);
+	a = _mm_slli_epi16(a, 8);
+
+	lo = _mm_or_si128(swapRB ? b : r, g);
+	hi = _mm_or_si128(swapRB ? r : b, a);
+}
+
+template <bool swapRB>
+static inline void ExpandRGBA4444SSE2(const __m128i &c, __m128i &lo, __m128i &hi) {
+	const __m128i mask4 = _mm_set1_epi16(0x000f);
+
+	// Let's just grab R000 R000, without swizzling yet.
+	__m128i r = _mm_and_si128(c, mask4);
+	// And then 00G0 00G0.
+	__m128i g = _mm_and_si128(_mm_srli_epi16(c, 4), mask4);
+	g = _mm_slli_epi16(g, 8);
+	// Now B000 B000.
+	__m128i b = _mm_and_si128(_mm_srli_epi16(c, 8), mask4);
+	// And lastly 00A0 00A0.  No mask needed, we have a wall.
+	__m128i a = _mm_srli_epi16(c, 12);
+	a = _mm_slli_epi16(a, 8);
+
+	// We swizzle after combining - R0G0 R0G0 and B0A0 B0A0 -> RRGG RRGG and BBAA BBAA.
+	lo = _mm_or_si128(swapRB ? b : r, g);
+	hi = _mm_or_si128(swapRB ? r : b, a);
+	lo = _mm_or_si128(lo, _mm_slli_epi16(lo, 4));
+	hi = _mm_or_si128(hi, _mm_slli_epi16(hi, 4));
+}
+
+// Runs one of the above over all whole groups of 8 pixels, returning how many pixels were converted.
+template <void (*Expand)(const __m128i &c, __m128i &lo, __m128i &hi)>
+static inline u32 Convert16To32SSE2(u32 *dst32, const u16 *src, u32 numPixels) {
+	const __m128i *srcp = (const __m128i *)src;
+	__m128i *dstp = (__m128i *)dst32;
+	const u32 sseChunks = numPixels / 8;
+	// Unaligned access is cheap on anything recent, and textures often aren't aligned.
+	for (u32 i = 0; i < sseChunks; ++i) {
+		__m128i lo, hi;
+		Expand(_mm_loadu_si128(&srcp[i]), lo, hi);
+		_mm_storeu_si128(&dstp[i * 2 + 0], _mm_unpacklo_epi16(lo, hi));
+		_mm_storeu_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(lo, hi));
+	}
+	return sseChunks * 8;
+}
+#endif
+
+void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
+#ifdef _M_SSE
+	u32 i = Convert16To32SSE2<&ExpandRGB565SSE2<false>>(dst32, src, numPixels);
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	if (cpu_info.bNEON) {
+		i = numPixels & ~7;
+		ConvertRGB565ToRGBA8888NEON(dst32, src, i);
 	}
-	u32 i = sseChunks * 8;
 #else
 	u32 i = 0;
 #endif
@@ -334,44 +402,13 @@ void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 
 void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
-	const __m128i mask5 = _mm_set1_epi16(0x001f);
-	const __m128i mask8 = _mm_set1_epi16(0x00ff);
-
-	const __m128i *srcp = (const __m128i *)src;
-	__m128i *dstp = (__m128i *)dst32;
-	u32 sseChunks = numPixels / 8;
-	if (((intptr_t)src & 0xF) || ((intptr_t)dst32 & 0xF)) {
-		sseChunks = 0;
-	}
-	for (u32 i = 0; i < sseChunks; ++i) {
-		const __m128i c = _mm_load_si128(&srcp[i]);
-
-		// Swizzle, resulting in RR00 RR00.
-		__m128i r = _mm_and_si128(c, mask5);
-		r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
-		r = _mm_and_si128(r, mask8);
-
-		// This one becomes 00GG 00GG.
-		__m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask5);
-		g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
-		g = _mm_slli_epi16(g, 8);
-
-		// Almost done, we aim for BB00 BB00 again here.
-		__m128i b = _mm_and_si128(_mm_srli_epi16(c, 10), mask5);
-		b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
-		b = _mm_and_si128(b, mask8);
-
-		// 1 bit A to 00AA 00AA.
-		__m128i a = _mm_srai_epi16(c, 15);
-		a = _mm_slli_epi16(a, 8);
-
-		// Now combine them, RRGG RRGG and BBAA BBAA, and then interleave.
-		const __m128i rg = _mm_or_si128(r, g);
-		const __m128i ba = _mm_or_si128(b, a);
-		_mm_store_si128(&dstp[i * 2 + 0], _mm_unpacklo_epi16(rg, ba));
-		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
+	u32 i = Convert16To32SSE2<&ExpandRGBA5551SSE2<false>>(dst32, src, numPixels);
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	if (cpu_info.bNEON) {
+		i = numPixels & ~7;
+		ConvertRGBA5551ToRGBA8888NEON(dst32, src, i);
 	}
-	u32 i = sseChunks * 8;
 #else
 	u32 i = 0;
 #endif
@@ -388,39 +425,13 @@ void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 
 void ConvertRGBA4444ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
-	const __m128i mask4 = _mm_set1_epi16(0x000f);
-
-	const __m128i *srcp = (const __m128i *)src;
-	__m128i *dstp = (__m128i *)dst32;
-	u32 sseChunks = numPixels / 8;
-	if (((intptr_t)src & 0xF) || ((intptr_t)dst32 & 0xF)) {
-		sseChunks = 0;
+	u32 i = Convert16To32SSE2<&ExpandRGBA4444SSE2<false>>(dst32, src, numPixels);
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	if (cpu_info.bNEON) {
+		i = numPixels & ~7;
+		ConvertRGBA4444ToRGBA8888NEON(dst32, src, i);
 	}
-	for (u32 i = 0; i < sseChunks; ++i) {
-		const __m128i c = _mm_load_si128(&srcp[i]);
-
-		// Let's just grab R000 R000, without swizzling yet.
-		__m128i r = _mm_and_si128(c, mask4);
-		// And then 00G0 00G0.
-		__m128i g = _mm_and_si128(_mm_srli_epi16(c, 4), mask4);
-		g = _mm_slli_epi16(g, 8);
-		// Now B000 B000.
-		__m128i b = _mm_and_si128(_mm_srli_epi16(c, 8), mask4);
-		// And lastly 00A0 00A0.  No mask needed, we have a wall.
-		__m128i a = _mm_srli_epi16(c, 12);
-		a = _mm_slli_epi16(a, 8);
-
-		// We swizzle after combining - R0G0 R0G0 and B0A0 B0A0 -> RRGG RRGG and BBAA BBAA.
-		__m128i rg = _mm_or_si128(r, g);
-		__m128i ba = _mm_or_si128(b, a);
-		rg = _mm_or_si128(rg, _mm_slli_epi16(rg, 4));
-		ba = _mm_or_si128(ba, _mm_slli_epi16(ba, 4));
-
-		// And then we can store.
-		_mm_store_si128(&dstp[i * 2 + 0], _mm_unpacklo_epi16(rg, ba));
-		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
-	}
-	u32 i = sseChunks * 8;
 #else
 	u32 i = 0;
 #endif
@@ -468,9 +479,20 @@ void ConvertABGR4444ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 	}
 }
 
-void ConvertRGBA4444ToBGRA8888(u32 *dst32, const u16 *src, u32 numPixels) {
-	u8 *dst = (u8 *)dst32;
-	for (u32 x = 0; x < numPixels; x++) {
+void ConvertRGBA4444ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
+#ifdef _M_SSE
+	u32 i = Convert16To32SSE2<&ExpandRGBA4444SSE2<true>>(dst, src, numPixels);
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	if (cpu_info.bNEON) {
+		i = numPixels & ~7;
+		ConvertRGBA4444ToBGRA8888NEON(dst, src, i);
+	}
+#else
+	u32 i = 0;
+#endif
+
+	for (u32 x = i; x < numPixels; x++) {
 		u16 c = src[x];
 		u32 r = Convert4To8(c & 0x000f);
 		u32 g = Convert4To8((c >> 4) & 0x000f);
@@ -482,7 +504,19 @@ void ConvertRGBA4444ToBGRA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 }
 
 void ConvertRGBA5551ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
-	for (u32 x = 0; x < numPixels; x++) {
+#ifdef _M_SSE
+	u32 i = Convert16To32SSE2<&ExpandRGBA5551SSE2<true>>(dst, src, numPixels);
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	if (cpu_info.bNEON) {
+		i = numPixels & ~7;
+		ConvertRGBA5551ToBGRA8888NEON(dst, src, i);
+	}
+#else
+	u32 i = 0;
+#endif
+
+	for (u32 x = i; x < numPixels; x++) {
 		u16 c = src[x];
 		u32 r = Convert5To8(c & 0x001f);
 		u32 g = Convert5To8((c >> 5) & 0x001f);
@@ -495,7 +529,19 @@ void ConvertRGBA5551ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
 }
 
 void ConvertRGB565ToBGRA8888(u32 *dst, const u16 *src, u32 numPixels) {
-	for (u32 x = 0; x < numPixels; x++) {
+#ifdef _M_SSE
+	u32 i = Convert16To32SSE2<&ExpandRGB565SSE2<true>>(dst, src, numPixels);
+#elif PPSSPP_ARCH(ARM_NEON)
+	u32 i = 0;
+	if (cpu_info.bNEON) {
+		i = numPixels & ~7;
+		ConvertRGB565ToBGRA8888NEON(dst, src, i);
+	}
+#else
+	u32 i = 0;
+#endif
+
+	for (u32 x = i; x < numPixels; x++) {
 		u16 c = src[x];
 		u32 r = Convert5To8(c & 0x001f);
 		u32 g = Convert6To8((c >> 5) & 0x003f);
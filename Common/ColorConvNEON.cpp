@@ -115,4 +115,90 @@ void ConvertRGB565ToBGR565NEON(u16 *dst, const u16 *src, u32 numPixels) {
 	}
 }
 
+// Each of these expands 8 pixels to separate 8-bit R, G, B, and A.
+static inline uint8x8x4_t ExpandRGB565NEON(uint16x8_t c) {
+	const uint16x8_t r5 = vshlq_n_u16(c, 11);
+	const uint16x8_t g6 = vshlq_n_u16(vshrq_n_u16(c, 5), 10);
+	const uint16x8_t b5 = vshrq_n_u16(c, 11);
+
+	uint8x8x4_t res;
+	// Take the top 5 or 6 bits, then replicate the top bits down like Convert5To8().
+	const uint8x8_t r = vshrn_n_u16(r5, 8);
+	const uint8x8_t g = vshrn_n_u16(g6, 8);
+	const uint8x8_t b = vshl_n_u8(vmovn_u16(b5), 3);
+	res.val[0] = vorr_u8(r, vshr_n_u8(r, 5));
+	res.val[1] = vorr_u8(g, vshr_n_u8(g, 6));
+	res.val[2] = vorr_u8(b, vshr_n_u8(b, 5));
+	res.val[3] = vdup_n_u8(0xFF);
+	return res;
+}
+
+static inline uint8x8x4_t ExpandRGBA5551NEON(uint16x8_t c) {
+	const uint8x8_t r = vshrn_n_u16(vshlq_n_u16(c, 11), 8);
+	const uint8x8_t g = vshrn_n_u16(vshlq_n_u16(vshrq_n_u16(c, 5), 11), 8);
+	const uint8x8_t b = vshrn_n_u16(vshlq_n_u16(vshrq_n_u16(c, 10), 11), 8);
+
+	uint8x8x4_t res;
+	res.val[0] = vorr_u8(r, vshr_n_u8(r, 5));
+	res.val[1] = vorr_u8(g, vshr_n_u8(g, 5));
+	res.val[2] = vorr_u8(b, vshr_n_u8(b, 5));
+	// Arithmetic shift to spread the alpha bit to 0x00 or 0xFF.
+	res.val[3] = vreinterpret_u8_s8(vshrn_n_s16(vshrq_n_s16(vreinterpretq_s16_u16(c), 15), 8));
+	return res;
+}
+
+static inline uint8x8x4_t ExpandRGBA4444NEON(uint16x8_t c) {
+	const uint8x8_t lo = vmovn_u16(c);
+	const uint8x8_t hi = vshrn_n_u16(c, 8);
+	const uint8x8_t mask4 = vdup_n_u8(0x0F);
+
+	uint8x8x4_t res;
+	res.val[0] = vand_u8(lo, mask4);
+	res.val[1] = vshr_n_u8(lo, 4);
+	res.val[2] = vand_u8(hi, mask4);
+	res.val[3] = vshr_n_u8(hi, 4);
+	for (int i = 0; i < 4; ++i) {
+		res.val[i] = vorr_u8(res.val[i], vshl_n_u8(res.val[i], 4));
+	}
+	return res;
+}
+
+template <uint8x8x4_t (*Expand)(uint16x8_t c), bool swapRB>
+static inline void Convert16To32NEON(u32 *dst, const u16 *src, u32 numPixels) {
+	for (u32 i = 0; i < numPixels; i += 8) {
+		uint8x8x4_t res = Expand(vld1q_u16(src + i));
+		if (swapRB) {
+			uint8x8_t r = res.val[0];
+			res.val[0] = res.val[2];
+			res.val[2] = r;
+		}
+		// This interleaves them back into RGBA pixels as it stores.
+		vst4_u8((u8 *)(dst + i), res);
+	}
+}
+
+void ConvertRGB565ToRGBA8888NEON(u32 *dst, const u16 *src, u32 numPixels) {
+	Convert16To32NEON<&ExpandRGB565NEON, false>(dst, src, numPixels);
+}
+
+void ConvertRGBA5551ToRGBA8888NEON(u32 *dst, const u16 *src, u32 numPixels) {
+	Convert16To32NEON<&ExpandRGBA5551NEON, false>(dst, src, numPixels);
+}
+
+void ConvertRGBA4444ToRGBA8888NEON(u32 *dst, const u16 *src, u32 numPixels) {
+	Convert16To32NEON<&ExpandRGBA4444NEON, false>(dst, src, numPixels);
+}
+
+void ConvertRGB565ToBGRA8888NEON(u32 *dst, const u16 *src, u32 numPixels) {
+	Convert16To32NEON<&ExpandRGB565NEON, true>(dst, src, numPixels);
+}
+
+void ConvertRGBA5551ToBGRA8888NEON(u32 *dst, const u16 *src, u32 numPixels) {
+	Convert16To32NEON<&ExpandRGBA5551NEON, true>(dst, src, numPixels);
+}
+
+void ConvertRGBA4444ToBGRA8888NEON(u32 *dst, const u16 *src, u32 numPixels) {
+	Convert16To32NEON<&ExpandRGBA4444NEON, true>(dst, src, numPixels);
+}
+
 #endif // PPSSPP_ARCH(ARM_NEON)
@@ -22,3 +22,11 @@
 void ConvertRGBA4444ToABGR4444NEON(u16 *dst, const u16 *src, u32 numPixels);
 void ConvertRGBA5551ToABGR1555NEON(u16 *dst, const u16 *src, u32 numPixels);
 void ConvertRGB565ToBGR565NEON(u16 *dst, const u16 *src, u32 numPixels);
+
+// These only convert whole groups of 8 pixels, numPixels must be a multiple of 8.
+void ConvertRGB565ToRGBA8888NEON(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGBA5551ToRGBA8888NEON(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGBA4444ToRGBA8888NEON(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGB565ToBGRA8888NEON(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGBA5551ToBGRA8888NEON(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGBA4444ToBGRA8888NEON(u32 *dst, const u16 *src, u32 numPixels);
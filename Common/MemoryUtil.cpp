@@ -37,6 +37,7 @@
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <mach/vm_param.h>
+#include <sys/sysctl.h>
 #endif
 
 #ifndef _WIN32
@@ -342,3 +343,27 @@ int GetMemoryProtectPageSize() {
 #endif
 	return MEM_PAGE_SIZE;
 }
+
+uint64_t GetPhysicalMemorySize() {
+#ifdef _WIN32
+	MEMORYSTATUSEX status{};
+	status.dwLength = sizeof(status);
+	if (!GlobalMemoryStatusEx(&status))
+		return 0;
+	return status.ullTotalPhys;
+#elif defined(__APPLE__)
+	uint64_t size = 0;
+	size_t len = sizeof(size);
+	if (sysctlbyname("hw.memsize", &size, &len, nullptr, 0) != 0)
+		return 0;
+	return size;
+#elif defined(_SC_PHYS_PAGES)
+	long pages = sysconf(_SC_PHYS_PAGES);
+	long pageSize = sysconf(_SC_PAGESIZE);
+	if (pages <= 0 || pageSize <= 0)
+		return 0;
+	return (uint64_t)pages * (uint64_t)pageSize;
+#else
+	return 0;
+#endif
+}
@@ -45,6 +45,9 @@ void FreeAlignedMemory(void* ptr);
 
 int GetMemoryProtectPageSize();
 
+// Total physical memory of the host, or 0 if it can't be determined.
+uint64_t GetPhysicalMemorySize();
+
 template <typename T>
 class SimpleBuf {
 public:
@@ -21,9 +21,14 @@
 #include <io.h>
 #endif
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include "Common/Net/Resolve.h"
 #include "Common/Net/URL.h"
@@ -94,6 +99,18 @@ bool Connection::Resolve(const char *host, int port, DNSType type) {
 }
 
 bool Connection::Connect(int maxTries, double timeout, bool *cancelConnect) {
+	return Connect(maxTries, timeout, [cancelConnect] {
+		return cancelConnect && *cancelConnect;
+	});
+}
+
+bool Connection::Connect(int maxTries, double timeout, const std::atomic<bool> *cancelConnect) {
+	return Connect(maxTries, timeout, [cancelConnect] {
+		return cancelConnect && cancelConnect->load();
+	});
+}
+
+bool Connection::Connect(int maxTries, double timeout, const std::function<bool()> &cancelled) {
 	if (port_ <= 0) {
 		ERROR_LOG(IO, "Bad port");
 		return false;
@@ -140,7 +157,7 @@ bool Connection::Connect(int maxTries, double timeout, bool *cancelConnect) {
 			--timeoutHalfSeconds;
 
 			selectResult = select(maxfd, nullptr, &fds, nullptr, &tv);
-			if (cancelConnect && *cancelConnect) {
+			if (cancelled()) {
 				break;
 			}
 		}
@@ -159,7 +176,7 @@ bool Connection::Connect(int maxTries, double timeout, bool *cancelConnect) {
 			return true;
 		}
 
-		if (cancelConnect && *cancelConnect) {
+		if (cancelled()) {
 			break;
 		}
 
@@ -245,6 +262,48 @@ void DeChunk(Buffer *inbuffer, Buffer *outbuffer, int contentLength, float *prog
 	}
 }
 
+// Reads a chunked entity through the terminating chunk and any trailers, and dechunks it into output.
+// Used on kept alive connections, where we can't just read until the server closes.
+static bool ReadChunkedEntity(uintptr_t sock, Buffer *readbuf, Buffer *output, bool *cancelled) {
+	// Waits for more data until readbuf holds a whole line.
+	auto takeLine = [&](std::string *line) {
+		while (readbuf->TakeLineCRLF(line) < 0) {
+			if (!readbuf->ReadUntilSizeWithProgress(sock, readbuf->size() + 1, nullptr, cancelled))
+				return false;
+		}
+		return true;
+	};
+
+	while (true) {
+		std::string line;
+		if (!takeLine(&line))
+			return false;
+		unsigned int chunkSize;
+		if (sscanf(line.c_str(), "%x", &chunkSize) != 1) {
+			ERROR_LOG(IO, "Invalid HTTP chunk header: %s", line.c_str());
+			return false;
+		}
+		if (chunkSize == 0)
+			break;
+
+		// The chunk is followed by a CRLF.
+		if (!readbuf->ReadUntilSizeWithProgress(sock, chunkSize + 2, nullptr, cancelled))
+			return false;
+		std::string data;
+		readbuf->Take(chunkSize, &data);
+		output->Append(data);
+		readbuf->Skip(2);
+	}
+
+	// Skip any trailers, up to the final empty line.
+	std::string line;
+	do {
+		if (!takeLine(&line))
+			return false;
+	} while (!line.empty());
+	return true;
+}
+
 int Client::GET(const char *resource, Buffer *output, std::vector<std::string> &responseHeaders, float *progress, bool *cancelled) {
 	const char *otherHeaders =
 		"Accept: */*\r\n"
@@ -317,7 +376,7 @@ int Client::SendRequestWithData(const char *method, const char *resource, const
 		"%s %s HTTP/%s\r\n"
 		"Host: %s\r\n"
 		"User-Agent: %s\r\n"
-		"Connection: close\r\n"
+		"Connection: %s\r\n"
 		"%s"
 		"\r\n";
 
@@ -325,6 +384,7 @@ int Client::SendRequestWithData(const char *method, const char *resource, const
 		method, resource, httpVersion_,
 		host_.c_str(),
 		userAgent_,
+		keepAlive_ ? "keep-alive" : "close",
 		otherHeaders ? otherHeaders : "");
 	buffer.Append(data);
 	bool flushed = buffer.FlushSocket(sock(), dataTimeout_);
@@ -337,25 +397,33 @@ int Client::SendRequestWithData(const char *method, const char *resource, const
 int Client::ReadResponseHeaders(Buffer *readbuf, std::vector<std::string> &responseHeaders, float *progress, bool *cancelled) {
 	// Snarf all the data we can into RAM. A little unsafe but hey.
 	static constexpr float CANCEL_INTERVAL = 0.25f;
-	bool ready = false;
 	double leftTimeout = dataTimeout_;
-	while (!ready) {
-		if (cancelled && *cancelled)
-			return -1;
-		ready = fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false);
-		if (!ready && leftTimeout >= 0.0) {
-			leftTimeout -= CANCEL_INTERVAL;
-			if (leftTimeout < 0) {
-				ERROR_LOG(IO, "HTTP headers timed out");
+	std::string received;
+	char buf[4096];
+	// Read until the blank line after the headers.  Any of the entity that came along stays in readbuf.
+	// Reading a fixed size instead would block on a kept alive connection.
+	do {
+		bool ready = false;
+		while (!ready) {
+			if (cancelled && *cancelled)
 				return -1;
+			ready = fd_util::WaitUntilReady(sock(), CANCEL_INTERVAL, false);
+			if (!ready && leftTimeout >= 0.0) {
+				leftTimeout -= CANCEL_INTERVAL;
+				if (leftTimeout < 0) {
+					ERROR_LOG(IO, "HTTP headers timed out");
+					return -1;
+				}
 			}
 		}
-	};
-	// Let's hope all the headers are available in a single packet...
-	if (readbuf->Read(sock(), 4096) < 0) {
-		ERROR_LOG(IO, "Failed to read HTTP headers :(");
-		return -1;
-	}
+		int retval = recv(sock(), buf, (int)sizeof(buf), MSG_NOSIGNAL);
+		if (retval <= 0) {
+			ERROR_LOG(IO, "Failed to read HTTP headers :(");
+			return -1;
+		}
+		memcpy(readbuf->Append((size_t)retval), buf, retval);
+		readbuf->PeekAll(&received);
+	} while (received.find("\r\n\r\n") == received.npos);
 
 	// Grab the first header line that contains the http code.
 
@@ -393,6 +461,7 @@ int Client::ReadResponseHeaders(Buffer *readbuf, std::vector<std::string> &respo
 int Client::ReadResponseEntity(Buffer *readbuf, const std::vector<std::string> &responseHeaders, Buffer *output, float *progress, bool *cancelled) {
 	bool gzip = false;
 	bool chunked = false;
+	bool hasContentLength = false;
 	int contentLength = 0;
 	for (std::string line : responseHeaders) {
 		if (startsWithNoCase(line, "Content-Length:")) {
@@ -402,6 +471,7 @@ int Client::ReadResponseEntity(Buffer *readbuf, const std::vector<std::string> &
 			}
 			if (size_pos != line.npos) {
 				contentLength = atoi(&line[size_pos]);
+				hasContentLength = true;
 				chunked = false;
 			}
 		} else if (startsWithNoCase(line, "Content-Encoding:")) {
@@ -428,7 +498,24 @@ int Client::ReadResponseEntity(Buffer *readbuf, const std::vector<std::string> &
 		*progress = 0.1f;
 	}
 
-	if (!contentLength || !progress) {
+	if (keepAlive_) {
+		// The server won't close the connection, so stop at the end of the entity.
+		// If something goes wrong, we don't know where the next response starts, so give up on the connection.
+		bool success;
+		if (chunked) {
+			success = ReadChunkedEntity(sock(), readbuf, output, cancelled);
+		} else if (hasContentLength) {
+			success = readbuf->ReadUntilSizeWithProgress(sock(), contentLength, progress, cancelled);
+		} else {
+			// The entity ends when the server closes, which a kept alive connection may never do.
+			ERROR_LOG(IO, "HTTP response on a kept alive connection has no length");
+			success = false;
+		}
+		if (!success) {
+			Disconnect();
+			return -1;
+		}
+	} else if (!contentLength || !progress) {
 		// No way to know how far along we are. Let's just not update the progress counter.
 		if (!readbuf->ReadAllWithProgress(sock(), contentLength, nullptr, cancelled))
 			return -1;
@@ -440,7 +527,9 @@ int Client::ReadResponseEntity(Buffer *readbuf, const std::vector<std::string> &
 
 	// output now contains the rest of the reply. Dechunk it.
 	if (chunked) {
-		DeChunk(readbuf, output, contentLength, progress);
+		// Kept alive connections dechunk as they read.
+		if (!keepAlive_)
+			DeChunk(readbuf, output, contentLength, progress);
 	} else {
 		output->Append(*readbuf);
 	}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <thread>
@@ -20,6 +21,8 @@ class Connection {
 	bool Resolve(const char *host, int port, DNSType type = DNSType::ANY);
 
 	bool Connect(int maxTries = 2, double timeout = 20.0f, bool *cancelConnect = nullptr);
+	// For a cancel flag that other threads may set at any time.
+	bool Connect(int maxTries, double timeout, const std::atomic<bool> *cancelConnect);
 	void Disconnect();
 
 	// Only to be used for bring-up and debugging.
@@ -34,6 +37,8 @@ class Connection {
 	addrinfo *resolved_;
 
 private:
+	bool Connect(int maxTries, double timeout, const std::function<bool()> &cancelled);
+
 	uintptr_t sock_;
 
 };
@@ -68,11 +73,17 @@ class Client : public net::Connection {
 	void SetDataTimeout(double t) {
 		dataTimeout_ = t;
 	}
+	// Asks the server to keep the connection open for more requests.  Entities are then read by
+	// Content-Length rather than until close, so every response must be read fully.
+	void SetKeepAlive(bool keepAlive) {
+		keepAlive_ = keepAlive;
+	}
 
 protected:
 	const char *userAgent_;
 	const char *httpVersion_;
 	double dataTimeout_ = -1.0;
+	bool keepAlive_ = false;
 };
 
 // Not particularly efficient, but hey - it's a background download, that's pretty cool :P
@@ -63,6 +63,10 @@ class WebSocketServer {
 	bool IsOpen() {
 		return open_;
 	}
+	// Bytes queued that the socket hasn't accepted yet, useful to apply backpressure.
+	size_t BufferedBytes() const {
+		return outBuf_.size();
+	}
 	WebSocketClose CloseReason() {
 		return closeReason_;
 	}
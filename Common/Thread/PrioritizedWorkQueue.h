@@ -25,13 +25,14 @@ class PrioritizedWorkQueueItem {
 
 class PrioritizedWorkQueue {
 public:
-	PrioritizedWorkQueue() : done_(false), working_(false) {}
+	PrioritizedWorkQueue() : done_(false), working_(0) {}
 	~PrioritizedWorkQueue();
 	// Takes ownership.
 	void Add(PrioritizedWorkQueueItem *item);
 
 	// The worker should simply call this in a loop. Will block when appropriate.
-	PrioritizedWorkQueueItem *Pop();
+	// finishedItem is whether the worker ran an item returned by the previous call.
+	PrioritizedWorkQueueItem *Pop(bool finishedItem);
 
 	void Flush();
 	bool Done() { return done_; }
@@ -39,7 +40,7 @@ class PrioritizedWorkQueue {
 	bool WaitUntilDone(bool all = true);
 
 	bool IsWorking() {
-		return working_;
+		return working_ != 0;
 	}
 
 private:
@@ -47,7 +48,8 @@ class PrioritizedWorkQueue {
 	bool AllItemsDone();
 
 	bool done_;
-	bool working_;
+	// Number of items being worked on, since there may be several workers.
+	int working_;
 	std::mutex mutex_;
 	std::mutex drainMutex_;
 	std::condition_variable notEmpty_;
@@ -59,7 +61,7 @@ class PrioritizedWorkQueue {
 };
 
 
-// Starts up a thread that keeps trying to run this workqueue.
+// Starts up threads that keep trying to run this workqueue.
 // TODO: This feels ugly. Revisit later.
-void ProcessWorkQueueOnThreadWhile(PrioritizedWorkQueue *wq);
+void ProcessWorkQueueOnThreadWhile(PrioritizedWorkQueue *wq, int threadCount = 1);
 void StopProcessingWorkQueue(PrioritizedWorkQueue *wq);
@@ -182,6 +182,7 @@ struct Config {
 	bool bVertexCache;
 	bool bTextureBackoffCache;
 	bool bTextureSecondaryCache;
+	bool bTextureWriteTracking;
 	bool bVertexDecoderJit;
 	bool bFullScreen;
 	bool bFullScreenMulti;
@@ -200,6 +201,7 @@ struct Config {
 	int iMaxRecent;
 	int iCurrentStateSlot;
 	int iRewindFlipFrequency;
+	bool bRewindTrackWrites;
 	bool bUISound;
 	bool bEnableStateUndo;
 	int iAutoLoadSaveState; // 0 = off, 1 = oldest, 2 = newest, >2 = slot number + 3
@@ -58,6 +58,9 @@ static bool singleStepPending = false;
 static int steppingCounter = 0;
 static std::set<CoreLifecycleFunc> lifecycleFuncs;
 static std::set<CoreStopRequestFunc> stopFuncs;
+// These may be added from other threads (i.e. the debugger) while running.
+static std::mutex frameFuncsLock;
+static std::set<CoreFrameFunc> frameFuncs;
 static bool windowHidden = false;
 static double lastActivity = 0.0;
 static double lastKeepAwake = 0.0;
@@ -94,6 +97,18 @@ void Core_ListenStopRequest(CoreStopRequestFunc func) {
 	stopFuncs.insert(func);
 }
 
+void Core_ListenFrame(CoreFrameFunc func) {
+	std::lock_guard<std::mutex> guard(frameFuncsLock);
+	frameFuncs.insert(func);
+}
+
+void Core_NotifyFrame() {
+	std::lock_guard<std::mutex> guard(frameFuncsLock);
+	for (auto func : frameFuncs) {
+		func();
+	}
+}
+
 void Core_Stop() {
 	g_exceptionInfo.type = ExceptionType::NONE;
 	Core_UpdateState(CORE_POWERDOWN);
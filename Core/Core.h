@@ -64,6 +64,11 @@ void Core_NotifyLifecycle(CoreLifecycle stage);
 typedef void (* CoreStopRequestFunc)();
 void Core_ListenStopRequest(CoreStopRequestFunc callback);
 
+// Callback is called on the Emu thread at each vblank, a consistent point between frames.
+typedef void (* CoreFrameFunc)();
+void Core_ListenFrame(CoreFrameFunc func);
+void Core_NotifyFrame();
+
 bool Core_IsStepping();
 
 bool Core_IsActive();
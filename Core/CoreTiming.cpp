@@ -15,10 +15,12 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <vector>
 #include <cstdio>
 #include <mutex>
+#include <unordered_map>
 
 #include "Common/Profiler/Profiler.h"
 
@@ -57,14 +59,48 @@ struct BaseEvent {
 
 typedef LinkedListItem<BaseEvent> Event;
 
-Event *first;
+// Pending events are kept in a binary min-heap, ordered by time and then by the order they were
+// scheduled in, which is the same order the sorted list used to keep.  The heap holds indices
+// into queuedEvents, so that unscheduling can find events by type and userdata without a scan.
+struct QueuedEvent {
+	s64 time;
+	u64 userdata;
+	int type;
+	int heapIndex;
+	u64 order;
+};
+
+struct EventKey {
+	int type;
+	u64 userdata;
+
+	bool operator ==(const EventKey &other) const {
+		return type == other.type && userdata == other.userdata;
+	}
+};
+
+struct EventKeyHash {
+	size_t operator ()(const EventKey &key) const {
+		return std::hash<u64>()(key.userdata ^ ((u64)key.type << 48));
+	}
+};
+
+static std::vector<QueuedEvent> queuedEvents;
+static std::vector<int> freeEventIds;
+static std::vector<int> eventHeap;
+static std::unordered_multimap<EventKey, int, EventKeyHash> eventsByKey;
+static std::vector<int> eventTypeCounts;
+static u64 nextEventOrder;
+
+// Threadsafe events are pushed here by any thread without locking, so it's newest first.
+// The CPU thread takes the whole list at once and appends it to tsFirst.
+static std::atomic<Event *> tsIncoming;
+// Threadsafe events in the order they were scheduled.  Pushing never takes tsLock, but anything
+// that takes from tsIncoming or touches these must hold it.
+static std::mutex tsLock;
 Event *tsFirst;
 Event *tsLast;
 
-// event pools
-Event *eventPool = 0;
-Event *eventTsPool = 0;
-int allocatedTsEvents = 0;
 // Optimization to skip MoveEvents when possible.
 std::atomic<u32> hasTsEvents;
 
@@ -77,8 +113,6 @@ s64 idledCycles;
 s64 lastGlobalTimeTicks;
 s64 lastGlobalTimeUs;
 
-static std::mutex externalEventLock;
-
 std::vector<MHzChangeCallback> mhzChangeCallbacks;
 
 void FireMhzChange() {
@@ -125,39 +159,143 @@ u64 GetGlobalTimeUs() {
 	return lastGlobalTimeUs + usSinceLast;
 }
 
-Event* GetNewEvent()
+// These may be called from any thread, so there's no pool to share.
+Event* GetNewTsEvent()
 {
-	if(!eventPool)
-		return new Event;
+	return new Event;
+}
 
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
+void FreeTsEvent(Event* ev)
+{
+	delete ev;
 }
 
-Event* GetNewTsEvent()
+// Moves everything pushed by other threads onto the end of tsFirst.  Must hold tsLock.
+static void TakeIncomingTsEvents()
 {
-	allocatedTsEvents++;
+	Event *ev = tsIncoming.exchange(nullptr, std::memory_order_acquire);
+	if (!ev)
+		return;
+
+	// Reverse back into the order they were scheduled in.
+	Event *first = nullptr;
+	Event *last = ev;
+	while (ev) {
+		Event *next = ev->next;
+		ev->next = first;
+		first = ev;
+		ev = next;
+	}
 
-	if(!eventTsPool)
-		return new Event;
+	if (tsLast)
+		tsLast->next = first;
+	else
+		tsFirst = first;
+	tsLast = last;
+}
+
+static inline bool EventBefore(const QueuedEvent &a, const QueuedEvent &b) {
+	return a.time < b.time || (a.time == b.time && a.order < b.order);
+}
 
-	Event* ev = eventTsPool;
-	eventTsPool = ev->next;
-	return ev;
+static inline void PlaceInHeap(int pos, int id) {
+	eventHeap[pos] = id;
+	queuedEvents[id].heapIndex = pos;
 }
 
-void FreeEvent(Event* ev)
+static void SiftUp(int pos) {
+	const int id = eventHeap[pos];
+	while (pos > 0) {
+		int parent = (pos - 1) / 2;
+		if (!EventBefore(queuedEvents[id], queuedEvents[eventHeap[parent]]))
+			break;
+		PlaceInHeap(pos, eventHeap[parent]);
+		pos = parent;
+	}
+	PlaceInHeap(pos, id);
+}
+
+static void SiftDown(int pos) {
+	const int id = eventHeap[pos];
+	const int size = (int)eventHeap.size();
+	while (true) {
+		int child = pos * 2 + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && EventBefore(queuedEvents[eventHeap[child + 1]], queuedEvents[eventHeap[child]]))
+			child++;
+		if (!EventBefore(queuedEvents[eventHeap[child]], queuedEvents[id]))
+			break;
+		PlaceInHeap(pos, eventHeap[child]);
+		pos = child;
+	}
+	PlaceInHeap(pos, id);
+}
+
+static const QueuedEvent *FirstEvent() {
+	return eventHeap.empty() ? nullptr : &queuedEvents[eventHeap[0]];
+}
+
+static void AddEventToQueue(s64 time, int event_type, u64 userdata)
 {
-	ev->next = eventPool;
-	eventPool = ev;
+	int id;
+	if (freeEventIds.empty()) {
+		id = (int)queuedEvents.size();
+		queuedEvents.push_back(QueuedEvent{});
+	} else {
+		id = freeEventIds.back();
+		freeEventIds.pop_back();
+	}
+
+	QueuedEvent &ev = queuedEvents[id];
+	ev.time = time;
+	ev.userdata = userdata;
+	ev.type = event_type;
+	ev.order = nextEventOrder++;
+
+	eventsByKey.emplace(EventKey{ event_type, userdata }, id);
+	if (event_type >= (int)eventTypeCounts.size())
+		eventTypeCounts.resize(event_type + 1);
+	eventTypeCounts[event_type]++;
+
+	eventHeap.push_back(id);
+	SiftUp((int)eventHeap.size() - 1);
 }
 
-void FreeTsEvent(Event* ev)
+static void RemoveQueuedEvent(int id)
+{
+	const QueuedEvent &ev = queuedEvents[id];
+	auto range = eventsByKey.equal_range(EventKey{ ev.type, ev.userdata });
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == id) {
+			eventsByKey.erase(it);
+			break;
+		}
+	}
+	eventTypeCounts[ev.type]--;
+
+	const int pos = ev.heapIndex;
+	const int lastId = eventHeap.back();
+	eventHeap.pop_back();
+	if (lastId != id) {
+		PlaceInHeap(pos, lastId);
+		// The moved event may belong either above or below its new spot.
+		if (pos > 0 && EventBefore(queuedEvents[lastId], queuedEvents[eventHeap[(pos - 1) / 2]]))
+			SiftUp(pos);
+		else
+			SiftDown(pos);
+	}
+	freeEventIds.push_back(id);
+}
+
+// Returns the ids of pending events in the order they will run.
+static std::vector<int> SortedEventIds()
 {
-	ev->next = eventTsPool;
-	eventTsPool = ev;
-	allocatedTsEvents--;
+	std::vector<int> ids = eventHeap;
+	std::sort(ids.begin(), ids.end(), [](int a, int b) {
+		return EventBefore(queuedEvents[a], queuedEvents[b]);
+	});
+	return ids;
 }
 
 int RegisterEvent(const char *name, TimedCallback callback)
@@ -183,7 +321,7 @@ void RestoreRegisterEvent(int event_type, const char *name, TimedCallback callba
 
 void UnregisterAllEvents()
 {
-	_dbg_assert_msg_(first == nullptr, "Unregistering events with events pending - this isn't good.");
+	_dbg_assert_msg_(eventHeap.empty(), "Unregistering events with events pending - this isn't good.");
 	event_types.clear();
 }
 
@@ -205,21 +343,6 @@ void Shutdown()
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
-
-	while(eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
-
-	std::lock_guard<std::mutex> lk(externalEventLock);
-	while(eventTsPool)
-	{
-		Event *ev = eventTsPool;
-		eventTsPool = ev->next;
-		delete ev;
-	}
 }
 
 u64 GetTicks()
@@ -234,20 +357,20 @@ u64 GetIdleTicks()
 
 
 // This is to be called when outside threads, such as the graphics thread, wants to
-// schedule things to be executed on the main thread.
+// schedule things to be executed on the main thread.  It never blocks, and never makes
+// the CPU thread wait for the caller either.
 void ScheduleEvent_Threadsafe(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
-	std::lock_guard<std::mutex> lk(externalEventLock);
 	Event *ne = GetNewTsEvent();
 	ne->time = GetTicks() + cyclesIntoFuture;
 	ne->type = event_type;
-	ne->next = 0;
 	ne->userdata = userdata;
-	if(!tsFirst)
-		tsFirst = ne;
-	if(tsLast)
-		tsLast->next = ne;
-	tsLast = ne;
+
+	// Only the CPU thread ever takes from the list, and always all of it, so there's no ABA to worry about.
+	Event *head = tsIncoming.load(std::memory_order_relaxed);
+	do {
+		ne->next = head;
+	} while (!tsIncoming.compare_exchange_weak(head, ne, std::memory_order_release, std::memory_order_relaxed));
 
 	hasTsEvents.store(1, std::memory_order::memory_order_release);
 }
@@ -258,7 +381,6 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 {
 	if(false) //Core::IsCPUThread())
 	{
-		std::lock_guard<std::mutex> lk(externalEventLock);
 		event_types[event_type].callback(userdata, 0);
 	}
 	else
@@ -267,30 +389,11 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
-}
-
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = NULL;
-	Event** pNext = &first;
-	for(;;)
-	{
-		Event*& next = *pNext;
-		if(!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	queuedEvents.clear();
+	freeEventIds.clear();
+	eventHeap.clear();
+	eventsByKey.clear();
+	eventTypeCounts.clear();
 }
 
 // This must be run ONLY from within the cpu thread
@@ -298,62 +401,43 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = GetTicks() + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	AddEventToQueue(GetTicks() + cyclesIntoFuture, event_type, userdata);
 }
 
 // Returns cycles left in timer.
 s64 UnscheduleEvent(int event_type, u64 userdata)
 {
-	s64 result = 0;
-	if (!first)
-		return result;
-	while(first)
-	{
-		if (first->type == event_type && first->userdata == userdata)
-		{
-			result = first->time - GetTicks();
-
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
+	const EventKey key{ event_type, userdata };
+	auto range = eventsByKey.equal_range(key);
+	if (range.first == range.second)
+		return 0;
+
+	// Usually just one, but if there are several, report the last to run like we always have.
+	QueuedEvent last = queuedEvents[range.first->second];
+	while (range.first != range.second) {
+		// Collect a batch first, since removing invalidates the iterators.
+		int matches[16];
+		int count = 0;
+		for (auto it = range.first; it != range.second && count < (int)ARRAY_SIZE(matches); ++it) {
+			const QueuedEvent &ev = queuedEvents[it->second];
+			if (EventBefore(last, ev))
+				last = ev;
+			matches[count++] = it->second;
 		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return result;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type && ptr->userdata == userdata)
-		{
-			result = ptr->time - GetTicks();
 
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+		for (int i = 0; i < count; ++i)
+			RemoveQueuedEvent(matches[i]);
+		range = eventsByKey.equal_range(key);
 	}
 
-	return result;
+	return last.time - GetTicks();
 }
 
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata)
 {
+	std::lock_guard<std::mutex> lk(tsLock);
 	s64 result = 0;
-	std::lock_guard<std::mutex> lk(externalEventLock);
+	TakeIncomingTsEvents();
 	if (!tsFirst)
 		return result;
 	while(tsFirst)
@@ -407,57 +491,28 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
-			return true;
-		e = e->next;
-	}
-	return false;
+	return event_type >= 0 && event_type < (int)eventTypeCounts.size() && eventTypeCounts[event_type] != 0;
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
+	if (!IsScheduled(event_type))
 		return;
-	while(first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+
+	// Collect first, since removing reorders the heap.
+	std::vector<int> matches;
+	for (int id : eventHeap) {
+		if (queuedEvents[id].type == event_type)
+			matches.push_back(id);
 	}
+	for (int id : matches)
+		RemoveQueuedEvent(id);
 }
 
 void RemoveThreadsafeEvent(int event_type)
 {
-	std::lock_guard<std::mutex> lk(externalEventLock);
+	std::lock_guard<std::mutex> lk(tsLock);
+	TakeIncomingTsEvents();
 	if (!tsFirst)
 	{
 		return;
@@ -509,16 +564,16 @@ void RemoveAllEvents(int event_type)
 //This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents()
 {
-	while (first)
+	while (const QueuedEvent *first = FirstEvent())
 	{
 		if (first->time <= (s64)GetTicks())
 		{
-//			LOG(CPU, "[Scheduler] %s		 (%lld, %lld) ",
-//				first->name ? first->name : "?", (u64)GetTicks(), (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-			FreeEvent(evt);
+			// The callback may schedule more events, so take it out of the queue first.
+			const s64 time = first->time;
+			const u64 userdata = first->userdata;
+			const int type = first->type;
+			RemoveQueuedEvent(eventHeap[0]);
+			event_types[type].callback(userdata, (int)(GetTicks() - time));
 		}
 		else
 		{
@@ -531,25 +586,17 @@ void MoveEvents()
 {
 	hasTsEvents.store(0, std::memory_order::memory_order_release);
 
-	std::lock_guard<std::mutex> lk(externalEventLock);
+	std::lock_guard<std::mutex> lk(tsLock);
+	TakeIncomingTsEvents();
 	// Move events from async queue into main queue
 	while (tsFirst)
 	{
 		Event *next = tsFirst->next;
-		AddEventToQueue(tsFirst);
+		AddEventToQueue(tsFirst->time, tsFirst->type, tsFirst->userdata);
+		FreeTsEvent(tsFirst);
 		tsFirst = next;
 	}
 	tsLast = NULL;
-
-	// Move free events to threadsafe pool
-	while(allocatedTsEvents > 0 && eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		ev->next = eventTsPool;
-		eventTsPool = ev;
-		allocatedTsEvents--;
-	}
 }
 
 void ForceCheck()
@@ -577,6 +624,7 @@ void Advance()
 		MoveEvents();
 	ProcessFifoWaitEvents();
 
+	const QueuedEvent *first = FirstEvent();
 	if (!first)
 	{
 		// This should never happen in PPSSPP.
@@ -601,11 +649,10 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
+	for (int id : SortedEventIds())
 	{
-		//INFO_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+		const QueuedEvent &ev = queuedEvents[id];
+		DEBUG_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", (long long)globalTimer, (long long)ev.time, ev.type);
 	}
 }
 
@@ -615,6 +662,7 @@ void Idle(int maxIdle)
 	if (maxIdle != 0 && cyclesDown > maxIdle)
 		cyclesDown = maxIdle;
 
+	const QueuedEvent *first = FirstEvent();
 	if (first && cyclesDown > 0)
 	{
 		int cyclesExecuted = slicelength - currentMIPS->downcount;
@@ -638,14 +686,13 @@ void Idle(int maxIdle)
 }
 
 std::string GetScheduledEventsSummary() {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr) {
+	for (int id : SortedEventIds()) {
+		const QueuedEvent *ptr = &queuedEvents[id];
 		unsigned int t = ptr->type;
 		if (t >= event_types.size()) {
 			_dbg_assert_msg_(false, "Invalid event type %d", t);
-			ptr = ptr->next;
 			continue;
 		}
 		const char *name = event_types[t].name;
@@ -654,7 +701,6 @@ std::string GetScheduledEventsSummary() {
 		char temp[512];
 		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ptr->time, (u32)(ptr->userdata >> 32), (u32)(ptr->userdata));
 		text += temp;
-		ptr = ptr->next;
 	}
 	return text;
 }
@@ -672,9 +718,42 @@ void Event_DoStateOld(PointerWrap &p, BaseEvent *ev)
 	Do(p, *ev);
 }
 
+// Same format as DoLinkedList(), which this used to be.
+static void DoEventQueue(PointerWrap &p, void (*doEvent)(PointerWrap &, BaseEvent *))
+{
+	if (p.mode == PointerWrap::MODE_READ) {
+		ClearPendingEvents();
+		while (true) {
+			u8 shouldExist = 0;
+			Do(p, shouldExist);
+			if (shouldExist != 1) {
+				if (shouldExist != 0) {
+					WARN_LOG(SAVESTATE, "Savestate failure: incorrect item marker %d", shouldExist);
+					p.SetError(p.ERROR_FAILURE);
+				}
+				break;
+			}
+			BaseEvent ev;
+			doEvent(p, &ev);
+			AddEventToQueue(ev.time, ev.type, ev.userdata);
+		}
+	} else {
+		for (int id : SortedEventIds()) {
+			const QueuedEvent &queued = queuedEvents[id];
+			BaseEvent ev{ queued.time, queued.userdata, queued.type };
+			u8 shouldExist = 1;
+			Do(p, shouldExist);
+			doEvent(p, &ev);
+		}
+		u8 shouldExist = 0;
+		Do(p, shouldExist);
+	}
+}
+
 void DoState(PointerWrap &p)
 {
-	std::lock_guard<std::mutex> lk(externalEventLock);
+	std::lock_guard<std::mutex> lk(tsLock);
+	TakeIncomingTsEvents();
 
 	auto s = p.Section("CoreTiming", 1, 3);
 	if (!s)
@@ -686,12 +765,14 @@ void DoState(PointerWrap &p)
 	event_types.resize(n, EventType{ AntiCrashCallback, "INVALID EVENT" });
 
 	if (s >= 3) {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoState>(p, first, (Event **) NULL);
+		DoEventQueue(p, &Event_DoState);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoState>(p, tsFirst, &tsLast);
 	} else {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoStateOld>(p, first, (Event **) NULL);
+		DoEventQueue(p, &Event_DoStateOld);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoStateOld>(p, tsFirst, &tsLast);
 	}
+	if (tsFirst)
+		hasTsEvents.store(1, std::memory_order_release);
 
 	Do(p, CPU_HZ);
 	Do(p, slicelength);
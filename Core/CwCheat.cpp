@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdint>
+#include <map>
 #include "Common/Data/Text/I18n.h"
 #include "Common/StringUtils.h"
 #include "Common/Serialize/Serializer.h"
@@ -387,6 +388,11 @@ void CWCheatEngine::ParseCheats() {
 	// TODO: Report errors.
 
 	cheats_ = parser.GetCheats();
+
+	ops_.clear();
+	pointerLines_.clear();
+	for (const CheatCode &cheat : cheats_)
+		CompileCheat(cheat);
 }
 
 u32 CWCheatEngine::GetAddress(u32 value) {
@@ -406,90 +412,6 @@ void CWCheatEngine::InvalidateICache(u32 addr, int size) {
 	currentMIPS->InvalidateICache(addr & ~3, size);
 }
 
-enum class CheatOp {
-	Invalid,
-	Noop,
-
-	Write,
-	Add,
-	Subtract,
-	Or,
-	And,
-	Xor,
-
-	MultiWrite,
-
-	CopyBytesFrom,
-	Vibration,
-	VibrationFromMemory,
-	PostShader,
-	PostShaderFromMemory,
-	Delay,
-
-	Assert,
-
-	IfEqual,
-	IfNotEqual,
-	IfLess,
-	IfGreater,
-
-	IfAddrEqual,
-	IfAddrNotEqual,
-	IfAddrLess,
-	IfAddrGreater,
-
-	IfPressed,
-	IfNotPressed,
-
-	CwCheatPointerCommands,
-};
-
-struct CheatOperation {
-	CheatOp op;
-	uint32_t addr;
-	int sz;
-	uint32_t val;
-
-	union {
-		struct {
-			uint32_t count;
-			uint32_t step;
-			uint32_t add;
-		} multiWrite;
-		struct {
-			uint32_t destAddr;
-		} copyBytesFrom;
-		struct {
-			uint32_t skip;
-		} ifTypes;
-		struct {
-			uint32_t skip;
-			uint32_t compareAddr;
-		} ifAddrTypes;
-		struct {
-			int offset;
-			int baseOffset;
-			int count;
-			int type;
-		} pointerCommands;
-		struct {
-			uint16_t vibrL;
-			uint16_t vibrR;
-			uint8_t vibrLTime;
-			uint8_t vibrRTime;
-		} vibrationValues;
-		struct {
-			union {
-				float f;
-				uint32_t u;
-			} value;
-			uint8_t shader;
-			uint8_t uniform;
-			uint8_t format;
-		} PostShaderUniform;
-	};
-};
-
 CheatOperation CWCheatEngine::InterpretNextCwCheat(const CheatCode &cheat, size_t &i) {
 	const CheatLine &line1 = cheat.lines[i++];
 	const uint32_t &arg = line1.part2;
@@ -790,9 +712,141 @@ CheatOperation CWCheatEngine::InterpretNextOp(const CheatCode &cheat, size_t &i)
 	return { CheatOp::Invalid };
 }
 
+static bool IsConditionalOp(CheatOp op) {
+	switch (op) {
+	case CheatOp::Assert:
+	case CheatOp::IfEqual:
+	case CheatOp::IfNotEqual:
+	case CheatOp::IfLess:
+	case CheatOp::IfGreater:
+	case CheatOp::IfAddrEqual:
+	case CheatOp::IfAddrNotEqual:
+	case CheatOp::IfAddrLess:
+	case CheatOp::IfAddrGreater:
+	case CheatOp::IfPressed:
+	case CheatOp::IfNotPressed:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Appends the cheat to ops_, with skips resolved to op indices.
+// A skip can land in the middle of a multi-line op, where the lines are read as different ops,
+// so each such entry point gets its own run of ops ending with a jump back.
+void CWCheatEngine::CompileCheat(const CheatCode &cheat) {
+	const size_t lineCount = cheat.lines.size();
+	std::map<size_t, uint32_t> lineOps;
+	// Ops with a skip target (as a line) still to resolve.
+	std::vector<std::pair<uint32_t, size_t>> fixups;
+	std::vector<size_t> entryPoints{ 0 };
+
+	while (!entryPoints.empty()) {
+		size_t i = entryPoints.back();
+		entryPoints.pop_back();
+		if (i >= lineCount || lineOps.count(i))
+			continue;
+
+		bool stopped = false;
+		while (i < lineCount && !lineOps.count(i)) {
+			const uint32_t index = (uint32_t)ops_.size();
+			lineOps[i] = index;
+
+			// InterpretNextOp moves i.
+			CheatOperation op = InterpretNextOp(cheat, i);
+			if (op.op == CheatOp::Invalid) {
+				// Stops the cheat, so nothing after it is reachable from here.
+				op = { CheatOp::Jump };
+				fixups.push_back(std::make_pair(index, lineCount));
+				ops_.push_back(op);
+				stopped = true;
+				break;
+			}
+
+			if (op.op == CheatOp::CwCheatPointerCommands && op.pointerCommands.count > 0) {
+				op.pointerCommands.firstLine = (uint32_t)pointerLines_.size();
+				pointerLines_.insert(pointerLines_.end(), cheat.lines.begin() + i, cheat.lines.begin() + i + op.pointerCommands.count);
+				i += op.pointerCommands.count;
+			} else if (op.op == CheatOp::Assert) {
+				fixups.push_back(std::make_pair(index, lineCount));
+			} else if (IsConditionalOp(op.op)) {
+				const uint32_t skip = op.op >= CheatOp::IfAddrEqual && op.op <= CheatOp::IfAddrGreater ? op.ifAddrTypes.skip : op.ifTypes.skip;
+				const size_t target = skip >= lineCount - i ? lineCount : i + skip;
+				fixups.push_back(std::make_pair(index, target));
+				entryPoints.push_back(target);
+			}
+			ops_.push_back(op);
+		}
+
+		if (!stopped) {
+			// Continue wherever this line is compiled, or at the end.
+			fixups.push_back(std::make_pair((uint32_t)ops_.size(), std::min(i, lineCount)));
+			ops_.push_back({ CheatOp::Jump });
+		}
+	}
+
+	const uint32_t end = (uint32_t)ops_.size();
+	for (const auto &fixup : fixups) {
+		const uint32_t target = fixup.second >= lineCount ? end : lineOps[fixup.second];
+		CheatOperation &op = ops_[fixup.first];
+		if (op.op >= CheatOp::IfAddrEqual && op.op <= CheatOp::IfAddrGreater)
+			op.ifAddrTypes.skip = target;
+		else
+			op.ifTypes.skip = target;
+	}
+}
+
+// Reading an address the jit has put an emuhack at would give the wrong value, so those are invalidated right away.
+void CWCheatEngine::InvalidateBeforeRead(u32 addr, u32 size) {
+	if (!MIPSComp::jit || size == 0)
+		return;
+	const u32 start = addr & ~3;
+	const u32 end = addr + (size - 1);
+	for (u32 a = start; a <= end && a >= start; a += 4) {
+		if (Memory::IsValidAddress(a) && MIPS_IS_RUNBLOCK(Memory::ReadUnchecked_U32(a))) {
+			InvalidateICache(addr, size);
+			return;
+		}
+	}
+}
+
+// Call before writing.  Writing only part of a word with an emuhack would corrupt it, so those are checked now.
+// Otherwise, it's fine to invalidate after the whole pass, merged into as few ranges as possible.
+void CWCheatEngine::InvalidateForWrite(u32 addr, u32 size) {
+	if (size == 0)
+		return;
+	if ((addr & 3) != 0)
+		InvalidateBeforeRead(addr, 1);
+	if (((addr + size) & 3) != 0)
+		InvalidateBeforeRead(addr + size - 1, 1);
+
+	const u32 start = addr & ~3;
+	const u32 end = (u32)std::min((u64)addr + size, (u64)0xFFFFFFFF);
+	pendingInvalidations_.push_back(std::make_pair(start, end));
+}
+
+void CWCheatEngine::FlushInvalidations() {
+	if (pendingInvalidations_.empty())
+		return;
+
+	std::sort(pendingInvalidations_.begin(), pendingInvalidations_.end());
+	u32 start = pendingInvalidations_[0].first;
+	u32 end = pendingInvalidations_[0].second;
+	for (const auto &range : pendingInvalidations_) {
+		if (range.first > end) {
+			InvalidateICache(start, end - start);
+			start = range.first;
+		}
+		end = std::max(end, range.second);
+	}
+	InvalidateICache(start, end - start);
+	pendingInvalidations_.clear();
+}
+
 void CWCheatEngine::ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t)) {
 	if (Memory::IsValidAddress(op.addr)) {
-		InvalidateICache(op.addr, 4);
+		InvalidateBeforeRead(op.addr, op.sz);
+		InvalidateForWrite(op.addr, op.sz);
 		if (op.sz == 1)
 			Memory::Write_U8((u8)oper(Memory::Read_U8(op.addr), op.val), op.addr);
 		else if (op.sz == 2)
@@ -804,7 +858,7 @@ void CWCheatEngine::ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper
 
 bool CWCheatEngine::TestIf(const CheatOperation &op, bool(*oper)(int, int)) {
 	if (Memory::IsValidAddress(op.addr)) {
-		InvalidateICache(op.addr, 4);
+		InvalidateBeforeRead(op.addr, op.sz);
 
 		int memoryValue = 0;
 		if (op.sz == 1)
@@ -821,7 +875,8 @@ bool CWCheatEngine::TestIf(const CheatOperation &op, bool(*oper)(int, int)) {
 
 bool CWCheatEngine::TestIfAddr(const CheatOperation &op, bool(*oper)(int, int)) {
 	if (Memory::IsValidAddress(op.addr)) {
-		InvalidateICache(op.addr, 4);
+		InvalidateBeforeRead(op.addr, op.sz);
+		InvalidateBeforeRead(op.ifAddrTypes.compareAddr, op.sz);
 
 		int memoryValue1 = 0;
 		int memoryValue2 = 0;
@@ -841,18 +896,23 @@ bool CWCheatEngine::TestIfAddr(const CheatOperation &op, bool(*oper)(int, int))
 	return false;
 }
 
-void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat, size_t &i) {
+// Returns the index of the op to run next, normally next.
+size_t CWCheatEngine::ExecuteOp(const CheatOperation &op, size_t next) {
 	switch (op.op) {
 	case CheatOp::Invalid:
-		i = cheat.lines.size();
+		// Compiled as a jump to the end of the cheat.
+		_assert_(false);
 		break;
 
 	case CheatOp::Noop:
 		break;
 
+	case CheatOp::Jump:
+		return op.ifTypes.skip;
+
 	case CheatOp::Write:
 		if (Memory::IsValidAddress(op.addr)) {
-			InvalidateICache(op.addr, 4);
+			InvalidateForWrite(op.addr, op.sz);
 			if (op.sz == 1)
 				Memory::Write_U8((u8)op.val, op.addr);
 			else if (op.sz == 2)
@@ -894,12 +954,14 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::MultiWrite:
 		if (Memory::IsValidAddress(op.addr)) {
-			InvalidateICache(op.addr, op.multiWrite.count * op.multiWrite.step + op.sz);
+			InvalidateForWrite(op.addr, op.multiWrite.count * op.multiWrite.step + op.sz);
 
 			uint32_t data = op.val;
 			uint32_t addr = op.addr;
 			for (uint32_t a = 0; a < op.multiWrite.count; a++) {
 				if (Memory::IsValidAddress(addr)) {
+					if (op.sz < 4)
+						InvalidateBeforeRead(addr, op.sz);
 					if (op.sz == 1)
 						Memory::Write_U8((u8)data, addr);
 					else if (op.sz == 2)
@@ -915,8 +977,8 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::CopyBytesFrom:
 		if (Memory::IsValidRange(op.addr, op.val) && Memory::IsValidRange(op.copyBytesFrom.destAddr, op.val)) {
-			InvalidateICache(op.addr, op.val);
-			InvalidateICache(op.copyBytesFrom.destAddr, op.val);
+			InvalidateBeforeRead(op.addr, op.val);
+			InvalidateForWrite(op.copyBytesFrom.destAddr, op.val);
 
 			Memory::MemcpyUnchecked(op.copyBytesFrom.destAddr, op.addr, op.val);
 		}
@@ -995,58 +1057,58 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 	case CheatOp::Assert:
 		if (Memory::IsValidAddress(op.addr)) {
-			InvalidateICache(op.addr, 4);
+			InvalidateBeforeRead(op.addr, 4);
 			if (Memory::Read_U32(op.addr) != op.val) {
-				i = cheat.lines.size();
+				return op.ifTypes.skip;
 			}
 		}
 		break;
 
 	case CheatOp::IfEqual:
 		if (!TestIf(op, [](int a, int b) { return a == b; })) {
-			i += (size_t)op.ifTypes.skip;
+			return op.ifTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfNotEqual:
 		if (!TestIf(op, [](int a, int b) { return a != b; })) {
-			i += (size_t)op.ifTypes.skip;
+			return op.ifTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfLess:
 		if (!TestIf(op, [](int a, int b) { return a < b; })) {
-			i += (size_t)op.ifTypes.skip;
+			return op.ifTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfGreater:
 		if (!TestIf(op, [](int a, int b) { return a > b; })) {
-			i += (size_t)op.ifTypes.skip;
+			return op.ifTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfAddrEqual:
 		if (!TestIfAddr(op, [](int a, int b) { return a == b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
+			return op.ifAddrTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfAddrNotEqual:
 		if (!TestIfAddr(op, [](int a, int b) { return a != b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
+			return op.ifAddrTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfAddrLess:
 		if (!TestIfAddr(op, [](int a, int b) { return a < b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
+			return op.ifAddrTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfAddrGreater:
 		if (!TestIfAddr(op, [](int a, int b) { return a > b; })) {
-			i += (size_t)op.ifAddrTypes.skip;
+			return op.ifAddrTypes.skip;
 		}
 		break;
 
@@ -1073,33 +1135,33 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 		// SCREEN	0x00400000
 		// NOTE		0x00800000
 		if ((__CtrlPeekButtons() & op.val) != op.val) {
-			i += (size_t)op.ifTypes.skip;
+			return op.ifTypes.skip;
 		}
 		break;
 
 	case CheatOp::IfNotPressed:
 		if ((__CtrlPeekButtons() & op.val) == op.val) {
-			i += (size_t)op.ifTypes.skip;
+			return op.ifTypes.skip;
 		}
 		break;
 
 	case CheatOp::CwCheatPointerCommands:
 		{
-			InvalidateICache(op.addr + op.pointerCommands.baseOffset, 4);
+			InvalidateBeforeRead(op.addr + op.pointerCommands.baseOffset, 4);
 			u32 base = Memory::Read_U32(op.addr + op.pointerCommands.baseOffset);
 			u32 val = op.val;
 			int type = op.pointerCommands.type;
 			for (int a = 0; a < op.pointerCommands.count; ++a) {
-				const CheatLine &line = cheat.lines[i++];
+				const CheatLine &line = pointerLines_[op.pointerCommands.firstLine + a];
 				switch (line.part1 >> 28) {
 				case 0x1: // type copy byte
 					{
-						InvalidateICache(op.addr, 4);
+						InvalidateBeforeRead(op.addr, 4);
 						u32 srcAddr = Memory::Read_U32(op.addr) + op.pointerCommands.offset;
 						u32 dstAddr = Memory::Read_U32(op.addr + op.pointerCommands.baseOffset) + (line.part1 & 0x0FFFFFFF);
 						if (Memory::IsValidRange(dstAddr, val) && Memory::IsValidRange(srcAddr, val)) {
-							InvalidateICache(dstAddr, val);
-							InvalidateICache(srcAddr, val);
+							InvalidateBeforeRead(srcAddr, val);
+							InvalidateForWrite(dstAddr, val);
 							Memory::MemcpyUnchecked(dstAddr, srcAddr, val);
 						}
 						// Don't perform any further action.
@@ -1114,7 +1176,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 						if ((line.part1 >> 28) == 0x3) {
 							walkOffset = -walkOffset;
 						}
-						InvalidateICache(base + walkOffset, 4);
+						InvalidateBeforeRead(base + walkOffset, 4);
 						base = Memory::Read_U32(base + walkOffset);
 						switch (line.part2 >> 28) {
 						case 0x2:
@@ -1123,7 +1185,7 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 							if ((line.part2 >> 28) == 0x3) {
 								walkOffset = -walkOffset;
 							}
-							InvalidateICache(base + walkOffset, 4);
+							InvalidateBeforeRead(base + walkOffset, 4);
 							base = Memory::Read_U32(base + walkOffset);
 							break;
 
@@ -1147,27 +1209,27 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 
 			switch (type) {
 			case 0: // 8 bit write
-				InvalidateICache(base + op.pointerCommands.offset, 4);
+				InvalidateForWrite(base + op.pointerCommands.offset, 1);
 				Memory::Write_U8((u8)val, base + op.pointerCommands.offset);
 				break;
 			case 1: // 16-bit write
-				InvalidateICache(base + op.pointerCommands.offset, 4);
+				InvalidateForWrite(base + op.pointerCommands.offset, 2);
 				Memory::Write_U16((u16)val, base + op.pointerCommands.offset);
 				break;
 			case 2: // 32-bit write
-				InvalidateICache(base + op.pointerCommands.offset, 4);
+				InvalidateForWrite(base + op.pointerCommands.offset, 4);
 				Memory::Write_U32((u32)val, base + op.pointerCommands.offset);
 				break;
 			case 3: // 8 bit inverse write
-				InvalidateICache(base - op.pointerCommands.offset, 4);
+				InvalidateForWrite(base - op.pointerCommands.offset, 1);
 				Memory::Write_U8((u8)val, base - op.pointerCommands.offset);
 				break;
 			case 4: // 16-bit inverse write
-				InvalidateICache(base - op.pointerCommands.offset, 4);
+				InvalidateForWrite(base - op.pointerCommands.offset, 2);
 				Memory::Write_U16((u16)val, base - op.pointerCommands.offset);
 				break;
 			case 5: // 32-bit inverse write
-				InvalidateICache(base - op.pointerCommands.offset, 4);
+				InvalidateForWrite(base - op.pointerCommands.offset, 4);
 				Memory::Write_U32((u32)val, base - op.pointerCommands.offset);
 				break;
 			case -1: // Operation already performed, nothing to do
@@ -1179,16 +1241,15 @@ void CWCheatEngine::ExecuteOp(const CheatOperation &op, const CheatCode &cheat,
 	default:
 		_assert_(false);
 	}
+	return next;
 }
 
 void CWCheatEngine::Run() {
-	for (CheatCode cheat : cheats_) {
-		// InterpretNextOp and ExecuteOp move i.
-		for (size_t i = 0; i < cheat.lines.size(); ) {
-			CheatOperation op = InterpretNextOp(cheat, i);
-			ExecuteOp(op, cheat, i);
-		}
+	// ExecuteOp returns where to continue.
+	for (size_t i = 0; i < ops_.size(); ) {
+		i = ExecuteOp(ops_[i], i + 1);
 	}
+	FlushInvalidations();
 }
 
 bool CWCheatEngine::HasCheats() {
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <string>
+#include <utility>
 #include <vector>
 #include <iostream>
 #include <sstream>
@@ -41,7 +42,92 @@ struct CheatFileInfo {
 	bool enabled;
 };
 
-struct CheatOperation;
+enum class CheatOp {
+	Invalid,
+	Noop,
+	// Only in compiled cheats, continues at ifTypes.skip.
+	Jump,
+
+	Write,
+	Add,
+	Subtract,
+	Or,
+	And,
+	Xor,
+
+	MultiWrite,
+
+	CopyBytesFrom,
+	Vibration,
+	VibrationFromMemory,
+	PostShader,
+	PostShaderFromMemory,
+	Delay,
+
+	Assert,
+
+	IfEqual,
+	IfNotEqual,
+	IfLess,
+	IfGreater,
+
+	IfAddrEqual,
+	IfAddrNotEqual,
+	IfAddrLess,
+	IfAddrGreater,
+
+	IfPressed,
+	IfNotPressed,
+
+	CwCheatPointerCommands,
+};
+
+struct CheatOperation {
+	CheatOp op;
+	uint32_t addr;
+	int sz;
+	uint32_t val;
+
+	union {
+		struct {
+			uint32_t count;
+			uint32_t step;
+			uint32_t add;
+		} multiWrite;
+		struct {
+			uint32_t destAddr;
+		} copyBytesFrom;
+		struct {
+			uint32_t skip;
+		} ifTypes;
+		struct {
+			uint32_t skip;
+			uint32_t compareAddr;
+		} ifAddrTypes;
+		struct {
+			int offset;
+			int baseOffset;
+			int count;
+			int type;
+			uint32_t firstLine;
+		} pointerCommands;
+		struct {
+			uint16_t vibrL;
+			uint16_t vibrR;
+			uint8_t vibrLTime;
+			uint8_t vibrRTime;
+		} vibrationValues;
+		struct {
+			union {
+				float f;
+				uint32_t u;
+			} value;
+			uint8_t shader;
+			uint8_t uniform;
+			uint8_t format;
+		} PostShaderUniform;
+	};
+};
 
 class CWCheatEngine {
 public:
@@ -59,13 +145,24 @@ class CWCheatEngine {
 	CheatOperation InterpretNextOp(const CheatCode &cheat, size_t &i);
 	CheatOperation InterpretNextCwCheat(const CheatCode &cheat, size_t &i);
 	CheatOperation InterpretNextTempAR(const CheatCode &cheat, size_t &i);
+	void CompileCheat(const CheatCode &cheat);
 
-	void ExecuteOp(const CheatOperation &op, const CheatCode &cheat, size_t &i);
+	size_t ExecuteOp(const CheatOperation &op, size_t next);
 	void ApplyMemoryOperator(const CheatOperation &op, uint32_t(*oper)(uint32_t, uint32_t));
 	bool TestIf(const CheatOperation &op, bool(*oper)(int a, int b));
 	bool TestIfAddr(const CheatOperation &op, bool(*oper)(int a, int b));
 
+	void InvalidateBeforeRead(u32 addr, u32 size);
+	void InvalidateForWrite(u32 addr, u32 size);
+	void FlushInvalidations();
+
 	std::vector<CheatCode> cheats_;
+	// All cheats compiled back to back by ParseCheats(), so Run() is a single pass.
+	std::vector<CheatOperation> ops_;
+	// Extra lines read by pointer commands.
+	std::vector<CheatLine> pointerLines_;
+	// Start and end of ranges written during Run(), invalidated together at the end.
+	std::vector<std::pair<u32, u32>> pendingInvalidations_;
 	std::string gameID_;
 	std::string filename_;
 };
@@ -16,6 +16,11 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <vector>
 #ifndef USING_QT_UI
 #include <png.h>
 #include <zlib.h>
@@ -26,18 +31,90 @@
 #include "Core/Debugger/WebSocket/WebSocketUtils.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/Screenshot.h"
+#include "GPU/GPU.h"
+#include "GPU/Debugger/Debugger.h"
 #include "GPU/Debugger/Stepping.h"
 
+struct BufferStreamFrame {
+	std::vector<u8> data;
+	u32 width = 0;
+	u32 height = 0;
+	u32 pixelSize = 0;
+	GPUDebugBufferFormat format = GPU_DBG_FORMAT_INVALID;
+	bool flipped = false;
+	int flipNum = 0;
+};
+
+struct WebSocketGPUBufferState : public DebuggerSubscriber {
+	~WebSocketGPUBufferState() override;
+	void Subscribe(DebuggerRequest &req);
+	void Unsubscribe(DebuggerRequest &req);
+
+	void Broadcast(net::WebSocketServer *ws) override;
+
+	// Called on the emu thread at the start of each frame.
+	void CaptureFrame();
+
+protected:
+	void SendFrame(net::WebSocketServer *ws, const BufferStreamFrame &frame, int dropped);
+	void StopStream();
+
+	// Protects the settings and the pending queue, shared with the emu thread.
+	std::mutex lock_;
+	bool delta_ = true;
+	int skip_ = 0;
+	int skipCounter_ = 0;
+	int maxRes_ = 1;
+	size_t maxPending_ = 2;
+	std::deque<BufferStreamFrame> pending_;
+	int dropped_ = 0;
+
+	// Only used on the debugger thread.
+	bool streaming_ = false;
+	u32 tileSize_ = 16;
+	BufferStreamFrame last_;
+	bool hasLast_ = false;
+	std::vector<u8> packet_;
+};
+
+// Streams are captured from the emu thread, so they register here while active.
+static std::mutex streamsLock;
+static std::vector<WebSocketGPUBufferState *> streams;
+
+static void CaptureStreamFrames() {
+	std::lock_guard<std::mutex> guard(streamsLock);
+	for (auto stream : streams) {
+		stream->CaptureFrame();
+	}
+}
+
 DebuggerSubscriber *WebSocketGPUBufferInit(DebuggerEventHandlerMap &map) {
-	// No need to bind or alloc state, these are all global.
+	auto p = new WebSocketGPUBufferState();
 	map["gpu.buffer.screenshot"] = &WebSocketGPUBufferScreenshot;
 	map["gpu.buffer.renderColor"] = &WebSocketGPUBufferRenderColor;
 	map["gpu.buffer.renderDepth"] = &WebSocketGPUBufferRenderDepth;
 	map["gpu.buffer.renderStencil"] = &WebSocketGPUBufferRenderStencil;
 	map["gpu.buffer.texture"] = &WebSocketGPUBufferTexture;
 	map["gpu.buffer.clut"] = &WebSocketGPUBufferClut;
+	map["gpu.buffer.subscribe"] = std::bind(&WebSocketGPUBufferState::Subscribe, p, std::placeholders::_1);
+	map["gpu.buffer.unsubscribe"] = std::bind(&WebSocketGPUBufferState::Unsubscribe, p, std::placeholders::_1);
+
+	return p;
+}
+
+WebSocketGPUBufferState::~WebSocketGPUBufferState() {
+	StopStream();
+}
 
-	return nullptr;
+void WebSocketGPUBufferState::StopStream() {
+	if (!streaming_)
+		return;
+
+	std::lock_guard<std::mutex> guard(streamsLock);
+	streams.erase(std::remove(streams.begin(), streams.end(), this), streams.end());
+	if (streams.empty())
+		GPUDebug::SetBeginFrameListener(nullptr);
+	streaming_ = false;
 }
 
 // Note: Calls req.Respond().  Other data can be added afterward.
@@ -395,3 +472,223 @@ void WebSocketGPUBufferClut(DebuggerRequest &req) {
 		return GPUStepping::GPU_GetCurrentClut(buf);
 	});
 }
+
+// Stream the display buffer every frame (gpu.buffer.subscribe)
+//
+// Parameters:
+//  - encoding: either 'delta' (default) or 'raw'.
+//  - skip: number of frames to skip between each sent frame, default 0.
+//  - maxPending: frames to queue while the connection is busy, default 2.  Oldest are dropped first.
+//  - maxRes: render resolution multiplier to read back at, default 1 (native PSP size.)
+//  - tileSize: pixel width and height of tiles for 'delta', default 16.
+//
+// Response (same event name) with no extra data.
+//
+// After this, each captured frame is sent as a gpu.buffer.frame event:
+//  - flip: numeric flip counter of the captured frame.
+//  - width: numeric width of the buffer (also stride, in pixels, of binary data.)
+//  - height: numeric height of the buffer.
+//  - flipped: boolean to indicate whether buffer is vertically flipped.
+//  - format: string indicating format, such as 'R8G8B8A8_UNORM' or 'B8G8R8A8_UNORM'.
+//  - encoding: 'raw' for a full buffer, or 'delta' for changed tiles since the last sent frame.
+//  - tileSize: pixel size of tiles (only for 'delta'.)
+//  - tiles: number of changed tiles (only for 'delta'.)
+//  - dropped: number of frames dropped since the last sent frame, due to backpressure.
+//
+// Unless it's a 'delta' with 0 tiles, a binary message immediately follows with the pixel data.
+// For 'raw', it's the whole buffer.  For 'delta', each tile is a little endian u16 tile x and
+// u16 tile y (in tiles), followed by its rows of pixels, clipped at the right and bottom edges.
+// Apply these on top of the previous frame.  Encoding happens on the debugger thread.
+void WebSocketGPUBufferState::Subscribe(DebuggerRequest &req) {
+	if (!gpuDebug)
+		return req.Fail("GPU not started");
+
+	std::string encoding = "delta";
+	if (!req.ParamString("encoding", &encoding, DebuggerParamType::OPTIONAL))
+		return;
+	if (encoding != "delta" && encoding != "raw")
+		return req.Fail("Parameter 'encoding' must be either 'delta' or 'raw'");
+	u32 skip = 0;
+	if (!req.ParamU32("skip", &skip, false, DebuggerParamType::OPTIONAL))
+		return;
+	u32 maxPending = 2;
+	if (!req.ParamU32("maxPending", &maxPending, false, DebuggerParamType::OPTIONAL))
+		return;
+	if (maxPending < 1)
+		return req.Fail("Parameter 'maxPending' must be at least 1");
+	u32 maxRes = 1;
+	if (!req.ParamU32("maxRes", &maxRes, false, DebuggerParamType::OPTIONAL))
+		return;
+	u32 tileSize = 16;
+	if (!req.ParamU32("tileSize", &tileSize, false, DebuggerParamType::OPTIONAL))
+		return;
+	if (tileSize < 4 || tileSize > 256)
+		return req.Fail("Parameter 'tileSize' must be between 4 and 256");
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		delta_ = encoding == "delta";
+		skip_ = (int)skip;
+		skipCounter_ = 0;
+		maxRes_ = (int)maxRes;
+		maxPending_ = maxPending;
+		pending_.clear();
+		dropped_ = 0;
+	}
+	tileSize_ = tileSize;
+	// Start over with a full frame.
+	hasLast_ = false;
+
+	if (!streaming_) {
+		std::lock_guard<std::mutex> guard(streamsLock);
+		streams.push_back(this);
+		GPUDebug::SetBeginFrameListener(&CaptureStreamFrames);
+		streaming_ = true;
+	}
+
+	req.Respond();
+}
+
+// Stop streaming the display buffer (gpu.buffer.unsubscribe)
+//
+// No parameters.
+//
+// Response (same event name) with no extra data.
+void WebSocketGPUBufferState::Unsubscribe(DebuggerRequest &req) {
+	StopStream();
+
+	std::lock_guard<std::mutex> guard(lock_);
+	pending_.clear();
+	hasLast_ = false;
+	last_.data.clear();
+
+	req.Respond();
+}
+
+void WebSocketGPUBufferState::CaptureFrame() {
+	int maxRes;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		if (skipCounter_ > 0) {
+			skipCounter_--;
+			return;
+		}
+		skipCounter_ = skip_;
+		maxRes = maxRes_;
+	}
+
+	GPUDebugBuffer buf;
+	if (!gpuDebug || !gpuDebug->GetCurrentFramebuffer(buf, GPU_DBG_FRAMEBUF_DISPLAY, maxRes))
+		return;
+	if (!buf.GetData() || buf.GetStride() == 0 || buf.GetHeight() == 0)
+		return;
+
+	// The buffer may point directly at PSP RAM, so we always copy here and leave the rest for later.
+	BufferStreamFrame frame;
+	frame.width = buf.GetStride();
+	frame.height = buf.GetHeight();
+	frame.pixelSize = buf.GetPixelSize();
+	frame.format = buf.GetFormat();
+	frame.flipped = buf.GetFlipped();
+	frame.flipNum = gpuStats.numFlips;
+	frame.data.assign(buf.GetData(), buf.GetData() + frame.width * frame.height * frame.pixelSize);
+
+	std::lock_guard<std::mutex> guard(lock_);
+	while (pending_.size() >= maxPending_) {
+		pending_.pop_front();
+		dropped_++;
+	}
+	pending_.push_back(std::move(frame));
+}
+
+void WebSocketGPUBufferState::Broadcast(net::WebSocketServer *ws) {
+	if (!streaming_)
+		return;
+
+	// Let the socket catch up before sending more, the queue will drop frames meanwhile.
+	while (ws->BufferedBytes() <= last_.data.size()) {
+		BufferStreamFrame frame;
+		int dropped;
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			if (pending_.empty())
+				return;
+			frame = std::move(pending_.front());
+			pending_.pop_front();
+			dropped = dropped_;
+			dropped_ = 0;
+		}
+
+		SendFrame(ws, frame, dropped);
+		last_ = std::move(frame);
+		hasLast_ = true;
+	}
+}
+
+void WebSocketGPUBufferState::SendFrame(net::WebSocketServer *ws, const BufferStreamFrame &frame, int dropped) {
+	const u32 w = frame.width;
+	const u32 h = frame.height;
+	const u32 bpp = frame.pixelSize;
+	const size_t rowBytes = w * bpp;
+
+	bool delta = delta_ && hasLast_ && last_.width == w && last_.height == h && last_.format == frame.format && last_.flipped == frame.flipped;
+	int tiles = 0;
+	if (delta) {
+		packet_.clear();
+		const u32 tilesW = (w + tileSize_ - 1) / tileSize_;
+		const u32 tilesH = (h + tileSize_ - 1) / tileSize_;
+		for (u32 ty = 0; ty < tilesH; ++ty) {
+			const u32 y0 = ty * tileSize_;
+			const u32 rows = std::min(tileSize_, h - y0);
+			for (u32 tx = 0; tx < tilesW; ++tx) {
+				const size_t offset = tx * tileSize_ * bpp;
+				const size_t tileRowBytes = std::min(tileSize_, w - tx * tileSize_) * bpp;
+
+				bool changed = false;
+				for (u32 y = y0; y < y0 + rows && !changed; ++y) {
+					size_t pos = y * rowBytes + offset;
+					changed = memcmp(&frame.data[pos], &last_.data[pos], tileRowBytes) != 0;
+				}
+				if (!changed)
+					continue;
+
+				const u8 header[4] = { (u8)(tx & 0xFF), (u8)(tx >> 8), (u8)(ty & 0xFF), (u8)(ty >> 8) };
+				packet_.insert(packet_.end(), header, header + sizeof(header));
+				for (u32 y = y0; y < y0 + rows; ++y) {
+					const u8 *src = &frame.data[y * rowBytes + offset];
+					packet_.insert(packet_.end(), src, src + tileRowBytes);
+				}
+				tiles++;
+			}
+
+			// Once most of the screen changed, the full buffer is cheaper.
+			if (packet_.size() >= frame.data.size()) {
+				delta = false;
+				break;
+			}
+		}
+	}
+
+	JsonWriter j;
+	j.begin();
+	j.writeString("event", "gpu.buffer.frame");
+	j.writeInt("flip", frame.flipNum);
+	j.writeInt("width", w);
+	j.writeInt("height", h);
+	j.writeBool("flipped", frame.flipped);
+	j.writeString("format", DescribeFormat(frame.format));
+	j.writeString("encoding", delta ? "delta" : "raw");
+	if (delta) {
+		j.writeInt("tileSize", tileSize_);
+		j.writeInt("tiles", tiles);
+	}
+	j.writeInt("dropped", dropped);
+	j.end();
+	ws->Send(j.str());
+
+	if (!delta) {
+		ws->Send(frame.data);
+	} else if (tiles != 0) {
+		ws->Send(packet_);
+	}
+}
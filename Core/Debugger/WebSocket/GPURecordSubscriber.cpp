@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <climits>
+
 #include "Common/Data/Encoding/Base64.h"
 #include "Common/File/FileUtil.h"
 #include "Core/Debugger/WebSocket/GPURecordSubscriber.h"
@@ -25,6 +27,7 @@
 struct WebSocketGPURecordState : public DebuggerSubscriber {
 	~WebSocketGPURecordState() override;
 	void Dump(DebuggerRequest &req);
+	void Stop(DebuggerRequest &req);
 
 	void Broadcast(net::WebSocketServer *ws) override;
 
@@ -37,6 +40,7 @@ struct WebSocketGPURecordState : public DebuggerSubscriber {
 DebuggerSubscriber *WebSocketGPURecordInit(DebuggerEventHandlerMap &map) {
 	auto p = new WebSocketGPURecordState();
 	map["gpu.record.dump"] = std::bind(&WebSocketGPURecordState::Dump, p, std::placeholders::_1);
+	map["gpu.record.stop"] = std::bind(&WebSocketGPURecordState::Stop, p, std::placeholders::_1);
 
 	return p;
 }
@@ -49,7 +53,9 @@ WebSocketGPURecordState::~WebSocketGPURecordState() {
 
 // Begin recording (gpu.record.dump)
 //
-// No parameters.
+// Parameters:
+//  - frames: optional number of frames to record, default 1.  Use 0 to record until gpu.record.stop.
+//    Values above 2147483647 are rejected.
 //
 // Response (same event name):
 //  - uri: data: URI containing debug dump data.
@@ -59,7 +65,14 @@ void WebSocketGPURecordState::Dump(DebuggerRequest &req) {
 	if (!PSP_IsInited())
 		return req.Fail("CPU not started");
 
-	if (!GPURecord::Activate())
+	uint32_t frames = 1;
+	if (!req.ParamU32("frames", &frames, false, DebuggerParamType::OPTIONAL))
+		return;
+	// These would turn negative, which would mean recording until stopped.
+	if (frames > INT_MAX)
+		return req.Fail("Invalid 'frames' parameter");
+
+	if (!GPURecord::ActivateFrames((int)frames))
 		return req.Fail("Recording already in progress");
 
 	pending_ = true;
@@ -72,6 +85,18 @@ void WebSocketGPURecordState::Dump(DebuggerRequest &req) {
 	lastTicket_ = value ? json_stringify(value) : "";
 }
 
+// Stop recording (gpu.record.stop)
+//
+// No parameters.
+//
+// No immediate response.  The gpu.record.dump response follows once the current frame ends.
+void WebSocketGPURecordState::Stop(DebuggerRequest &req) {
+	if (!pending_)
+		return req.Fail("Not recording");
+
+	GPURecord::Deactivate();
+}
+
 // This handles the asynchronous gpu.record.dump response.
 void WebSocketGPURecordState::Broadcast(net::WebSocketServer *ws) {
 	if (!lastFilename_.empty()) {
@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
@@ -25,6 +27,7 @@
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSStackWalk.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HLE/sceKernelThread.h"
 
 DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
@@ -37,6 +40,8 @@ DebuggerSubscriber *WebSocketHLEInit(DebuggerEventHandlerMap &map) {
 	map["hle.func.rename"] = &WebSocketHLEFuncRename;
 	map["hle.module.list"] = &WebSocketHLEModuleList;
 	map["hle.backtrace"] = &WebSocketHLEBacktrace;
+	map["hle.syscall.profile.enable"] = &WebSocketHLESyscallProfileEnable;
+	map["hle.syscall.profile.list"] = &WebSocketHLESyscallProfileList;
 
 	return nullptr;
 }
@@ -489,3 +494,58 @@ void WebSocketHLEBacktrace(DebuggerRequest &req) {
 	}
 	json.pop();
 }
+
+// Enable or disable counting calls and host time per syscall (hle.syscall.profile.enable)
+//
+// Parameters:
+//  - enabled: boolean, whether to count.  Counts so far are kept either way.
+//
+// Response (same event name):
+//  - enabled: boolean, the new state.
+void WebSocketHLESyscallProfileEnable(DebuggerRequest &req) {
+	bool enabled = false;
+	if (!req.ParamBool("enabled", &enabled))
+		return;
+
+	hleSetSyscallProfiling(enabled);
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", enabled);
+}
+
+// List syscalls by host time spent in them (hle.syscall.profile.list)
+//
+// Parameters:
+//  - reset: optional boolean, true to start counting over after listing.
+//
+// Response (same event name):
+//  - enabled: boolean, true if syscalls are being counted.
+//  - syscalls: array of objects, most expensive first, each with properties:
+//     - module: string name of HLE module.
+//     - name: string name of function.
+//     - nid: unsigned integer function id.
+//     - calls: unsigned integer number of calls since the game started or the last reset.
+//     - ms: number of host milliseconds spent, including any rescheduling afterward.
+void WebSocketHLESyscallProfileList(DebuggerRequest &req) {
+	bool reset = false;
+	if (!req.ParamBool("reset", &reset, DebuggerParamType::OPTIONAL))
+		return;
+
+	std::vector<HLESyscallProfile> profile = hleGetSyscallProfile();
+	if (reset)
+		hleResetSyscallProfile();
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", hleIsSyscallProfiling());
+	json.pushArray("syscalls");
+	for (const HLESyscallProfile &entry : profile) {
+		json.pushDict();
+		json.writeString("module", entry.module);
+		json.writeString("name", entry.func->name);
+		json.writeUint("nid", entry.func->ID);
+		json.writeUint("calls", (u32)std::min(entry.calls, (u64)0xFFFFFFFF));
+		json.writeFloat("ms", entry.seconds * 1000.0);
+		json.pop();
+	}
+	json.pop();
+}
@@ -30,3 +30,5 @@ void WebSocketHLEFuncRemove(DebuggerRequest &req);
 void WebSocketHLEFuncRename(DebuggerRequest &req);
 void WebSocketHLEModuleList(DebuggerRequest &req);
 void WebSocketHLEBacktrace(DebuggerRequest &req);
+void WebSocketHLESyscallProfileEnable(DebuggerRequest &req);
+void WebSocketHLESyscallProfileList(DebuggerRequest &req);
@@ -17,16 +17,85 @@
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "Common/Data/Encoding/Base64.h"
 #include "Common/StringUtils.h"
+#include "Core/Core.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/System.h"
 #include "Core/Debugger/WebSocket/MemorySubscriber.h"
 #include "Core/Debugger/WebSocket/WebSocketUtils.h"
+#include "Core/HLE/sceDisplay.h"
+#include "ext/xxhash.h"
+
+// Changes are detected (and sent) at this granularity.
+static const u32 WATCH_BLOCK_SIZE = 64;
+// Snapshots are copied on the emu thread each frame, so keep them reasonable.
+static const u32 WATCH_MAX_TOTAL_SIZE = 4 * 1024 * 1024;
+static const size_t WATCH_MAX_PENDING = 2;
+
+struct MemoryWatchRange {
+	u32 id;
+	u32 address;
+	u32 size;
+};
+
+struct MemoryWatchSnapshot {
+	int vblank = 0;
+	std::vector<MemoryWatchRange> ranges;
+	// Contents of each range, one after another.
+	std::vector<u8> data;
+};
+
+struct WebSocketMemoryState : public DebuggerSubscriber {
+	~WebSocketMemoryState() override;
+	void Watch(DebuggerRequest &req);
+	void Unwatch(DebuggerRequest &req);
+
+	void Broadcast(net::WebSocketServer *ws) override;
+
+	// Called on the emu thread at each vblank.
+	void Snapshot();
+
+protected:
+	void SendChanges(net::WebSocketServer *ws, const MemoryWatchSnapshot &snapshot, int dropped);
+	void UpdateRegistration();
+
+	// Protects ranges_ and the pending queue, shared with the emu thread.
+	std::mutex lock_;
+	std::vector<MemoryWatchRange> ranges_;
+	std::deque<MemoryWatchSnapshot> pending_;
+	int dropped_ = 0;
+
+	// Only used on the debugger thread.
+	bool registered_ = false;
+	u32 nextId_ = 1;
+	// Block hashes from the last sent snapshot, per watch id.
+	std::unordered_map<u32, std::vector<u64>> hashes_;
+	std::vector<u8> packet_;
+};
+
+// Watches are snapshotted from the emu thread, so they register here while active.
+static std::mutex watchersLock;
+static std::vector<WebSocketMemoryState *> watchers;
+
+static void SnapshotMemoryWatches() {
+	std::lock_guard<std::mutex> guard(watchersLock);
+	// We're on the emu thread, so memory can't go away during this.
+	if (watchers.empty() || !Memory::IsActive())
+		return;
+	for (auto watcher : watchers) {
+		watcher->Snapshot();
+	}
+}
 
 DebuggerSubscriber *WebSocketMemoryInit(DebuggerEventHandlerMap &map) {
-	// No need to bind or alloc state, these are all global.
+	auto p = new WebSocketMemoryState();
 	map["memory.read_u8"] = &WebSocketMemoryReadU8;
 	map["memory.read_u16"] = &WebSocketMemoryReadU16;
 	map["memory.read_u32"] = &WebSocketMemoryReadU32;
@@ -36,8 +105,35 @@ DebuggerSubscriber *WebSocketMemoryInit(DebuggerEventHandlerMap &map) {
 	map["memory.write_u16"] = &WebSocketMemoryWriteU16;
 	map["memory.write_u32"] = &WebSocketMemoryWriteU32;
 	map["memory.write"] = &WebSocketMemoryWrite;
+	map["memory.watch"] = std::bind(&WebSocketMemoryState::Watch, p, std::placeholders::_1);
+	map["memory.unwatch"] = std::bind(&WebSocketMemoryState::Unwatch, p, std::placeholders::_1);
+
+	return p;
+}
+
+WebSocketMemoryState::~WebSocketMemoryState() {
+	std::lock_guard<std::mutex> guard(watchersLock);
+	watchers.erase(std::remove(watchers.begin(), watchers.end(), this), watchers.end());
+}
+
+void WebSocketMemoryState::UpdateRegistration() {
+	bool wanted;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		wanted = !ranges_.empty();
+	}
+	if (wanted == registered_)
+		return;
 
-	return nullptr;
+	// Only registers once, afterward it's a cheap check when nothing is watched.
+	Core_ListenFrame(&SnapshotMemoryWatches);
+
+	std::lock_guard<std::mutex> guard(watchersLock);
+	if (wanted)
+		watchers.push_back(this);
+	else
+		watchers.erase(std::remove(watchers.begin(), watchers.end(), this), watchers.end());
+	registered_ = wanted;
 }
 
 // Read a byte from memory (memory.read_u8)
@@ -288,6 +384,7 @@ void WebSocketMemoryWriteU32(DebuggerRequest &req) {
 		return;
 	}
 	Memory::Write_U32(val, addr);
+	currentMIPS->InvalidateICache(addr, 4);
 
 	JsonWriter &json = req.Respond();
 	json.writeUint("value", Memory::Read_U32(addr));
@@ -321,5 +418,210 @@ void WebSocketMemoryWrite(DebuggerRequest &req) {
 		return req.Fail("Invalid size");
 
 	Memory::MemcpyUnchecked(addr, &value[0], size);
+	currentMIPS->InvalidateICache(addr, size);
+	req.Respond();
+}
+
+// Watch a range of memory for changes (memory.watch)
+//
+// Parameters:
+//  - address: unsigned integer address for the start of the memory range.
+//  - size: unsigned integer specifying size of memory range.
+//
+// Response (same event name):
+//  - id: unsigned integer to identify this watch in memory.changed and memory.unwatch.
+//
+// Afterward, watched ranges are snapshotted at each vblank.  When any changed, a memory.changed
+// event is sent:
+//  - vblank: numeric vblank counter the snapshot was taken at.
+//  - dropped: number of snapshots skipped since the last event because the connection was busy.
+//  - spans: array of objects, each with these properties:
+//     - id: unsigned integer watch id.
+//     - address: unsigned integer address for the start of the changed span.
+//     - size: unsigned integer size of the changed span.
+//
+// A binary message immediately follows with the new contents of each span, one after another.
+// Changes are detected in 64 byte blocks, so spans may include some unchanged bytes.  The first
+// event after a watch is added includes the entire range.
+void WebSocketMemoryState::Watch(DebuggerRequest &req) {
+	uint32_t addr;
+	if (!req.ParamU32("address", &addr))
+		return;
+	uint32_t size;
+	if (!req.ParamU32("size", &size))
+		return;
+
+	{
+		auto memLock = Memory::Lock();
+		if (!currentDebugMIPS->isAlive() || !Memory::IsActive())
+			return req.Fail("CPU not started");
+
+		if (!Memory::IsValidAddress(addr))
+			return req.Fail("Invalid address");
+		else if (size == 0 || !Memory::IsValidRange(addr, size))
+			return req.Fail("Invalid size");
+	}
+
+	u32 id;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		u32 total = size;
+		for (const auto &range : ranges_)
+			total += range.size;
+		if (total > WATCH_MAX_TOTAL_SIZE)
+			return req.Fail(StringFromFormat("Too much memory watched, limit is %d bytes", (int)WATCH_MAX_TOTAL_SIZE));
+
+		id = nextId_++;
+		ranges_.push_back({ id, addr, size });
+		// Older snapshots don't match the new set of ranges.
+		pending_.clear();
+	}
+	UpdateRegistration();
+
+	JsonWriter &json = req.Respond();
+	json.writeUint("id", id);
+}
+
+// Stop watching memory (memory.unwatch)
+//
+// Parameters:
+//  - id: optional unsigned integer from memory.watch, removes all watches if not specified.
+//
+// Response (same event name) with no extra data.
+void WebSocketMemoryState::Unwatch(DebuggerRequest &req) {
+	bool all = !req.HasParam("id");
+	uint32_t id = 0;
+	if (!req.ParamU32("id", &id, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		size_t before = ranges_.size();
+		ranges_.erase(std::remove_if(ranges_.begin(), ranges_.end(), [&](const MemoryWatchRange &range) {
+			return all || range.id == id;
+		}), ranges_.end());
+		if (!all && ranges_.size() == before)
+			return req.Fail("Watch not found");
+		pending_.clear();
+	}
+	if (all)
+		hashes_.clear();
+	else
+		hashes_.erase(id);
+	UpdateRegistration();
+
 	req.Respond();
 }
+
+void WebSocketMemoryState::Snapshot() {
+	std::lock_guard<std::mutex> guard(lock_);
+	if (ranges_.empty())
+		return;
+
+	// Just copy here, hashing and diffing happen on the debugger thread.
+	MemoryWatchSnapshot snapshot;
+	snapshot.vblank = __DisplayGetNumVblanks();
+	snapshot.ranges = ranges_;
+	size_t total = 0;
+	for (const auto &range : ranges_)
+		total += range.size;
+	snapshot.data.resize(total);
+
+	size_t pos = 0;
+	for (const auto &range : ranges_) {
+		Memory::MemcpyUnchecked(&snapshot.data[pos], range.address, range.size);
+		pos += range.size;
+	}
+
+	while (pending_.size() >= WATCH_MAX_PENDING) {
+		pending_.pop_front();
+		dropped_++;
+	}
+	pending_.push_back(std::move(snapshot));
+}
+
+void WebSocketMemoryState::Broadcast(net::WebSocketServer *ws) {
+	if (!registered_)
+		return;
+
+	while (true) {
+		MemoryWatchSnapshot snapshot;
+		int dropped;
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			if (pending_.empty())
+				return;
+			// Let the socket catch up, the queue will drop older snapshots meanwhile.
+			if (ws->BufferedBytes() > pending_.front().data.size())
+				return;
+			snapshot = std::move(pending_.front());
+			pending_.pop_front();
+			dropped = dropped_;
+			dropped_ = 0;
+		}
+
+		SendChanges(ws, snapshot, dropped);
+	}
+}
+
+void WebSocketMemoryState::SendChanges(net::WebSocketServer *ws, const MemoryWatchSnapshot &snapshot, int dropped) {
+	JsonWriter j;
+	j.begin();
+	j.writeString("event", "memory.changed");
+	j.writeInt("vblank", snapshot.vblank);
+	j.writeInt("dropped", dropped);
+	j.pushArray("spans");
+
+	packet_.clear();
+	size_t pos = 0;
+	for (const auto &range : snapshot.ranges) {
+		const u8 *data = &snapshot.data[pos];
+		pos += range.size;
+
+		const u32 blocks = (range.size + WATCH_BLOCK_SIZE - 1) / WATCH_BLOCK_SIZE;
+		std::vector<u64> &hashes = hashes_[range.id];
+		bool first = hashes.size() != blocks;
+		if (first)
+			hashes.resize(blocks);
+
+		u32 spanStart = 0;
+		u32 spanEnd = 0;
+		auto flushSpan = [&]() {
+			if (spanEnd == spanStart)
+				return;
+			j.pushDict();
+			j.writeUint("id", range.id);
+			j.writeUint("address", range.address + spanStart);
+			j.writeUint("size", spanEnd - spanStart);
+			j.pop();
+			packet_.insert(packet_.end(), data + spanStart, data + spanEnd);
+		};
+
+		for (u32 b = 0; b < blocks; ++b) {
+			const u32 offset = b * WATCH_BLOCK_SIZE;
+			const u32 len = std::min(WATCH_BLOCK_SIZE, range.size - offset);
+			u64 hash = XXH3_64bits(data + offset, len);
+			if (!first && hash == hashes[b])
+				continue;
+			hashes[b] = hash;
+
+			// Extend the current span if this block is right after it.
+			if (spanEnd != offset) {
+				flushSpan();
+				spanStart = offset;
+			}
+			spanEnd = offset + len;
+		}
+		flushSpan();
+	}
+
+	j.pop();
+	j.end();
+
+	// Nothing changed, nothing to send.
+	if (packet_.empty())
+		return;
+
+	ws->Send(j.str());
+	ws->Send(packet_);
+}
@@ -81,6 +81,8 @@ size_t CachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flag
 	if ((flags & Flags::HINT_UNCACHED) != 0) {
 		readSize = backend_->ReadAt(absolutePos, bytes, data, flags);
 	} else {
+		// If readahead is already fetching this, wait for it rather than fetching it again.
+		WaitForReadAhead(absolutePos, bytes);
 		readSize = ReadFromCache(absolutePos, bytes, data);
 		// While in case the cache size is too small for the entire read.
 		while (readSize < bytes) {
@@ -93,7 +95,7 @@ size_t CachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flag
 			}
 		}
 
-		StartReadAhead(absolutePos + readSize);
+		StartReadAhead(absolutePos, absolutePos + readSize);
 	}
 
 	return readSize;
@@ -107,13 +109,17 @@ void CachingFileLoader::InitCache() {
 
 void CachingFileLoader::ShutdownCache() {
 	// TODO: Maybe add some hint that deletion is coming soon?
-	// We can't delete while the thread is running, so have to wait.
+	// We can't delete while the threads are running, so have to wait for any current reads.
 	// This should only happen from the menu.
-	while (aheadThreadRunning_) {
-		sleep_ms(1);
+	{
+		std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
+		aheadShutdown_ = true;
+		aheadCond_.notify_all();
 	}
-	if (aheadThread_.joinable())
-		aheadThread_.join();
+	for (std::thread &thread : aheadThreads_) {
+		thread.join();
+	}
+	aheadThreads_.clear();
 
 	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
 	for (auto block : blocks_) {
@@ -252,36 +258,113 @@ bool CachingFileLoader::MakeCacheSpaceFor(size_t blocks, bool readingAhead) {
 	return true;
 }
 
-void CachingFileLoader::StartReadAhead(s64 pos) {
+void CachingFileLoader::StartReadAhead(s64 readPos, s64 readEnd) {
 	std::lock_guard<std::recursive_mutex> guard(blocksMutex_);
-	if (aheadThreadRunning_) {
-		// Already going.
-		return;
+	// Sequential reads get more and more readahead, anything else starts over.
+	if (readPos >= lastReadEnd_ && readPos <= lastReadEnd_ + BLOCK_SIZE) {
+		readAheadBlocks_ = std::min(readAheadBlocks_ * 2, (size_t)MAX_BLOCK_READAHEAD);
+	} else {
+		readAheadBlocks_ = BLOCK_READAHEAD;
 	}
-	if (cacheSize_ + BLOCK_READAHEAD > MAX_BLOCKS_CACHED) {
+	lastReadEnd_ = readEnd;
+
+	if (cacheSize_ + readAheadBlocks_ > MAX_BLOCKS_CACHED) {
 		// Not enough space to readahead.
 		return;
 	}
 
-	aheadThreadRunning_ = true;
-	if (aheadThread_.joinable())
-		aheadThread_.join();
-	aheadThread_ = std::thread([this, pos] {
-		setCurrentThreadName("FileLoaderReadAhead");
-
-		std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
-		s64 cacheStartPos = pos >> BLOCK_SHIFT;
-		s64 cacheEndPos = cacheStartPos + BLOCK_READAHEAD - 1;
-
-		for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
-			auto block = blocks_.find(i);
-			if (block == blocks_.end()) {
-				guard.unlock();
-				SaveIntoCache(i << BLOCK_SHIFT, BLOCK_SIZE * BLOCK_READAHEAD, Flags::NONE, true);
+	// Queue up runs of blocks not cached or already coming, to be fetched in parallel.
+	const s64 cacheStartPos = readEnd >> BLOCK_SHIFT;
+	const s64 cacheEndPos = std::min(cacheStartPos + (s64)readAheadBlocks_, (filesize_ + BLOCK_SIZE - 1) >> BLOCK_SHIFT);
+	s64 runStart = 0;
+	size_t runLength = 0;
+	bool queued = false;
+	auto queueRun = [&] {
+		if (runLength != 0) {
+			aheadQueue_.push_back(std::make_pair(runStart, runLength));
+			runLength = 0;
+			queued = true;
+		}
+	};
+	for (s64 i = cacheStartPos; i < cacheEndPos; ++i) {
+		if (blocks_.find(i) != blocks_.end() || aheadBlocks_.find(i) != aheadBlocks_.end()) {
+			queueRun();
+			continue;
+		}
+		if (runLength == 0) {
+			runStart = i;
+		}
+		aheadBlocks_.insert(i);
+		if (++runLength >= BLOCKS_PER_READAHEAD) {
+			queueRun();
+		}
+	}
+	queueRun();
+
+	if (!queued) {
+		return;
+	}
+	if (aheadThreads_.empty()) {
+		for (int i = 0; i < READAHEAD_THREADS; ++i) {
+			aheadThreads_.push_back(std::thread([this] {
+				ReadAheadThread();
+			}));
+		}
+	}
+	aheadCond_.notify_all();
+}
+
+void CachingFileLoader::WaitForReadAhead(s64 pos, size_t bytes) {
+	if (bytes == 0) {
+		return;
+	}
+
+	const s64 cacheStartPos = pos >> BLOCK_SHIFT;
+	const s64 cacheEndPos = (pos + bytes - 1) >> BLOCK_SHIFT;
+	std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
+	aheadCond_.wait(guard, [&] {
+		auto it = aheadBusyBlocks_.lower_bound(cacheStartPos);
+		return it == aheadBusyBlocks_.end() || *it > cacheEndPos;
+	});
+}
+
+void CachingFileLoader::ReadAheadThread() {
+	setCurrentThreadName("FileLoaderReadAhead");
+
+	std::unique_lock<std::recursive_mutex> guard(blocksMutex_);
+	while (true) {
+		aheadCond_.wait(guard, [this] {
+			return aheadShutdown_ || !aheadQueue_.empty();
+		});
+		if (aheadShutdown_) {
+			break;
+		}
+
+		const s64 cacheStartPos = aheadQueue_.front().first;
+		const s64 cacheEndPos = cacheStartPos + (s64)aheadQueue_.front().second;
+		aheadQueue_.pop_front();
+		for (s64 i = cacheStartPos; i < cacheEndPos; ++i) {
+			aheadBusyBlocks_.insert(i);
+		}
+
+		// The game might have read some of these itself meanwhile, so fill in around them.
+		for (s64 i = cacheStartPos; i < cacheEndPos; ++i) {
+			if (blocks_.find(i) != blocks_.end()) {
+				continue;
+			}
+			guard.unlock();
+			SaveIntoCache(i << BLOCK_SHIFT, (size_t)(cacheEndPos - i) << BLOCK_SHIFT, Flags::NONE, true);
+			guard.lock();
+			if (blocks_.find(i) == blocks_.end()) {
+				// Out of space or the read failed, leave the rest.
 				break;
 			}
 		}
 
-		aheadThreadRunning_ = false;
-	});
+		for (s64 i = cacheStartPos; i < cacheEndPos; ++i) {
+			aheadBlocks_.erase(i);
+			aheadBusyBlocks_.erase(i);
+		}
+		aheadCond_.notify_all();
+	}
 }
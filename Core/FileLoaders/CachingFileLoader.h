@@ -17,9 +17,13 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <mutex>
+#include <set>
 #include <thread>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Core/Loaders.h"
@@ -47,7 +51,9 @@ class CachingFileLoader : public ProxiedFileLoader {
 	// Guaranteed to read at least one block into the cache.
 	void SaveIntoCache(s64 pos, size_t bytes, Flags flags, bool readingAhead = false);
 	bool MakeCacheSpaceFor(size_t blocks, bool readingAhead);
-	void StartReadAhead(s64 pos);
+	void StartReadAhead(s64 readPos, s64 readEnd);
+	void WaitForReadAhead(s64 pos, size_t bytes);
+	void ReadAheadThread();
 
 	enum {
 		BLOCK_SIZE = 65536,
@@ -55,6 +61,12 @@ class CachingFileLoader : public ProxiedFileLoader {
 		MAX_BLOCKS_PER_READ = 16,
 		MAX_BLOCKS_CACHED = 4096, // 256 MB
 		BLOCK_READAHEAD = 4,
+		// Sequential reads double the readahead up to this, 4 MB.
+		MAX_BLOCK_READAHEAD = 64,
+		// Readahead is split into requests of this many blocks, fetched in parallel.
+		BLOCKS_PER_READAHEAD = 8,
+		// Fewer than HTTPFileLoader's connections, so a read that misses never waits behind readahead.
+		READAHEAD_THREADS = 3,
 	};
 
 	s64 filesize_ = 0;
@@ -76,7 +88,19 @@ class CachingFileLoader : public ProxiedFileLoader {
 
 	std::map<s64, BlockInfo> blocks_;
 	std::recursive_mutex blocksMutex_;
-	bool aheadThreadRunning_ = false;
-	std::thread aheadThread_;
 	std::once_flag preparedFlag_;
+
+	// Everything below is protected by blocksMutex_.
+	// Where the last read ended, to detect sequential access.
+	s64 lastReadEnd_ = -1;
+	size_t readAheadBlocks_ = BLOCK_READAHEAD;
+	std::vector<std::thread> aheadThreads_;
+	std::condition_variable_any aheadCond_;
+	// Start block and count of each pending readahead.
+	std::deque<std::pair<s64, size_t>> aheadQueue_;
+	// Blocks queued or being fetched, so they aren't requested twice.
+	std::set<s64> aheadBlocks_;
+	// Blocks being fetched right now.  Reads of these wait rather than fetching them again.
+	std::set<s64> aheadBusyBlocks_;
+	bool aheadShutdown_ = false;
 };
@@ -250,10 +250,11 @@ size_t DiskCachingFileLoaderCache::ReadFromCache(s64 pos, size_t bytes, void *da
 }
 
 size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, size_t bytes, void *data, FileLoader::Flags flags) {
-	std::lock_guard<std::mutex> guard(lock_);
+	std::unique_lock<std::mutex> guard(lock_);
 
 	if (!f_) {
 		// Just to keep things working.
+		guard.unlock();
 		return backend->ReadAt(pos, bytes, data, flags);
 	}
 
@@ -275,55 +276,55 @@ size_t DiskCachingFileLoaderCache::SaveIntoCache(FileLoader *backend, s64 pos, s
 		}
 	}
 
-	if (!MakeCacheSpaceFor(blocksToRead) || blocksToRead == 0) {
+	if (blocksToRead == 0) {
 		return 0;
 	}
 
-	if (blocksToRead == 1) {
-		auto &info = index_[cacheStartPos];
-
-		u8 *buf = new u8[blockSize_];
-		size_t readBytes = backend->ReadAt(cacheStartPos * (u64)blockSize_, blockSize_, buf, flags);
+	// Don't hold the lock while downloading, so other threads can read ahead or hit the cache meanwhile.
+	guard.unlock();
+	u8 *wholeRead = new u8[blocksToRead * blockSize_];
+	size_t readBytes = backend->ReadAt(cacheStartPos * (u64)blockSize_, blocksToRead * blockSize_, wholeRead, flags);
+	guard.lock();
 
-		// Check if it was written while we were busy.  Might happen if we thread.
-		if (info.block == INVALID_BLOCK && readBytes != 0) {
-			info.block = AllocateBlock((u32)cacheStartPos);
-			WriteBlockData(info, buf);
-			WriteIndexData((u32)cacheStartPos, info);
-		}
-
-		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
-		memcpy(p + readSize, buf + offset, toRead);
-		readSize += toRead;
-
-		delete [] buf;
-	} else {
-		u8 *wholeRead = new u8[blocksToRead * blockSize_];
-		size_t readBytes = backend->ReadAt(cacheStartPos * (u64)blockSize_, blocksToRead * blockSize_, wholeRead, flags);
+	// Only the last block of the file may be partial.  Don't save garbage past the end of it.
+	size_t blocksRead = readBytes / blockSize_;
+	if (cacheStartPos * (s64)blockSize_ + (s64)readBytes >= filesize_) {
+		blocksRead = std::min(blocksToRead, (readBytes + blockSize_ - 1) / blockSize_);
+		memset(wholeRead + readBytes, 0, blocksRead * blockSize_ - readBytes);
+	}
 
-		for (size_t i = 0; i < blocksToRead; ++i) {
+	// Make space for all of them, since eviction might drop blocks another thread saved while we were busy.
+	if (f_ && blocksRead != 0 && MakeCacheSpaceFor(blocksRead)) {
+		for (size_t i = 0; i < blocksRead; ++i) {
 			auto &info = index_[cacheStartPos + i];
-			// Check if it was written while we were busy.  Might happen if we thread.
-			if (info.block == INVALID_BLOCK && readBytes != 0) {
+			if (info.block == INVALID_BLOCK) {
 				info.block = AllocateBlock((u32)cacheStartPos + (u32)i);
 				WriteBlockData(info, wholeRead + (i * blockSize_));
 				// TODO: Doing each index together would probably be better.
 				WriteIndexData((u32)cacheStartPos + (u32)i, info);
+				++cacheSize_;
 			}
+		}
+
+		++generation_;
 
-			size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
-			memcpy(p + readSize, wholeRead + (i * blockSize_) + offset, toRead);
-			readSize += toRead;
+		if (generation_ == std::numeric_limits<u16>::max()) {
+			RebalanceGenerations();
 		}
-		delete[] wholeRead;
 	}
 
-	cacheSize_ += blocksToRead;
-	++generation_;
-
-	if (generation_ == std::numeric_limits<u16>::max()) {
-		RebalanceGenerations();
+	for (size_t i = 0; i < blocksRead; ++i) {
+		const size_t blockPos = i * blockSize_ + offset;
+		if (blockPos >= readBytes) {
+			break;
+		}
+		size_t toRead = std::min(bytes - readSize, (size_t)blockSize_ - offset);
+		toRead = std::min(toRead, readBytes - blockPos);
+		memcpy(p + readSize, wholeRead + blockPos, toRead);
+		readSize += toRead;
+		offset = 0;
 	}
+	delete[] wholeRead;
 
 	return readSize;
 }
@@ -175,7 +175,6 @@ std::string HTTPFileLoader::Path() const {
 
 size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
 	Prepare();
-	std::lock_guard<std::mutex> guard(readAtMutex_);
 
 	s64 absoluteEnd = std::min(absolutePos + (s64)bytes, filesize_);
 	if (absolutePos >= filesize_ || bytes == 0) {
@@ -183,30 +182,99 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 		return 0;
 	}
 
-	Connect();
-	if (!connected_) {
+	std::unique_ptr<RangeConnection> conn = AcquireConnection();
+	if (!conn) {
 		return 0;
 	}
 
+	size_t readBytes = ReadRange(conn.get(), absolutePos, absoluteEnd, data);
+	if (readBytes == 0 && conn->closedWhileIdle) {
+		// Servers drop idle kept alive connections whenever they like, so try once more on a new one.
+		conn->closedWhileIdle = false;
+		conn->connected = conn->client.Connect(3, 10.0, &cancelConnect_);
+		if (conn->connected)
+			readBytes = ReadRange(conn.get(), absolutePos, absoluteEnd, data);
+	}
+	ReleaseConnection(std::move(conn));
+	return readBytes;
+}
+
+std::unique_ptr<HTTPFileLoader::RangeConnection> HTTPFileLoader::AcquireConnection() {
+	std::unique_ptr<RangeConnection> conn;
+	{
+		std::unique_lock<std::mutex> guard(connectionsLock_);
+		// Connections are never dropped from the pool, so when none are idle, all that exist are busy.
+		connectionsCond_.wait(guard, [this] {
+			return !idleConnections_.empty() || busyConnections_ < MAX_RANGE_CONNECTIONS;
+		});
+		if (!idleConnections_.empty()) {
+			conn = std::move(idleConnections_.back());
+			idleConnections_.pop_back();
+		} else {
+			conn.reset(new RangeConnection());
+		}
+		busyConnections_++;
+	}
+
+	// Connect without the lock, so reads on other connections can go ahead.
+	if (!conn->resolved) {
+		conn->resolved = conn->client.Resolve(url_.Host().c_str(), url_.Port());
+		conn->client.SetDataTimeout(20.0);
+		conn->client.SetKeepAlive(true);
+	}
+	if (conn->resolved && !conn->connected) {
+		// Latency is important here, so reduce the timeout.
+		conn->connected = conn->client.Connect(3, 10.0, &cancelConnect_);
+	}
+
+	if (!conn->connected) {
+		latestError_ = "Could not connect (refused to connect)";
+		ReleaseConnection(std::move(conn));
+		return nullptr;
+	}
+	return conn;
+}
+
+void HTTPFileLoader::ReleaseConnection(std::unique_ptr<RangeConnection> conn) {
+	std::lock_guard<std::mutex> guard(connectionsLock_);
+	idleConnections_.push_back(std::move(conn));
+	busyConnections_--;
+	connectionsCond_.notify_one();
+}
+
+size_t HTTPFileLoader::ReadRange(RangeConnection *conn, s64 absolutePos, s64 absoluteEnd, void *data) {
+	auto disconnect = [conn] {
+		conn->client.Disconnect();
+		conn->connected = false;
+	};
+
 	char requestHeaders[4096];
 	// Note that the Range header is *inclusive*.
 	snprintf(requestHeaders, sizeof(requestHeaders),
 		"Range: bytes=%lld-%lld\r\n", absolutePos, absoluteEnd - 1);
 
-	int err = client_.SendRequest("GET", url_.Resource().c_str(), requestHeaders, nullptr);
+	// If this connection already served a request and we get nothing back at all, the server probably
+	// closed it while it sat in the pool.
+	const bool reused = conn->requests++ != 0;
+
+	int err = conn->client.SendRequest("GET", url_.Resource().c_str(), requestHeaders, nullptr);
 	if (err < 0) {
 		latestError_ = "Invalid response reading data";
-		Disconnect();
+		conn->closedWhileIdle = reused;
+		conn->requests = 0;
+		disconnect();
 		return 0;
 	}
 
 	Buffer readbuf;
 	std::vector<std::string> responseHeaders;
-	int code = client_.ReadResponseHeaders(&readbuf, responseHeaders);
+	int code = conn->client.ReadResponseHeaders(&readbuf, responseHeaders);
 	if (code != 206) {
 		ERROR_LOG(LOADER, "HTTP server did not respond with range, received code=%03d", code);
+		conn->closedWhileIdle = reused && code < 0;
+		conn->requests = 0;
 		latestError_ = "Invalid response reading data";
-		Disconnect();
+		disconnect();
 		return 0;
 	}
 
@@ -233,14 +301,19 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 
 	// TODO: Would be nice to read directly.
 	Buffer output;
-	int res = client_.ReadResponseEntity(&readbuf, responseHeaders, &output);
+	int res = conn->client.ReadResponseEntity(&readbuf, responseHeaders, &output);
 	if (res != 0) {
 		ERROR_LOG(LOADER, "Unable to read HTTP response entity: %d", res);
 		// Let's take anything we got anyway.  Not worse than returning nothing?
 	}
 
-	// TODO: Keepalive instead.
-	Disconnect();
+	// After an error, we don't know where the next response would start.
+	std::string connectionHeader;
+	http::GetHeaderValue(responseHeaders, "Connection", &connectionHeader);
+	if (res != 0 || !supportedResponse || startsWithNoCase(connectionHeader, "close")) {
+		conn->requests = 0;
+		disconnect();
+	}
 
 	if (!supportedResponse) {
 		ERROR_LOG(LOADER, "HTTP server did not respond with the range we wanted.");
@@ -250,13 +323,11 @@ size_t HTTPFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags f
 
 	size_t readBytes = output.size();
 	output.Take(readBytes, (char *)data);
-	filepos_ = absolutePos + readBytes;
 	return readBytes;
 }
 
 void HTTPFileLoader::Connect() {
 	if (!connected_) {
-		cancelConnect_ = false;
 		// Latency is important here, so reduce the timeout.
 		connected_ = client_.Connect(3, 10.0, &cancelConnect_);
 	}
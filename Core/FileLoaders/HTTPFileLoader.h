@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -50,10 +53,26 @@ class HTTPFileLoader : public FileLoader {
 	}
 
 	std::string LatestError() const override {
-		return latestError_;
+		return latestError_.load();
 	}
 
 private:
+	// A kept alive connection for range requests.  Several can be busy at once.
+	struct RangeConnection {
+		http::Client client;
+		bool resolved = false;
+		bool connected = false;
+		// Requests sent since connecting.
+		int requests = 0;
+		// Set when the last request failed in a way that looks like the server closed the connection.
+		bool closedWhileIdle = false;
+	};
+
+	enum {
+		// Keep above CachingFileLoader's READAHEAD_THREADS, so there's always one for reads that miss.
+		MAX_RANGE_CONNECTIONS = 4,
+	};
+
 	void Prepare();
 	int SendHEAD(const Url &url, std::vector<std::string> &responseHeaders);
 
@@ -66,15 +85,24 @@ class HTTPFileLoader : public FileLoader {
 		connected_ = false;
 	}
 
+	// Waits for an idle connection if all are busy.  Returns nullptr if unable to connect.
+	std::unique_ptr<RangeConnection> AcquireConnection();
+	void ReleaseConnection(std::unique_ptr<RangeConnection> conn);
+	size_t ReadRange(RangeConnection *conn, s64 absolutePos, s64 absoluteEnd, void *data);
+
 	s64 filesize_ = 0;
-	s64 filepos_ = 0;
 	Url url_;
 	http::Client client_;
 	std::string filename_;
 	bool connected_ = false;
-	bool cancelConnect_ = false;
-	const char *latestError_ = "";
+	// Reads happen on several threads, and Cancel() may come from any.  Once set, stays set.
+	std::atomic<bool> cancelConnect_{ false };
+	std::atomic<const char *> latestError_{ "" };
 
 	std::once_flag preparedFlag_;
-	std::mutex readAtMutex_;
+
+	std::mutex connectionsLock_;
+	std::condition_variable connectionsCond_;
+	std::vector<std::unique_ptr<RangeConnection>> idleConnections_;
+	int busyConnections_ = 0;
 };
@@ -20,6 +20,7 @@
 #include <cstring>
 #include <cstdlib>
 
+#include "Common/MemoryUtil.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/TimeUtil.h"
 #include "Core/FileLoaders/RamCachingFileLoader.h"
@@ -28,10 +29,11 @@
 
 // Takes ownership of backend.
 RamCachingFileLoader::RamCachingFileLoader(FileLoader *backend)
-	: ProxiedFileLoader(backend) {
+	: ProxiedFileLoader(backend), aheadCancel_(false) {
 	filesize_ = backend->FileSize();
 	if (filesize_ > 0) {
 		InitCache();
+		StartPreload();
 	}
 }
 
@@ -83,12 +85,29 @@ size_t RamCachingFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, F
 			}
 		}
 
-		StartReadAhead(absolutePos + readSize);
+		// Steer the preload towards where the game is reading.
+		std::lock_guard<std::mutex> guard(blocksMutex_);
+		aheadPos_ = absolutePos + readSize;
 	}
 	return readSize;
 }
 
+float RamCachingFileLoader::CachedFraction() {
+	std::lock_guard<std::mutex> guard(blocksMutex_);
+	if (cache_ == nullptr || blocks_.empty()) {
+		return -1.0f;
+	}
+	return 1.0f - (float)aheadRemaining_ / (float)blocks_.size();
+}
+
 void RamCachingFileLoader::InitCache() {
+	// Don't push the rest of the system into swap just to cache the file.
+	const u64 physicalMemory = GetPhysicalMemorySize();
+	if (physicalMemory != 0 && (u64)filesize_ > physicalMemory / 2) {
+		WARN_LOG(LOADER, "Not caching file in RAM: %lld MB is too much for %lld MB of memory", (long long)(filesize_ >> 20), (long long)(physicalMemory >> 20));
+		return;
+	}
+
 	std::lock_guard<std::mutex> guard(blocksMutex_);
 	u32 blockCount = (u32)((filesize_ + BLOCK_SIZE - 1) >> BLOCK_SHIFT);
 	// Overallocate for the last block.
@@ -103,13 +122,12 @@ void RamCachingFileLoader::InitCache() {
 void RamCachingFileLoader::ShutdownCache() {
 	Cancel();
 
-	// We can't delete while the thread is running, so have to wait.
-	// This should only happen from the menu.
-	while (aheadThreadRunning_) {
-		sleep_ms(1);
+	// We can't delete while the threads are running, so have to wait.
+	// They stop after their current read.
+	for (std::thread &th : aheadThreads_) {
+		th.join();
 	}
-	if (aheadThread_.joinable())
-		aheadThread_.join();
+	aheadThreads_.clear();
 
 	std::lock_guard<std::mutex> guard(blocksMutex_);
 	blocks_.clear();
@@ -120,11 +138,7 @@ void RamCachingFileLoader::ShutdownCache() {
 }
 
 void RamCachingFileLoader::Cancel() {
-	if (aheadThreadRunning_) {
-		std::lock_guard<std::mutex> guard(blocksMutex_);
-		aheadCancel_ = true;
-	}
-
+	aheadCancel_ = true;
 	ProxiedFileLoader::Cancel();
 }
 
@@ -150,7 +164,7 @@ size_t RamCachingFileLoader::ReadFromCache(s64 pos, size_t bytes, void *data) {
 
 	std::lock_guard<std::mutex> guard(blocksMutex_);
 	for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
-		if (blocks_[(size_t)i] == 0) {
+		if (blocks_[(size_t)i] != BLOCK_LOADED) {
 			return readSize;
 		}
 
@@ -176,7 +190,7 @@ void RamCachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags) {
 	{
 		std::lock_guard<std::mutex> guard(blocksMutex_);
 		for (s64 i = cacheStartPos; i <= cacheEndPos; ++i) {
-			if (blocks_[(size_t)i] == 0) {
+			if (blocks_[(size_t)i] != BLOCK_LOADED) {
 				++blocksToRead;
 				if (blocksToRead >= MAX_BLOCKS_PER_READ) {
 					break;
@@ -189,15 +203,19 @@ void RamCachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags) {
 	size_t bytesRead = backend_->ReadAt(cacheFilePos, blocksToRead << BLOCK_SHIFT, &cache_[cacheFilePos], flags);
 
 	// In case there was an error, let's not mark blocks that failed to read as read.
-	u32 blocksActuallyRead = (u32)((bytesRead + BLOCK_SIZE - 1) >> BLOCK_SHIFT);
+	// Only the last block of the file may be partial.
+	u32 blocksActuallyRead = (u32)(bytesRead >> BLOCK_SHIFT);
+	if (cacheFilePos + (s64)bytesRead >= filesize_) {
+		blocksActuallyRead = (u32)((bytesRead + BLOCK_SIZE - 1) >> BLOCK_SHIFT);
+	}
 	{
 		std::lock_guard<std::mutex> guard(blocksMutex_);
 
 		// In case they were simultaneously read.
 		u32 blocksRead = 0;
 		for (size_t i = 0; i < blocksActuallyRead; ++i) {
-			if (blocks_[(size_t)cacheStartPos + i] == 0) {
-				blocks_[(size_t)cacheStartPos + i] = 1;
+			if (blocks_[(size_t)cacheStartPos + i] != BLOCK_LOADED) {
+				blocks_[(size_t)cacheStartPos + i] = BLOCK_LOADED;
 				++blocksRead;
 			}
 		}
@@ -208,62 +226,74 @@ void RamCachingFileLoader::SaveIntoCache(s64 pos, size_t bytes, Flags flags) {
 	}
 }
 
-void RamCachingFileLoader::StartReadAhead(s64 pos) {
+void RamCachingFileLoader::StartPreload() {
 	if (cache_ == nullptr) {
 		return;
 	}
 
+	aheadStartTime_ = time_now_d();
+	aheadThreadsRunning_ = PRELOAD_THREADS;
+	for (int i = 0; i < PRELOAD_THREADS; ++i) {
+		aheadThreads_.push_back(std::thread([this] {
+			setCurrentThreadName("FileLoaderPreload");
+			PreloadThread();
+		}));
+	}
+}
+
+void RamCachingFileLoader::PreloadThread() {
+	u32 start, count;
+	while (!aheadCancel_ && ClaimAheadBlocks(start, count)) {
+		SaveIntoCache((s64)start << BLOCK_SHIFT, (size_t)count << BLOCK_SHIFT, Flags::NONE);
+		if (!ReleaseAheadBlocks(start, count)) {
+			// Nothing could be read, so don't spin on the same blocks.  Reads will still try.
+			WARN_LOG(LOADER, "Stopping preload after failed read at block %d", start);
+			break;
+		}
+	}
+
 	std::lock_guard<std::mutex> guard(blocksMutex_);
-	aheadPos_ = pos;
-	if (aheadThreadRunning_) {
-		// Already going.
-		return;
+	if (--aheadThreadsRunning_ == 0 && aheadRemaining_ == 0) {
+		INFO_LOG(LOADER, "Loaded %lld MB into RAM in %0.2f seconds", (long long)(filesize_ >> 20), time_now_d() - aheadStartTime_);
 	}
+}
 
-	aheadThreadRunning_ = true;
-	aheadCancel_ = false;
-	if (aheadThread_.joinable())
-		aheadThread_.join();
-	aheadThread_ = std::thread([this] {
-		setCurrentThreadName("FileLoaderReadAhead");
-
-		while (aheadRemaining_ != 0 && !aheadCancel_) {
-			// Where should we look?
-			const u32 cacheStartPos = NextAheadBlock();
-			if (cacheStartPos == 0xFFFFFFFF) {
-				// Must be full.
-				break;
-			}
-			u32 cacheEndPos = cacheStartPos + BLOCK_READAHEAD - 1;
-			if (cacheEndPos >= blocks_.size()) {
-				cacheEndPos = (u32)blocks_.size() - 1;
-			}
+bool RamCachingFileLoader::ClaimAheadBlocks(u32 &start, u32 &count) {
+	std::lock_guard<std::mutex> guard(blocksMutex_);
+	const u32 blockCount = (u32)blocks_.size();
+
+	// Go forward from the last read or claim, wrapping around to pick up anything skipped.
+	const u32 startFrom = (u32)std::min(aheadPos_ >> BLOCK_SHIFT, (s64)blockCount);
+	for (u32 n = 0; n < blockCount; ++n) {
+		u32 i = (startFrom + n) % blockCount;
+		if (blocks_[i] != BLOCK_EMPTY) {
+			continue;
+		}
 
-			for (u32 i = cacheStartPos; i <= cacheEndPos; ++i) {
-				if (blocks_[i] == 0) {
-					SaveIntoCache((u64)i << BLOCK_SHIFT, BLOCK_SIZE * BLOCK_READAHEAD, Flags::NONE);
-					break;
-				}
-			}
+		start = i;
+		count = 0;
+		while (i < blockCount && count < BLOCK_READAHEAD && blocks_[i] == BLOCK_EMPTY) {
+			blocks_[i++] = BLOCK_LOADING;
+			++count;
 		}
+		aheadPos_ = (s64)i << BLOCK_SHIFT;
+		return true;
+	}
 
-		aheadThreadRunning_ = false;
-	});
+	// Everything's loaded or being loaded.
+	return false;
 }
 
-u32 RamCachingFileLoader::NextAheadBlock() {
+bool RamCachingFileLoader::ReleaseAheadBlocks(u32 start, u32 count) {
 	std::lock_guard<std::mutex> guard(blocksMutex_);
 
-	// If we had an aheadPos_ set, start reading from there and go forward.
-	u32 startFrom = (u32)(aheadPos_ >> BLOCK_SHIFT);
-	// But next time, start from the beginning again.
-	aheadPos_ = 0;
-
-	for (u32 i = startFrom; i < blocks_.size(); ++i) {
-		if (blocks_[i] == 0) {
-			return i;
+	// After a short read, anything left unread goes back to empty so it can be claimed again.
+	u32 released = 0;
+	for (u32 i = start; i < start + count; ++i) {
+		if (blocks_[i] == BLOCK_LOADING) {
+			blocks_[i] = BLOCK_EMPTY;
+			++released;
 		}
 	}
-
-	return 0xFFFFFFFF;
+	return released < count;
 }
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <mutex>
 #include <thread>
@@ -41,20 +42,35 @@ class RamCachingFileLoader : public ProxiedFileLoader {
 
 	void Cancel() override;
 
+	// Fraction of the file loaded into RAM so far, or -1 if it's not being cached.
+	float CachedFraction();
+
 private:
 	void InitCache();
 	void ShutdownCache();
 	size_t ReadFromCache(s64 pos, size_t bytes, void *data);
 	// Guaranteed to read at least one block into the cache.
 	void SaveIntoCache(s64 pos, size_t bytes, Flags flags);
-	void StartReadAhead(s64 pos);
-	u32 NextAheadBlock();
+	void StartPreload();
+	void PreloadThread();
+	// Marks the next run of empty blocks as loading, starting around aheadPos_.
+	bool ClaimAheadBlocks(u32 &start, u32 &count);
+	bool ReleaseAheadBlocks(u32 start, u32 count);
 
 	enum {
 		BLOCK_SIZE = 65536,
 		BLOCK_SHIFT = 16,
 		MAX_BLOCKS_PER_READ = 16,
-		BLOCK_READAHEAD = 4,
+		BLOCK_READAHEAD = 16,
+		PRELOAD_THREADS = 4,
+	};
+
+	// Values of blocks_.
+	enum : u8 {
+		BLOCK_EMPTY = 0,
+		BLOCK_LOADED = 1,
+		// Claimed by a preload thread.  Reads don't wait for these, they just read them again.
+		BLOCK_LOADING = 2,
 	};
 
 	s64 filesize_ = 0;
@@ -64,9 +80,10 @@ class RamCachingFileLoader : public ProxiedFileLoader {
 
 	std::vector<u8> blocks_;
 	std::mutex blocksMutex_;
-	u32 aheadRemaining_;
-	s64 aheadPos_;
-	std::thread aheadThread_;
-	bool aheadThreadRunning_ = false;
-	bool aheadCancel_ = false;
+	u32 aheadRemaining_ = 0;
+	s64 aheadPos_ = 0;
+	std::vector<std::thread> aheadThreads_;
+	int aheadThreadsRunning_ = 0;
+	double aheadStartTime_ = 0.0;
+	std::atomic<bool> aheadCancel_;
 };
@@ -19,6 +19,7 @@
 #include <cstdio>
 #include <ctype.h>
 #include <algorithm>
+#include <set>
 
 #include "Common/Common.h"
 #include "Common/CommonTypes.h"
@@ -31,6 +32,10 @@
 
 const int sectorSize = 2048;
 
+// Most discs have a few dozen directory sectors at most, so these are all read and indexed at mount.
+// Beyond this, the remaining directories are read lazily as they're looked up.
+static const u32 MAX_INDEXED_DIRECTORY_SECTORS = 256;
+
 bool parseLBN(std::string filename, u32 *sectorStart, u32 *readSize) {
 	// The format of this is: "/sce_lbn" "0x"? HEX* ANY* "_size" "0x"? HEX* ANY*
 	// That means that "/sce_lbn/_size1/" is perfectly valid.
@@ -187,6 +192,8 @@ ISOFileSystem::ISOFileSystem(IHandleAllocator *_hAlloc, BlockDevice *_blockDevic
 	treeroot->parent = NULL;
 	treeroot->valid = false;
 
+	lastReadBlock_ = 0;
+
 	if (memcmp(desc.cd001, "CD001", 5)) {
 		ERROR_LOG(FILESYS, "ISO looks bogus, expected CD001 signature not present? Giving up...");
 		return;
@@ -194,6 +201,8 @@ ISOFileSystem::ISOFileSystem(IHandleAllocator *_hAlloc, BlockDevice *_blockDevic
 
 	treeroot->startsector = desc.root.firstDataSector();
 	treeroot->dirsize = desc.root.dataLength();
+
+	IndexTree();
 }
 
 ISOFileSystem::~ISOFileSystem() {
@@ -208,6 +217,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			blockDevice->NotifyReadError();
 			ERROR_LOG(FILESYS, "Error reading block for directory %s - skipping", root->name.c_str());
 			root->valid = true;  // Prevents re-reading
+			IndexDirectory(root);
 			return;
 		}
 		lastReadBlock_ = secnum;  // Hm, this could affect timing... but lazy loading is probably more realistic.
@@ -224,6 +234,7 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 			if (offset + IDENTIFIER_OFFSET + dir.identifierLength > 2048) {
 				blockDevice->NotifyReadError();
 				ERROR_LOG(FILESYS, "Directory entry crosses sectors, corrupt iso?");
+				IndexDirectory(root);
 				return;
 			}
 
@@ -265,6 +276,77 @@ void ISOFileSystem::ReadDirectory(TreeEntry *root) {
 		}
 	}
 	root->valid = true;
+	IndexDirectory(root);
+}
+
+void ISOFileSystem::IndexDirectory(TreeEntry *dir) {
+	// Paths through "." or ".." are left to WalkPath, so don't index anything reached that way.
+	for (TreeEntry *cur = dir; cur != nullptr && cur != treeroot; cur = cur->parent) {
+		if (cur->name == "." || cur->name == "..")
+			return;
+	}
+
+	const std::string prefix = dir == treeroot ? "" : EntryFullPath(dir).substr(1) + "/";
+	for (TreeEntry *child : dir->children) {
+		if (child->name == "." || child->name == "..")
+			continue;
+		// Like WalkPath, the first entry with a given name wins.
+		pathIndex_.emplace(prefix + child->name, child);
+	}
+}
+
+void ISOFileSystem::IndexTree() {
+	// Reading directories normally moves lastReadBlock_, but this happens before the game sees anything.
+	const u32 savedLastReadBlock = lastReadBlock_;
+
+	std::vector<TreeEntry *> pending;
+	std::set<u32> seenSectors;
+	u32 sectorsLeft = MAX_INDEXED_DIRECTORY_SECTORS;
+	bool complete = true;
+
+	pending.push_back(treeroot);
+	for (size_t i = 0; i < pending.size(); ++i) {
+		TreeEntry *dir = pending[i];
+		const u32 numSectors = (dir->dirsize + 2047) / 2048;
+		if (numSectors > sectorsLeft) {
+			complete = false;
+			break;
+		}
+		if (!seenSectors.insert(dir->startsector).second) {
+			// Corrupt or looping tree, keep lookups of these on the slow path.
+			complete = false;
+			continue;
+		}
+
+		if (!dir->valid)
+			ReadDirectory(dir);
+		sectorsLeft -= numSectors;
+
+		for (TreeEntry *child : dir->children) {
+			if (child->isDirectory && child->name != "." && child->name != "..")
+				pending.push_back(child);
+		}
+	}
+
+	fullyIndexed_ = complete;
+	lastReadBlock_ = savedLastReadBlock;
+	INFO_LOG(FILESYS, "Indexed %d entries in %d directories%s", (int)pathIndex_.size(), (int)seenSectors.size(), complete ? "" : " (partial)");
+}
+
+// True if every component is a real name, i.e. no empty components, "." or "..".
+static bool IsPlainPath(const std::string &path) {
+	size_t start = 0;
+	while (true) {
+		size_t end = path.find('/', start);
+		if (end == std::string::npos)
+			end = path.size();
+		const size_t len = end - start;
+		if (len == 0 || (len == 1 && path[start] == '.') || (len == 2 && path[start] == '.' && path[start + 1] == '.'))
+			return false;
+		if (end == path.size())
+			return true;
+		start = end + 1;
+	}
 }
 
 ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bool catchError) {
@@ -288,6 +370,32 @@ ISOFileSystem::TreeEntry *ISOFileSystem::GetFromPath(const std::string &path, bo
 	if (pathLength <= pathIndex)
 		return treeroot;
 
+	// A single trailing slash is fine, as in WalkPath.
+	size_t keyLength = pathLength - pathIndex;
+	if (path[pathLength - 1] == '/')
+		--keyLength;
+	const std::string key = path.substr(pathIndex, keyLength);
+	if (IsPlainPath(key)) {
+		auto found = pathIndex_.find(key);
+		if (found != pathIndex_.end()) {
+			TreeEntry *entry = found->second;
+			if (!entry->valid)
+				ReadDirectory(entry);
+			return entry;
+		}
+		if (fullyIndexed_) {
+			if (catchError)
+				ERROR_LOG(FILESYS, "File '%s' not found", path.c_str());
+			return 0;
+		}
+	}
+
+	return WalkPath(path, pathIndex, catchError);
+}
+
+ISOFileSystem::TreeEntry *ISOFileSystem::WalkPath(const std::string &path, size_t pathIndex, bool catchError) {
+	const size_t pathLength = path.length();
+
 	TreeEntry *entry = treeroot;
 	while (true) {
 		if (!entry->valid) {
@@ -19,6 +19,8 @@
 
 #include <map>
 #include <list>
+#include <string>
+#include <unordered_map>
 
 #include "FileSystem.h"
 
@@ -92,8 +94,17 @@ class ISOFileSystem : public IFileSystem {
 
 	TreeEntry entireISO;
 
+	// Every entry from the directories read so far, keyed by path from the root without a leading slash
+	// ("PSP_GAME/SYSDIR/EBOOT.BIN"). Relative entries and anything below them are left out.
+	std::unordered_map<std::string, TreeEntry *> pathIndex_;
+	// Set when every directory on the disc has been read, so a miss in pathIndex_ is final.
+	bool fullyIndexed_ = false;
+
 	void ReadDirectory(TreeEntry *root);
+	void IndexDirectory(TreeEntry *dir);
+	void IndexTree();
 	TreeEntry *GetFromPath(const std::string &path, bool catchError = true);
+	TreeEntry *WalkPath(const std::string &path, size_t pathIndex, bool catchError);
 	std::string EntryFullPath(TreeEntry *e);
 };
 
@@ -15,8 +15,12 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -70,6 +74,26 @@ static const char *hleAfterSyscallReschedReason;
 static const HLEFunction *latestSyscall = nullptr;
 static int idleOp;
 
+static double hleSteppingTime = 0.0;
+
+struct HLESyscallCounter {
+	std::atomic<u64> calls;
+	std::atomic<u64> nanos;
+};
+
+// One counter per function in each module's funcTable, sorted by funcTable for lookup.
+struct HLESyscallCounters {
+	const HLEFunction *funcTable;
+	int numFunctions;
+	const char *module;
+	std::unique_ptr<HLESyscallCounter[]> counters;
+};
+
+static std::atomic<bool> syscallProfiling;
+// Only needed to change the tables, or to read them off the CPU thread.  The counters are atomic.
+static std::mutex syscallProfileLock;
+static std::vector<HLESyscallCounters> syscallProfile;
+
 struct HLEMipsCallInfo {
 	u32 func;
 	PSPAction *action;
@@ -119,6 +143,21 @@ void HLEInit() {
 	RegisterAllModules();
 	delayedResultEvent = CoreTiming::RegisterEvent("HLEDelayedResult", hleDelayResultFinish);
 	idleOp = GetSyscallOp("FakeSysCalls", NID_IDLE);
+
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	syscallProfile.clear();
+	syscallProfile.reserve(moduleDB.size());
+	for (const HLEModule &module : moduleDB) {
+		HLESyscallCounters table{ module.funcTable, module.numFunctions, module.name, std::unique_ptr<HLESyscallCounter[]>(new HLESyscallCounter[module.numFunctions]) };
+		for (int i = 0; i < module.numFunctions; ++i) {
+			table.counters[i].calls = 0;
+			table.counters[i].nanos = 0;
+		}
+		syscallProfile.push_back(std::move(table));
+	}
+	std::sort(syscallProfile.begin(), syscallProfile.end(), [](const HLESyscallCounters &a, const HLESyscallCounters &b) {
+		return a.funcTable < b.funcTable;
+	});
 }
 
 void HLEDoState(PointerWrap &p) {
@@ -620,10 +659,69 @@ static void updateSyscallStats(int modulenum, int funcnum, double total)
 	}
 }
 
+// Only called on the CPU thread, which is also the only one that changes the tables.
+static void hleRecordSyscallProfile(const HLEFunction *info, double seconds) {
+	auto it = std::upper_bound(syscallProfile.begin(), syscallProfile.end(), info, [](const HLEFunction *f, const HLESyscallCounters &table) {
+		return f < table.funcTable;
+	});
+	if (it == syscallProfile.begin())
+		return;
+	--it;
+	const ptrdiff_t index = info - it->funcTable;
+	if (index >= it->numFunctions)
+		return;
+
+	HLESyscallCounter &counter = it->counters[index];
+	counter.calls.fetch_add(1, std::memory_order_relaxed);
+	if (seconds > 0.0)
+		counter.nanos.fetch_add((u64)(seconds * 1000000000.0), std::memory_order_relaxed);
+}
+
+void hleSetSyscallProfiling(bool enabled) {
+	syscallProfiling = enabled;
+}
+
+bool hleIsSyscallProfiling() {
+	return syscallProfiling;
+}
+
+void hleResetSyscallProfile() {
+	std::lock_guard<std::mutex> guard(syscallProfileLock);
+	for (HLESyscallCounters &table : syscallProfile) {
+		for (int i = 0; i < table.numFunctions; ++i) {
+			table.counters[i].calls.store(0, std::memory_order_relaxed);
+			table.counters[i].nanos.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+std::vector<HLESyscallProfile> hleGetSyscallProfile() {
+	std::vector<HLESyscallProfile> result;
+	{
+		std::lock_guard<std::mutex> guard(syscallProfileLock);
+		for (const HLESyscallCounters &table : syscallProfile) {
+			for (int i = 0; i < table.numFunctions; ++i) {
+				const u64 calls = table.counters[i].calls.load(std::memory_order_relaxed);
+				if (calls == 0)
+					continue;
+				const double seconds = table.counters[i].nanos.load(std::memory_order_relaxed) / 1000000000.0;
+				result.push_back(HLESyscallProfile{ table.module, &table.funcTable[i], calls, seconds });
+			}
+		}
+	}
+	std::sort(result.begin(), result.end(), [](const HLESyscallProfile &a, const HLESyscallProfile &b) {
+		return a.seconds > b.seconds;
+	});
+	return result;
+}
+
 inline void CallSyscallWithFlags(const HLEFunction *info)
 {
 	latestSyscall = info;
 	const u32 flags = info->flags;
+	const bool profiling = syscallProfiling.load(std::memory_order_relaxed);
+	const double start = profiling ? time_now_d() : 0.0;
+	const double steppingStart = hleSteppingTime;
 
 	if (flags & HLE_CLEAR_STACK_BYTES) {
 		u32 stackStart = __KernelGetCurThreadStackStart();
@@ -644,17 +742,27 @@ inline void CallSyscallWithFlags(const HLEFunction *info)
 		hleFinishSyscall(*info);
 	else
 		SetDeadbeefRegs();
+
+	// Like CallSyscall(), don't count time spent stepping in the debugger.
+	if (profiling)
+		hleRecordSyscallProfile(info, time_now_d() - start - (hleSteppingTime - steppingStart));
 }
 
 inline void CallSyscallWithoutFlags(const HLEFunction *info)
 {
 	latestSyscall = info;
+	const bool profiling = syscallProfiling.load(std::memory_order_relaxed);
+	const double start = profiling ? time_now_d() : 0.0;
+	const double steppingStart = hleSteppingTime;
 	info->func();
 
 	if (hleAfterSyscall != HLE_AFTER_NOTHING)
 		hleFinishSyscall(*info);
 	else
 		SetDeadbeefRegs();
+
+	if (profiling)
+		hleRecordSyscallProfile(info, time_now_d() - start - (hleSteppingTime - steppingStart));
 }
 
 const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op)
@@ -694,7 +802,6 @@ void *GetQuickSyscallFunc(MIPSOpcode op) {
 	return (void *)&CallSyscallWithoutFlags;
 }
 
-static double hleSteppingTime = 0.0;
 void hleSetSteppingTime(double t)
 {
 	hleSteppingTime += t;
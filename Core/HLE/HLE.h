@@ -20,6 +20,7 @@
 #include <cstdio>
 #include <cstdarg>
 #include <type_traits>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Log.h"
@@ -155,6 +156,21 @@ const HLEFunction *GetSyscallFuncPointer(MIPSOpcode op);
 // For jit, takes arg: const HLEFunction *
 void *GetQuickSyscallFunc(MIPSOpcode op);
 
+struct HLESyscallProfile {
+	const char *module;
+	const HLEFunction *func;
+	u64 calls;
+	// Host time, including rescheduling and callbacks run after the call.
+	double seconds;
+};
+
+// Counts calls and host time per syscall, to find hot ones.  Can be toggled at any time, from any thread.
+void hleSetSyscallProfiling(bool enabled);
+bool hleIsSyscallProfiling();
+void hleResetSyscallProfile();
+// Sorted by host time, most first.  Reset when a game starts.
+std::vector<HLESyscallProfile> hleGetSyscallProfile();
+
 void hleDoLogInternal(LogTypes::LOG_TYPE t, LogTypes::LOG_LEVELS level, u64 res, const char *file, int line, const char *reportTag, char retmask, const char *reason, const char *formatted_reason);
 
 template <typename T>
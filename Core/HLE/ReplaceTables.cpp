@@ -25,6 +25,7 @@
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSAnalyst.h"
@@ -1412,6 +1413,7 @@ static bool WriteReplaceInstruction(u32 address, int index) {
 	}
 	replacedInstructions[address] = prevInstr;
 	Memory::Write_U32(MIPS_EMUHACK_CALL_REPLACEMENT | index, address);
+	currentMIPS->InvalidateICache(address, 4);
 	return true;
 }
 
@@ -1450,6 +1452,7 @@ void RestoreReplacedInstruction(u32 address) {
 	const u32 curInstr = Memory::Read_U32(address);
 	if (MIPS_IS_REPLACEMENT(curInstr)) {
 		Memory::Write_U32(replacedInstructions[address], address);
+		currentMIPS->InvalidateICache(address, 4);
 		NOTICE_LOG(HLE, "Restored replaced func at %08x", address);
 	} else {
 		NOTICE_LOG(HLE, "Replaced func changed at %08x", address);
@@ -1471,6 +1474,7 @@ void RestoreReplacedInstructions(u32 startAddr, u32 endAddr) {
 		const u32 curInstr = Memory::Read_U32(addr);
 		if (MIPS_IS_REPLACEMENT(curInstr)) {
 			Memory::Write_U32(it->second, addr);
+			currentMIPS->InvalidateICache(addr, 4);
 			++restored;
 		}
 	}
@@ -16,9 +16,12 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <memory>
 
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/Thread/ThreadPool.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/FunctionWrappers.h"
 #include "Core/MIPS/MIPS.h"
@@ -116,6 +119,10 @@ const u32 ATRAC3_MAX_SAMPLES = 0x400;
 const u32 ATRAC3PLUS_MAX_SAMPLES = 0x800;
 
 static const int atracDecodeDelay = 2300;
+// How many frames of audio each context may decode ahead on its worker thread.
+static const int ATRAC_DECODE_AHEAD_FRAMES = 4;
+// Room for one channel of one frame, as float or anything smaller.
+static const int ATRAC_DECODE_AHEAD_PLANE_BYTES = ATRAC3PLUS_MAX_SAMPLES * sizeof(float);
 
 #ifdef USE_FFMPEG
 
@@ -134,6 +141,29 @@ enum AtracDecodeResult {
 	ATDECODE_BADFRAME = 2,
 };
 
+#ifdef USE_FFMPEG
+static AtracDecodeResult DecodeAtracPacket(AVCodecContext *codecCtx, AVFrame *frame, AVPacket *packet) {
+	int got_frame = 0;
+	int bytes_read = avcodec_decode_audio4(codecCtx, frame, &got_frame, packet);
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+	av_packet_unref(packet);
+#else
+	av_free_packet(packet);
+#endif
+	if (bytes_read == AVERROR_PATCHWELCOME) {
+		ERROR_LOG(ME, "Unsupported feature in ATRAC audio.");
+		// Let's try the next packet.
+		packet->size = 0;
+		return ATDECODE_BADFRAME;
+	} else if (bytes_read < 0) {
+		ERROR_LOG_REPORT(ME, "avcodec_decode_audio4: Error decoding audio %d / %08x", bytes_read, bytes_read);
+		return ATDECODE_FAILED;
+	}
+
+	return got_frame ? ATDECODE_GOTFRAME : ATDECODE_FEEDME;
+}
+#endif // USE_FFMPEG
+
 struct InputBuffer {
 	// Address of the buffer.
 	u32 addr;
@@ -237,6 +267,13 @@ struct Atrac {
 		if (!s)
 			return;
 
+#ifdef USE_FFMPEG
+		// Frames decoded ahead aren't saved.  On load, the decoder starts over anyway.
+		WaitForDecodeAhead();
+		if (p.mode == p.MODE_READ)
+			DropDecodeAhead();
+#endif
+
 		Do(p, channels_);
 		Do(p, outputChannels_);
 		if (s >= 5) {
@@ -439,10 +476,47 @@ struct Atrac {
 	SwrContext      *swrCtx_ = nullptr;
 	AVFrame         *frame_ = nullptr;
 	AVPacket        *packet_ = nullptr;
+
+	// The samples the last DecodePacket() got, one plane per channel, either in frame_ or decodeAheadPcm_.
+	const u8 *decodedData_[2]{};
+	int decodedSamples_ = 0;
+	AVSampleFormat decodedFormat_ = AV_SAMPLE_FMT_NONE;
+
+	// Packets the next calls to DecodePacket() are expected to ask for, in order.  The worker decodes
+	// them with codecCtx_, so codecCtx_ is always this far ahead.
+	// Only DecodePacket(), DecodeAhead(), and things that flush or replace the decoder touch these,
+	// and they wait for the worker first.
+	struct DecodeAheadFrame {
+		std::vector<u8> packet;
+		u32 pos = 0;
+		int samples = 0;
+		AVSampleFormat format = AV_SAMPLE_FMT_NONE;
+		AtracDecodeResult result = ATDECODE_FEEDME;
+	};
+	DecodeAheadFrame decodeAhead_[ATRAC_DECODE_AHEAD_FRAMES];
+	int decodeAheadStart_ = 0;
+	int decodeAheadCount_ = 0;
+	// Sample position the next frame queued for decode ahead would start at.
+	int decodeAheadSample_ = 0;
+	// Decoded samples for each entry in decodeAhead_, ATRAC_DECODE_AHEAD_PLANE_BYTES per channel.
+	std::vector<u8> decodeAheadPcm_;
+	AVFrame *decodeAheadScratch_ = nullptr;
+	AVPacket *decodeAheadPacket_ = nullptr;
+	std::unique_ptr<WorkerThread> decodeAheadThread_;
+	bool decodeAheadPending_ = false;
 #endif // USE_FFMPEG
 
 #ifdef USE_FFMPEG
 	void ReleaseFFMPEGContext() {
+		DropDecodeAhead();
+		av_frame_free(&decodeAheadScratch_);
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+		av_packet_free(&decodeAheadPacket_);
+#else
+		delete decodeAheadPacket_;
+		decodeAheadPacket_ = nullptr;
+#endif
+
 		// All of these allow null pointers.
 		av_freep(&frame_);
 		swr_free(&swrCtx_);
@@ -466,10 +540,38 @@ struct Atrac {
 		packet_ = nullptr;
 #endif
 	}
+
+	void WaitForDecodeAhead() {
+		if (decodeAheadPending_) {
+			decodeAheadThread_->WaitForCompletion();
+			decodeAheadPending_ = false;
+		}
+	}
+
+	// Throws away frames decoded ahead.  codecCtx_ has already seen their packets, so unless it's
+	// about to be flushed or released anyway, the caller must prime it again.  Returns true if
+	// anything was dropped.
+	bool DropDecodeAhead() {
+		WaitForDecodeAhead();
+		if (decodeAheadCount_ == 0)
+			return false;
+
+		decodeAheadStart_ = 0;
+		decodeAheadCount_ = 0;
+		return true;
+	}
+
+	u8 *DecodeAheadPlane(int index, int channel) {
+		return &decodeAheadPcm_[(index * 2 + channel) * ATRAC_DECODE_AHEAD_PLANE_BYTES];
+	}
+
+	void DecodeAhead();
+	bool TakeDecodeAhead(AtracDecodeResult *result);
 #endif // USE_FFMPEG
 
 	void ForceSeekToSample(int sample) {
 #ifdef USE_FFMPEG
+		DropDecodeAhead();
 		avcodec_flush_buffers(codecCtx_);
 
 		// Discard any pending packet data.
@@ -494,32 +596,41 @@ struct Atrac {
 		int seekFrame = sample + offsetSamples - unalignedSamples;
 
 		if ((sample != currentSample_ || sample == 0) && codecCtx_ != nullptr) {
-			// Prefill the decode buffer with packets before the first sample offset.
-			avcodec_flush_buffers(codecCtx_);
-
-			int adjust = 0;
-			if (sample == 0) {
-				int offsetSamples = firstSampleOffset_ + FirstOffsetExtra();
-				adjust = -(int)(offsetSamples % SamplesPerFrame());
-			}
-			const u32 off = FileOffsetBySample(sample + adjust);
-			const u32 backfill = bytesPerFrame_ * 2;
-			const u32 start = off - dataOff_ < backfill ? dataOff_ : off - backfill;
-			for (u32 pos = start; pos < off; pos += bytesPerFrame_) {
-				av_init_packet(packet_);
-				packet_->data = BufferStart() + pos;
-				packet_->size = bytesPerFrame_;
-				packet_->pos = pos;
-
-				// Process the packet, we don't care about success.
-				DecodePacket();
-			}
+			PrimeDecoder(sample);
 		}
 #endif // USE_FFMPEG
 
 		currentSample_ = sample;
 	}
 
+#ifdef USE_FFMPEG
+	void PrimeDecoder(int sample) {
+		// Anything decoded ahead was for the old position.
+		DropDecodeAhead();
+
+		// Prefill the decode buffer with packets before the first sample offset.
+		avcodec_flush_buffers(codecCtx_);
+
+		int adjust = 0;
+		if (sample == 0) {
+			int offsetSamples = firstSampleOffset_ + FirstOffsetExtra();
+			adjust = -(int)(offsetSamples % SamplesPerFrame());
+		}
+		const u32 off = FileOffsetBySample(sample + adjust);
+		const u32 backfill = bytesPerFrame_ * 2;
+		const u32 start = off - dataOff_ < backfill ? dataOff_ : off - backfill;
+		for (u32 pos = start; pos < off; pos += bytesPerFrame_) {
+			av_init_packet(packet_);
+			packet_->data = BufferStart() + pos;
+			packet_->size = bytesPerFrame_;
+			packet_->pos = pos;
+
+			// Process the packet, we don't care about success.
+			DecodePacket();
+		}
+	}
+#endif // USE_FFMPEG
+
 	bool FillPacket(int adjust = 0) {
 		u32 off = FileOffsetBySample(currentSample_ + adjust);
 		if (off < first_.size) {
@@ -555,25 +666,21 @@ struct Atrac {
 			return ATDECODE_FAILED;
 		}
 
-		int got_frame = 0;
-		int bytes_read = avcodec_decode_audio4(codecCtx_, frame_, &got_frame, packet_);
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
-		av_packet_unref(packet_);
-#else
-		av_free_packet(packet_);
-#endif
-		if (bytes_read == AVERROR_PATCHWELCOME) {
-			ERROR_LOG(ME, "Unsupported feature in ATRAC audio.");
-			// Let's try the next packet.
-			packet_->size = 0;
-			return ATDECODE_BADFRAME;
-		} else if (bytes_read < 0) {
-			ERROR_LOG_REPORT(ME, "avcodec_decode_audio4: Error decoding audio %d / %08x", bytes_read, bytes_read);
-			failedDecode_ = true;
-			return ATDECODE_FAILED;
+		AtracDecodeResult result;
+		if (decodeAheadCount_ != 0 && TakeDecodeAhead(&result)) {
+			return result;
 		}
 
-		return got_frame ? ATDECODE_GOTFRAME : ATDECODE_FEEDME;
+		result = DecodeAtracPacket(codecCtx_, frame_, packet_);
+		if (result == ATDECODE_FAILED) {
+			failedDecode_ = true;
+		} else if (result == ATDECODE_GOTFRAME) {
+			decodedData_[0] = frame_->extended_data[0];
+			decodedData_[1] = frame_->extended_data[1];
+			decodedSamples_ = frame_->nb_samples;
+			decodedFormat_ = (AVSampleFormat)frame_->format;
+		}
+		return result;
 #else
 		return ATDECODE_BADFRAME;
 #endif // USE_FFMPEG
@@ -606,6 +713,149 @@ struct Atrac {
 	void AnalyzeReset();
 };
 
+#ifdef USE_FFMPEG
+bool Atrac::TakeDecodeAhead(AtracDecodeResult *result) {
+	WaitForDecodeAhead();
+
+	const int index = decodeAheadStart_;
+	const DecodeAheadFrame &f = decodeAhead_[index];
+	if (f.pos != (u32)packet_->pos || (int)f.packet.size() != packet_->size || memcmp(f.packet.data(), packet_->data, f.packet.size()) != 0) {
+		// Something changed the position or data after we decoded ahead, so codecCtx_ has seen the wrong packets.
+		// Prime it again the same way a seek would, and let the caller decode this packet normally.
+		WARN_LOG(ME, "Atrac decode ahead mismatch at %08x, priming again", (u32)packet_->pos);
+		const AVPacket wanted = *packet_;
+		PrimeDecoder(currentSample_);
+		*packet_ = wanted;
+		return false;
+	}
+
+	*result = f.result;
+	if (f.result == ATDECODE_FAILED) {
+		failedDecode_ = true;
+	} else if (f.result == ATDECODE_GOTFRAME) {
+		decodedData_[0] = DecodeAheadPlane(index, 0);
+		decodedData_[1] = DecodeAheadPlane(index, 1);
+		decodedSamples_ = f.samples;
+		decodedFormat_ = f.format;
+	}
+
+	// Mirror what decoding this packet would have done to it.
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+	av_packet_unref(packet_);
+#else
+	av_free_packet(packet_);
+#endif
+	if (f.result == ATDECODE_BADFRAME) {
+		packet_->size = 0;
+	}
+
+	// The samples stay in decodeAheadPcm_ until DecodeAhead() queues more, after the caller is done with them.
+	decodeAheadStart_ = (decodeAheadStart_ + 1) % ATRAC_DECODE_AHEAD_FRAMES;
+	decodeAheadCount_--;
+	return true;
+}
+
+// Queues the packets the next few _AtracDecodeData() calls are sure to decode, if nothing changes, and decodes
+// them on a worker.  The results are only used if those calls really do ask for the same packets.
+void Atrac::DecodeAhead() {
+	// sceSas may decode from its own thread, and low level decoding doesn't follow the stream.
+	if (failedDecode_ || codecCtx_ == nullptr || !BufferStart() || (codecType_ != PSP_MODE_AT_3 && codecType_ != PSP_MODE_AT_3_PLUS) ||
+		bufferState_ == ATRAC_STATUS_FOR_SCESAS || bufferState_ == ATRAC_STATUS_LOW_LEVEL || bufferState_ == ATRAC_STATUS_NO_DATA) {
+		if (DropDecodeAhead() && codecCtx_ != nullptr && BufferStart())
+			PrimeDecoder(currentSample_);
+		return;
+	}
+	// The ring only has room for up to two planar channels.
+	if (channels_ > 2 || !av_sample_fmt_is_planar(codecCtx_->sample_fmt) || av_get_bytes_per_sample(codecCtx_->sample_fmt) > (int)sizeof(float))
+		return;
+
+	WaitForDecodeAhead();
+
+	const int samplesPerFrame = (int)SamplesPerFrame();
+	const int offsetSamples = firstSampleOffset_ + FirstOffsetExtra();
+	const int loopEndAdjusted = loopEndSample_ - FirstOffsetExtra() - firstSampleOffset_;
+	const int firstNew = decodeAheadCount_;
+
+	int sample = decodeAheadCount_ == 0 ? currentSample_ : decodeAheadSample_;
+	while (decodeAheadCount_ < ATRAC_DECODE_AHEAD_FRAMES) {
+		// Only whole, aligned frames that won't seek, loop, or hit the end first.
+		if (sample <= 0 || (offsetSamples + sample) % samplesPerFrame != 0 || sample >= endSample_)
+			break;
+		if (loopEndSample_ > 0 && sample > loopEndAdjusted)
+			break;
+		const u32 off = FileOffsetBySample(sample);
+		if (off + bytesPerFrame_ > first_.size)
+			break;
+
+		DecodeAheadFrame &f = decodeAhead_[(decodeAheadStart_ + decodeAheadCount_) % ATRAC_DECODE_AHEAD_FRAMES];
+		const u8 *data = BufferStart() + off;
+		f.packet.assign(data, data + bytesPerFrame_);
+		f.pos = off;
+		decodeAheadCount_++;
+		sample += samplesPerFrame;
+	}
+	decodeAheadSample_ = sample;
+
+	if (decodeAheadCount_ == firstNew)
+		return;
+
+	if (decodeAheadPcm_.empty())
+		decodeAheadPcm_.resize(ATRAC_DECODE_AHEAD_FRAMES * 2 * ATRAC_DECODE_AHEAD_PLANE_BYTES);
+	if (!decodeAheadScratch_)
+		decodeAheadScratch_ = av_frame_alloc();
+	if (!decodeAheadPacket_) {
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 12, 100)
+		decodeAheadPacket_ = av_packet_alloc();
+#else
+		decodeAheadPacket_ = new AVPacket;
+		av_init_packet(decodeAheadPacket_);
+#endif
+	}
+	if (!decodeAheadThread_) {
+		decodeAheadThread_.reset(new WorkerThread());
+		decodeAheadThread_->StartUp();
+		decodeAheadThread_->Process([] {
+			setCurrentThreadName("AtracDecode");
+		});
+		decodeAheadThread_->WaitForCompletion();
+	}
+
+	const int start = (decodeAheadStart_ + firstNew) % ATRAC_DECODE_AHEAD_FRAMES;
+	const int count = decodeAheadCount_ - firstNew;
+	const int channels = channels_;
+	decodeAheadThread_->Process([this, start, count, channels] {
+		bool failed = false;
+		for (int i = 0; i < count; ++i) {
+			const int index = (start + i) % ATRAC_DECODE_AHEAD_FRAMES;
+			DecodeAheadFrame &f = decodeAhead_[index];
+			if (failed) {
+				// Nothing decodes after a failure anyway.
+				f.result = ATDECODE_FAILED;
+				continue;
+			}
+
+			av_init_packet(decodeAheadPacket_);
+			decodeAheadPacket_->data = f.packet.data();
+			decodeAheadPacket_->size = (int)f.packet.size();
+			decodeAheadPacket_->pos = f.pos;
+
+			f.result = DecodeAtracPacket(codecCtx_, decodeAheadScratch_, decodeAheadPacket_);
+			if (f.result == ATDECODE_GOTFRAME) {
+				// Keep just the samples, the decoder reuses its buffers for the next packet.
+				f.format = (AVSampleFormat)decodeAheadScratch_->format;
+				const int bytesPerSample = av_get_bytes_per_sample(f.format);
+				f.samples = std::min(decodeAheadScratch_->nb_samples, ATRAC_DECODE_AHEAD_PLANE_BYTES / bytesPerSample);
+				for (int ch = 0; ch < channels; ++ch)
+					memcpy(DecodeAheadPlane(index, ch), decodeAheadScratch_->extended_data[ch], f.samples * bytesPerSample);
+			}
+			failed = f.result == ATDECODE_FAILED;
+		}
+		av_frame_unref(decodeAheadScratch_);
+	});
+	decodeAheadPending_ = true;
+}
+#endif // USE_FFMPEG
+
 struct AtracSingleResetBufferInfo {
 	u32_le writePosPtr;
 	u32_le writableBytes;
@@ -1194,9 +1444,9 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 					if (res == ATDECODE_GOTFRAME) {
 #ifdef USE_FFMPEG
 						// got a frame
-						int skipped = std::min(skipSamples, atrac->frame_->nb_samples);
+						int skipped = std::min(skipSamples, atrac->decodedSamples_);
 						skipSamples -= skipped;
-						numSamples = atrac->frame_->nb_samples - skipped;
+						numSamples = atrac->decodedSamples_ - skipped;
 
 						// If we're at the end, clamp to samples we want.  It always returns a full chunk.
 						numSamples = std::min(maxSamples, numSamples);
@@ -1209,15 +1459,15 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 						if (outbuf != NULL && numSamples != 0) {
 							int inbufOffset = 0;
 							if (skipped != 0) {
-								AVSampleFormat fmt = (AVSampleFormat)atrac->frame_->format;
+								AVSampleFormat fmt = atrac->decodedFormat_;
 								// We want the offset per channel.
 								inbufOffset = av_samples_get_buffer_size(NULL, 1, skipped, fmt, 1);
 							}
 
 							u8 *out = outbuf;
 							const u8 *inbuf[2] = {
-								atrac->frame_->extended_data[0] + inbufOffset,
-								atrac->frame_->extended_data[1] + inbufOffset,
+								atrac->decodedData_[0] + inbufOffset,
+								atrac->decodedData_[1] + inbufOffset,
 							};
 							int avret = swr_convert(atrac->swrCtx_, &out, numSamples, inbuf, numSamples);
 							if (outbufPtr != 0) {
@@ -1286,6 +1536,11 @@ u32 _AtracDecodeData(int atracID, u8 *outbuf, u32 outbufPtr, u32 *SamplesNum, u3
 
 			*finish = finishFlag;
 			*remains = atrac->RemainingFrames();
+
+#ifdef USE_FFMPEG
+			// Get the next frames ready while the game does other things.
+			atrac->DecodeAhead();
+#endif
 		}
 		if (atrac->context_.IsValid()) {
 			// refresh context_
@@ -1756,6 +2011,7 @@ static u32 sceAtracResetPlayPosition(int atracID, int sample, int bytesWrittenFi
 static int __AtracUpdateOutputMode(Atrac *atrac, int wanted_channels) {
 	if (atrac->swrCtx_ && atrac->outputChannels_ == wanted_channels)
 		return 0;
+	atrac->WaitForDecodeAhead();
 	atrac->outputChannels_ = wanted_channels;
 	int64_t wanted_channel_layout = av_get_default_channel_layout(wanted_channels);
 	int64_t dec_channel_layout = av_get_default_channel_layout(atrac->channels_);
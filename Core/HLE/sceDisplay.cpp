@@ -46,6 +46,7 @@
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceKernelThread.h"
 #include "Core/HLE/sceKernelInterrupt.h"
+#include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/Util/PPGeDraw.h"
 
 #include "GPU/GPU.h"
@@ -493,16 +494,22 @@ void __DisplayGetDebugStats(char *stats, size_t bufsize) {
 	char statbuf[4096];
 	gpu->GetStats(statbuf, sizeof(statbuf));
 
+	char cachebuf[64] = "";
+	const float cacheProgress = PSP_GetFileCacheProgress();
+	if (cacheProgress >= 0.0f) {
+		snprintf(cachebuf, sizeof(cachebuf), "Game loaded into RAM: %d%%\n", (int)(cacheProgress * 100.0f));
+	}
+
 	snprintf(stats, bufsize,
 		"Kernel processing time: %0.2f ms\n"
 		"Slowest syscall: %s : %0.2f ms\n"
-		"Most active syscall: %s : %0.2f ms\n%s",
+		"Most active syscall: %s : %0.2f ms\n%s%s",
 		kernelStats.msInSyscalls * 1000.0f,
 		kernelStats.slowestSyscallName ? kernelStats.slowestSyscallName : "(none)",
 		kernelStats.slowestSyscallTime * 1000.0f,
 		kernelStats.summedSlowestSyscallName ? kernelStats.summedSlowestSyscallName : "(none)",
 		kernelStats.summedSlowestSyscallTime * 1000.0f,
-		statbuf);
+		cachebuf, statbuf);
 }
 
 
@@ -691,6 +698,7 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 	int vbCount = userdata;
 
 	VERBOSE_LOG(SCEDISPLAY, "Enter VBlank %i", vbCount);
+	Core_NotifyFrame();
 
 	isVblank = 1;
 	vCount++; // vCount increases at each VBLANK.
@@ -726,6 +734,9 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 	numVBlanks++;
 	numVBlanksSinceFlip++;
 
+	// Catch up on function precompiles queued at module load, a little each frame.
+	MIPSAnalyst::PrecompilePendingFunctions(0.002);
+
 	// TODO: Should this be done here or in hleLeaveVblank?
 	if (framebufIsLatched) {
 		DEBUG_LOG(SCEDISPLAY, "Setting latched framebuffer %08x (prev: %08x)", latchedFramebuf.topaddr, framebuf.topaddr);
@@ -32,6 +32,7 @@
 #include "Core/Debugger/Breakpoints.h"
 #include "Core/ELF/ParamSFO.h"
 #include "Core/MemMapHelpers.h"
+#include "Core/MemWriteTracker.h"
 #include "Core/System.h"
 #include "Core/HDRemaster.h"
 #include "Core/Host.h"
@@ -735,6 +736,10 @@ void __IoDoState(PointerWrap &p) {
 	}
 }
 
+void __IoSyncThread() {
+	ioManager.SyncThread();
+}
+
 void __IoShutdown() {
 	ioManagerThreadEnabled = false;
 	ioManager.SyncThread();
@@ -1029,6 +1034,7 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 			CBreakPoints::ExecMemCheck(data_addr, true, size, currentMIPS->pc);
 			u8 *data = (u8*) Memory::GetPointer(data_addr);
 			if (f->npdrm) {
+				Memory::WriteTracker_NotifyWrite(data_addr, size);
 				result = npdrmRead(f, data, size);
 				currentMIPS->InvalidateICache(data_addr, size);
 				return true;
@@ -1051,6 +1057,8 @@ static bool __IoRead(int &result, int id, u32 data_addr, int size, int &us) {
 				ioManager.ScheduleOperation(ev);
 				return false;
 			} else {
+				// The read may happen directly in the OS, which would fail rather than fault on watched pages.
+				Memory::WriteTracker_NotifyWrite(data_addr, size);
 				if (GetIOTimingMethod() != IOTIMING_REALISTIC) {
 					result = (int) pspFileSystem.ReadFile(f->handle, data, size);
 				} else {
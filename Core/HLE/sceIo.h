@@ -25,6 +25,8 @@ class KernelObject;
 void __IoInit();
 void __IoDoState(PointerWrap &p);
 void __IoShutdown();
+// Waits for any async reads and writes in flight to finish.
+void __IoSyncThread();
 
 struct ScePspDateTime;
 
@@ -1878,11 +1878,13 @@ void __KernelGPUReplay() {
 	}
 
 	std::string filename(filenamep, currentMIPS->r[MIPS_REG_S0]);
-	if (!GPURecord::RunMountedReplay(filename)) {
+	bool lastFrame = true;
+	if (!GPURecord::RunMountedReplay(filename, &lastFrame)) {
 		Core_Stop();
 	}
 
-	if (PSP_CoreParameter().headLess && !PSP_CoreParameter().startBreak) {
+	// With multiple frames, screenshot the final one.
+	if (PSP_CoreParameter().headLess && !PSP_CoreParameter().startBreak && lastFrame) {
 		PSPPointer<u8> topaddr;
 		u32 linesize = 512;
 		__DisplayGetFramebuf(&topaddr, &linesize, nullptr, 0);
@@ -26,6 +26,7 @@
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #include "Core/HW/AsyncIOManager.h"
+#include "Core/MemWriteTracker.h"
 #include "Core/FileSystems/MetaFileSystem.h"
 
 bool AsyncIOManager::HasOperation(u32 handle) {
@@ -130,6 +131,8 @@ void AsyncIOManager::ProcessEvent(AsyncIOEvent ev) {
 
 void AsyncIOManager::Read(u32 handle, u8 *buf, size_t bytes, u32 invalidateAddr) {
 	int usec = 0;
+	// On this thread right before the read, since the OS would fail rather than fault on watched pages.
+	Memory::WriteTracker_NotifyHostWrite(buf, (u32)bytes);
 	s64 result = pspFileSystem.ReadFile(handle, buf, bytes, usec);
 	EventResult(handle, AsyncIOResult(result, usec, invalidateAddr));
 }
@@ -2348,6 +2348,10 @@ namespace MIPSComp
 		fpr.ReleaseSpillLocksAndDiscardTemps();
 	}
 
+	void ArmJit::Comp_Vsocp(MIPSOpcode op) {
+		DISABLE;
+	}
+
 	void ArmJit::Comp_ColorConv(MIPSOpcode op) {
 		DISABLE;
 	}
@@ -124,6 +124,7 @@ class ArmJit : public ArmGen::ARMXCodeBlock, public JitInterface, public MIPSFro
 	void Comp_VCrossQuat(MIPSOpcode op) override;
 	void Comp_Vsgn(MIPSOpcode op) override;
 	void Comp_Vocp(MIPSOpcode op) override;
+	void Comp_Vsocp(MIPSOpcode op) override;
 	void Comp_ColorConv(MIPSOpcode op) override;
 	void Comp_Vbfy(MIPSOpcode op) override;
 
@@ -2015,6 +2015,10 @@ namespace MIPSComp {
 		fpr.ReleaseSpillLocksAndDiscardTemps();
 	}
 
+	void Arm64Jit::Comp_Vsocp(MIPSOpcode op) {
+		DISABLE;
+	}
+
 	void Arm64Jit::Comp_ColorConv(MIPSOpcode op) {
 		DISABLE;
 	}
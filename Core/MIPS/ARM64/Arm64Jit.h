@@ -125,6 +125,7 @@ class Arm64Jit : public Arm64Gen::ARM64CodeBlock, public JitInterface, public MI
 	void Comp_VCrossQuat(MIPSOpcode op) override;
 	void Comp_Vsgn(MIPSOpcode op) override;
 	void Comp_Vocp(MIPSOpcode op) override;
+	void Comp_Vsocp(MIPSOpcode op) override;
 	void Comp_ColorConv(MIPSOpcode op) override;
 	void Comp_Vbfy(MIPSOpcode op) override;
 
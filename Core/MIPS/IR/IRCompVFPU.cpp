@@ -1090,9 +1090,19 @@ namespace MIPSComp {
 		switch (GetMatrixOverlap(vs, vd, sz)) {
 		case OVERLAP_EQUAL:
 			// In-place transpose
-			DISABLE;
 		case OVERLAP_PARTIAL:
-			DISABLE;
+			// There are exactly enough temps to hold a 4x4 matrix.
+			for (int a = 0; a < n; a++) {
+				for (int b = 0; b < n; b++) {
+					ir.Write(IROp::FMov, IRVTEMP_PFX_S + a * 4 + b, sregs[a * 4 + b]);
+				}
+			}
+			for (int a = 0; a < n; a++) {
+				for (int b = 0; b < n; b++) {
+					ir.Write(IROp::FMov, dregs[a * 4 + b], IRVTEMP_PFX_S + a * 4 + b);
+				}
+			}
+			return;
 		case OVERLAP_NONE:
 		default:
 			break;
@@ -1137,12 +1147,6 @@ namespace MIPSComp {
 		int vt = _VT;
 
 		MatrixSize sz = GetMtxSize(op);
-		if (sz != M_4x4) {
-			DISABLE;
-		}
-		if (GetMtx(vt) == GetMtx(vd)) {
-			DISABLE;
-		}
 		int n = GetMatrixSide(sz);
 
 		// The entire matrix is scaled equally, so transpose doesn't matter.  Let's normalize.
@@ -1150,7 +1154,10 @@ namespace MIPSComp {
 			vs = TransposeMatrixReg(vs);
 			vd = TransposeMatrixReg(vd);
 		}
-		if (IsMatrixTransposed(vs) || IsMatrixTransposed(vd)) {
+
+		MatrixOverlapType overlap = vs == vd ? OVERLAP_NONE : GetMatrixOverlap(vs, vd, sz);
+		if (overlap != OVERLAP_NONE && n == 4) {
+			// Not enough temps for the whole result.
 			DISABLE;
 		}
 
@@ -1159,8 +1166,32 @@ namespace MIPSComp {
 		GetMatrixRegs(dregs, sz, vd);
 		GetVectorRegs(tregs, V_Single, vt);
 
-		for (int i = 0; i < n; ++i) {
-			ir.Write(IROp::Vec4Scale, dregs[i * 4], sregs[i * 4], tregs[0]);
+		int treg = tregs[0];
+		if (GetMtx(vt) == GetMtx(vd)) {
+			// The scale may get overwritten partway through, keep a copy.
+			treg = IRVTEMP_0 + 3;
+			ir.Write(IROp::FMov, treg, tregs[0]);
+		}
+
+		if (sz == M_4x4 && !IsMatrixTransposed(vs) && !IsMatrixTransposed(vd)) {
+			for (int i = 0; i < n; ++i) {
+				ir.Write(IROp::Vec4Scale, dregs[i * 4], sregs[i * 4], treg);
+			}
+			return;
+		}
+
+		for (int a = 0; a < n; a++) {
+			for (int b = 0; b < n; b++) {
+				int dreg = overlap != OVERLAP_NONE ? IRVTEMP_PFX_S + a * 4 + b : dregs[a * 4 + b];
+				ir.Write(IROp::FMul, dreg, sregs[a * 4 + b], treg);
+			}
+		}
+		if (overlap != OVERLAP_NONE) {
+			for (int a = 0; a < n; a++) {
+				for (int b = 0; b < n; b++) {
+					ir.Write(IROp::FMov, dregs[a * 4 + b], IRVTEMP_PFX_S + a * 4 + b);
+				}
+			}
 		}
 	}
 
@@ -1278,10 +1309,15 @@ namespace MIPSComp {
 		GetMatrixRegs(tregs, sz, vt);
 		GetMatrixRegs(dregs, sz, vd);
 
-		if (soverlap || toverlap) {
+		bool overlap = soverlap != OVERLAP_NONE || toverlap != OVERLAP_NONE;
+		if (overlap && n == 4) {
+			// Not enough temps for the whole result.
 			DISABLE;
 		}
 
+		// The interpreter starts each sum from +0.0, which only matters to turn a -0.0 into +0.0.
+		// Adding +0.0 at the end does the same thing.
+
 		// dregs are always consecutive, thanks to our transpose trick.
 		// However, not sure this is always worth it.
 		if (sz == M_4x4 && IsConsecutive4(dregs)) {
@@ -1289,6 +1325,10 @@ namespace MIPSComp {
 			// expand them like this as needed on "real" architectures.
 			int s0 = IRVTEMP_0;
 			int s1 = IRVTEMP_PFX_T;
+			int zero = IRVTEMP_PFX_S;
+			if (!IsConsecutive4(sregs) || IsConsecutive4(tregs)) {
+				ir.Write(IROp::Vec4Init, zero, (int)Vec4Init::AllZERO);
+			}
 			if (!IsConsecutive4(sregs)) {
 				// METHOD 1: Handles AbC and Abc
 				for (int j = 0; j < 4; j++) {
@@ -1297,7 +1337,7 @@ namespace MIPSComp {
 						ir.Write(IROp::Vec4Scale, s1, sregs[i], tregs[j * 4 + i]);
 						ir.Write(IROp::Vec4Add, s0, s0, s1);
 					}
-					ir.Write(IROp::Vec4Mov, dregs[j * 4], s0);
+					ir.Write(IROp::Vec4Add, dregs[j * 4], s0, zero);
 				}
 				return;
 			} else if (IsConsecutive4(tregs)) {
@@ -1308,7 +1348,7 @@ namespace MIPSComp {
 					for (int i = 0; i < 4; i++) {
 						ir.Write(IROp::Vec4Dot, s0 + i, sregs[i * 4], tregs[j * 4]);
 					}
-					ir.Write(IROp::Vec4Mov, dregs[j * 4], s0);
+					ir.Write(IROp::Vec4Add, dregs[j * 4], s0, zero);
 				}
 				return;
 			} else {
@@ -1321,12 +1361,26 @@ namespace MIPSComp {
 		// Fallback. Expands a LOT
 		int temp0 = IRVTEMP_0;
 		int temp1 = IRVTEMP_0 + 1;
+		int zero = IRVTEMP_0 + 2;
+		ir.Write(IROp::SetConstF, zero, ir.AddConstantFloat(0.0f));
 		for (int a = 0; a < n; a++) {
 			for (int b = 0; b < n; b++) {
+				// With overlap, n < 4, so the result fits in temps before zero.
+				int dreg = overlap ? IRVTEMP_PFX_S + a * 4 + b : dregs[a * 4 + b];
 				ir.Write(IROp::FMul, temp0, sregs[b * 4], tregs[a * 4]);
 				for (int c = 1; c < n; c++) {
 					ir.Write(IROp::FMul, temp1, sregs[b * 4 + c], tregs[a * 4 + c]);
-					ir.Write(IROp::FAdd, (c == n - 1) ? dregs[a * 4 + b] : temp0, temp0, temp1);
+					ir.Write(IROp::FAdd, temp0, temp0, temp1);
+				}
+				// For the last element the interpreter sums all four lanes, but the rest are zero anyway.
+				ir.Write(IROp::FAdd, dreg, temp0, zero);
+			}
+		}
+
+		if (overlap) {
+			for (int a = 0; a < n; a++) {
+				for (int b = 0; b < n; b++) {
+					ir.Write(IROp::FMov, dregs[a * 4 + b], IRVTEMP_PFX_S + a * 4 + b);
 				}
 			}
 		}
@@ -1389,35 +1443,17 @@ namespace MIPSComp {
 				}
 			}
 			return;
-		} else if (msz == M_4x4 && IsConsecutive4(sregs)) {
-			// Consecutive, which is harder.
-			DISABLE;
-			int s0 = IRVTEMP_0;
-			int s1 = IRVTEMP_PFX_S;
-			// Doesn't make complete sense to me why this works.... (because it doesn't.)
-			ir.Write(IROp::Vec4Scale, s0, sregs[0], tregs[0]);
-			for (int i = 1; i < 4; i++) {
-				if (!homogenous || (i != n - 1)) {
-					ir.Write(IROp::Vec4Scale, s1, sregs[i], tregs[i]);
-					ir.Write(IROp::Vec4Add, s0, s0, s1);
-				} else {
-					ir.Write(IROp::Vec4Add, s0, s0, sregs[i]);
-				}
-			}
-			if (IsConsecutive4(dregs)) {
-				ir.Write(IROp::Vec4Mov, dregs[0], s0);
-			} else {
-				for (int i = 0; i < 4; i++) {
-					ir.Write(IROp::FMov, dregs[i], s0 + i);
-				}
-			}
-			return;
 		}
 
-		// TODO: test overlap, optimize.
+		// Consecutive rows would need horizontal adds, which don't round like the interpreter.
+		// So they take the slow path too.  Results go in temps, so overlap is fine.
 		u8 tempregs[4];
 		int s0 = IRVTEMP_0;
 		int temp1 = IRVTEMP_0 + 1;
+		int zero = IRVTEMP_0 + 2;
+		if (n < 4) {
+			ir.Write(IROp::SetConstF, zero, ir.AddConstantFloat(0.0f));
+		}
 		for (int i = 0; i < n; i++) {
 			ir.Write(IROp::FMul, s0, sregs[i * 4], tregs[0]);
 			for (int k = 1; k < n; k++) {
@@ -1429,7 +1465,12 @@ namespace MIPSComp {
 				}
 			}
 			int temp = IRVTEMP_PFX_T + i;
-			ir.Write(IROp::FMov, temp, s0);
+			if (i == n - 1 && n < 4) {
+				// The last row always sums all four lanes, and the unused +0.0s can change a -0.0.
+				ir.Write(IROp::FAdd, temp, s0, zero);
+			} else {
+				ir.Write(IROp::FMov, temp, s0);
+			}
 			tempregs[i] = temp;
 		}
 		for (int i = 0; i < n; i++) {
@@ -1449,12 +1490,40 @@ namespace MIPSComp {
 		// To do a full cross product: vcrs tmp1, s, t; vcrs tmp2 t, s; vsub d, tmp1, tmp2;
 		// (or just use vcrsp.)
 
-		DISABLE;
+		VectorSize sz = GetVecSize(op);
+		if (sz != V_Triple) {
+			// Other sizes swizzle in constants.
+			DISABLE;
+		}
+
+		u8 sregs[4], tregs[4], dregs[4];
+		GetVectorRegs(sregs, sz, _VS);
+		GetVectorRegs(tregs, sz, _VT);
+		GetVectorRegsPrefixD(dregs, sz, _VD);
+
+		u8 tempregs[4];
+		for (int i = 0; i < 3; ++i) {
+			if (!IsOverlapSafe(dregs[i], 3, sregs, 3, tregs)) {
+				tempregs[i] = IRVTEMP_0 + i;
+			} else {
+				tempregs[i] = dregs[i];
+			}
+		}
+
+		ir.Write(IROp::FMul, tempregs[0], sregs[1], tregs[2]);
+		ir.Write(IROp::FMul, tempregs[1], sregs[2], tregs[0]);
+		ir.Write(IROp::FMul, tempregs[2], sregs[0], tregs[1]);
+
+		for (int i = 0; i < 3; i++) {
+			if (tempregs[i] != dregs[i])
+				ir.Write(IROp::FMov, dregs[i], tempregs[i]);
+		}
+		ApplyPrefixD(dregs, sz);
 	}
 
 	void IRFrontend::Comp_VDet(MIPSOpcode op) {
 		CONDITIONAL_DISABLE(VFPU_VEC);
-		if (js.HasUnknownPrefix() || !IsPrefixWithinSize(js.prefixS, op) || (js.prefixT & 0x000CFCF0) != 0x000E0) {
+		if (js.HasUnknownPrefix() || js.HasSPrefix() || js.HasTPrefix()) {
 			DISABLE;
 		}
 
@@ -1462,7 +1531,25 @@ namespace MIPSComp {
 		// d[0] = s[0]*t[1] - s[1]*t[0]
 		// Note: this operates on two vectors, not a 2x2 matrix.
 
-		DISABLE;
+		VectorSize sz = GetVecSize(op);
+		if (sz != V_Pair) {
+			DISABLE;
+		}
+
+		u8 sregs[4], tregs[4], dreg;
+		GetVectorRegs(sregs, sz, _VS);
+		GetVectorRegs(tregs, sz, _VT);
+		GetVectorRegsPrefixD(&dreg, V_Single, _VD);
+
+		int temp0 = IRVTEMP_0;
+		int temp1 = IRVTEMP_0 + 1;
+		ir.Write(IROp::FMul, temp0, sregs[0], tregs[1]);
+		ir.Write(IROp::FMul, temp1, sregs[1], tregs[0]);
+		ir.Write(IROp::FSub, temp0, temp0, temp1);
+		// The z and w lanes are summed in too, +0.0 changes a -0.0 result.
+		ir.Write(IROp::SetConstF, temp1, ir.AddConstantFloat(0.0f));
+		ir.Write(IROp::FAdd, dreg, temp0, temp1);
+		ApplyPrefixD(&dreg, V_Single);
 	}
 
 	void IRFrontend::Comp_Vi2x(MIPSOpcode op) {
@@ -1648,6 +1735,42 @@ namespace MIPSComp {
 		ApplyPrefixD(dregs, outsize);
 	}
 
+	enum class ProductSign {
+		ADD,
+		SUB,
+		// Negate the operand, not the product, or NaN signs won't match the interpreter.
+		NEG_S,
+		NEG_T,
+	};
+
+	struct ProductTerm {
+		u8 sreg;
+		u8 treg;
+		ProductSign sign;
+	};
+
+	// Sums four products in order, the way the interpreter spells it out.
+	static void WriteProductSum(IRWriter &ir, int dreg, const ProductTerm terms[4]) {
+		int sum = IRVTEMP_0;
+		int product = IRVTEMP_0 + 1;
+		for (int i = 0; i < 4; i++) {
+			const ProductTerm &term = terms[i];
+			int dest = i == 0 ? sum : product;
+			if (term.sign == ProductSign::NEG_S) {
+				ir.Write(IROp::FNeg, dest, term.sreg);
+				ir.Write(IROp::FMul, dest, dest, term.treg);
+			} else if (term.sign == ProductSign::NEG_T) {
+				ir.Write(IROp::FNeg, dest, term.treg);
+				ir.Write(IROp::FMul, dest, term.sreg, dest);
+			} else {
+				ir.Write(IROp::FMul, dest, term.sreg, term.treg);
+			}
+			if (i != 0) {
+				ir.Write(term.sign == ProductSign::SUB ? IROp::FSub : IROp::FAdd, i == 3 ? dreg : sum, sum, product);
+			}
+		}
+	}
+
 	void IRFrontend::Comp_VCrossQuat(MIPSOpcode op) {
 		CONDITIONAL_DISABLE(VFPU_VEC);
 		if (!js.HasNoPrefix())
@@ -1690,12 +1813,31 @@ namespace MIPSComp {
 			ir.Write(IROp::FMul, temp1, sregs[0], tregs[2]);
 			ir.Write(IROp::FSub, tempregs[1], temp0, temp1);
 
-			// Compute Z
-			ir.Write(IROp::FMul, temp0, sregs[0], tregs[1]);
-			ir.Write(IROp::FMul, temp1, sregs[1], tregs[0]);
-			ir.Write(IROp::FSub, tempregs[2], temp0, temp1);
+			// Compute Z.  This is really a dot with the unused lanes, which can turn -0.0 into +0.0.
+			const u8 zero = IRVTEMP_0 + 2;
+			ir.Write(IROp::SetConstF, zero, ir.AddConstantFloat(0.0f));
+			const ProductTerm termsZ[4] = {
+				{ sregs[0], tregs[1], ProductSign::ADD },
+				{ sregs[1], tregs[0], ProductSign::NEG_T },
+				{ sregs[2], zero, ProductSign::ADD },
+				{ zero, tregs[2], ProductSign::ADD },
+			};
+			WriteProductSum(ir, tempregs[2], termsZ);
 		} else if (sz == V_Quad) {
-			DISABLE;
+			// Summed in the same order as the interpreter, so the rounding matches.
+			const u8 *s = sregs;
+			const u8 *t = tregs;
+			const ProductSign ADD = ProductSign::ADD, SUB = ProductSign::SUB;
+			const ProductSign NEG_S = ProductSign::NEG_S, NEG_T = ProductSign::NEG_T;
+			const ProductTerm terms[4][4] = {
+				{ { s[0], t[3], ADD }, { s[1], t[2], ADD }, { s[2], t[1], SUB }, { s[3], t[0], ADD } },
+				{ { s[0], t[2], NEG_S }, { s[1], t[3], ADD }, { s[2], t[0], ADD }, { s[3], t[1], ADD } },
+				{ { s[0], t[1], ADD }, { s[1], t[0], SUB }, { s[2], t[3], ADD }, { s[3], t[2], ADD } },
+				{ { s[0], t[0], NEG_T }, { s[1], t[1], NEG_T }, { s[2], t[2], NEG_T }, { s[3], t[3], ADD } },
+			};
+			for (int i = 0; i < 4; i++) {
+				WriteProductSum(ir, tempregs[i], terms[i]);
+			}
 		} else {
 			DISABLE;
 		}
@@ -1961,6 +2103,41 @@ namespace MIPSComp {
 		ApplyPrefixD(dregs, sz);
 	}
 
+	void IRFrontend::Comp_Vsocp(MIPSOpcode op) {
+		CONDITIONAL_DISABLE(VFPU_VEC);
+		if (!js.HasNoPrefix()) {
+			// The prefixes are rewritten (see Int_Vsocp), not worth it.
+			DISABLE;
+		}
+
+		// Vector saturated one's complement, doubling the size
+		// d[N*2] = clamp(1.0 + -s[N], 0, 1), d[N*2+1] = clamp(0.0 + s[N], 0, 1)
+
+		VectorSize sz = GetVecSize(op);
+		if (sz != V_Single && sz != V_Pair) {
+			// Larger sizes read only two lanes and write a quad, rare enough to leave alone.
+			DISABLE;
+		}
+		VectorSize outSize = GetDoubleVectorSize(sz);
+		int n = GetNumVectorElements(sz);
+
+		u8 sregs[2], dregs[4];
+		GetVectorRegs(sregs, sz, _VS);
+		GetVectorRegs(dregs, outSize, _VD);
+
+		// Same operations and order as the interpreter's t + s, so NaN signs match too.
+		ir.Write(IROp::SetConstF, IRVTEMP_PFX_T + 0, ir.AddConstantFloat(1.0f));
+		ir.Write(IROp::SetConstF, IRVTEMP_PFX_T + 1, ir.AddConstantFloat(0.0f));
+		for (int i = 0; i < n; ++i) {
+			ir.Write(IROp::FNeg, IRVTEMP_PFX_S + i, sregs[i]);
+			ir.Write(IROp::FAdd, IRVTEMP_0 + i * 2 + 0, IRVTEMP_PFX_T + 0, IRVTEMP_PFX_S + i);
+			ir.Write(IROp::FAdd, IRVTEMP_0 + i * 2 + 1, IRVTEMP_PFX_T + 1, sregs[i]);
+		}
+		for (int i = 0; i < n * 2; ++i) {
+			ir.Write(IROp::FSat0_1, dregs[i], IRVTEMP_0 + i);
+		}
+	}
+
 	void IRFrontend::Comp_ColorConv(MIPSOpcode op) {
 		CONDITIONAL_DISABLE(VFPU_VEC);
 		if (js.HasUnknownPrefix() || !IsPrefixWithinSize(js.prefixS, op) || js.HasTPrefix()) {
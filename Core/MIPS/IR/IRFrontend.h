@@ -81,6 +81,7 @@ class IRFrontend : public MIPSFrontendInterface {
 	void Comp_VCrossQuat(MIPSOpcode op) override;
 	void Comp_Vsgn(MIPSOpcode op) override;
 	void Comp_Vocp(MIPSOpcode op) override;
+	void Comp_Vsocp(MIPSOpcode op) override;
 	void Comp_ColorConv(MIPSOpcode op) override;
 	void Comp_Vbfy(MIPSOpcode op) override;
 
@@ -110,6 +110,7 @@ namespace MIPSComp {
 		virtual void Comp_VCrossQuat(MIPSOpcode op) = 0;
 		virtual void Comp_Vsgn(MIPSOpcode op) = 0;
 		virtual void Comp_Vocp(MIPSOpcode op) = 0;
+		virtual void Comp_Vsocp(MIPSOpcode op) = 0;
 		virtual void Comp_ColorConv(MIPSOpcode op) = 0;
 		virtual void Comp_Vbfy(MIPSOpcode op) = 0;
 		virtual void Comp_DoNothing(MIPSOpcode op) = 0;
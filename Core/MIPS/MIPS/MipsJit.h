@@ -123,6 +123,7 @@ class MipsJit : public MIPSGen::MIPSCodeBlock, public JitInterface, public MIPSF
 	void Comp_VCrossQuat(MIPSOpcode op) override {}
 	void Comp_Vsgn(MIPSOpcode op) override {}
 	void Comp_Vocp(MIPSOpcode op) override {}
+	void Comp_Vsocp(MIPSOpcode op) override {}
 	void Comp_ColorConv(MIPSOpcode op) override {}
 	int Replace_fabsf() override { return 0; }
 
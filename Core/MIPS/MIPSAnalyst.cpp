@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <unordered_map>
@@ -30,6 +31,7 @@
 #include "Core/Config.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
+#include "Core/ThreadPools.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 #include "Core/MIPS/MIPSTables.h"
@@ -50,6 +52,11 @@ std::recursive_mutex functions_lock;
 // the same hash and should all be replaced if possible.
 static std::unordered_multimap<u64, MIPSAnalyst::AnalyzedFunction *> hashToFunction;
 
+// Functions PrecompileFunctions() queued up, compiled a bit at a time on the emu thread.
+static std::vector<std::pair<u32, u32>> pendingPrecompiles;
+static size_t pendingPrecompilePos = 0;
+static double pendingPrecompileTime = 0.0;
+
 struct HashMapFunc {
 	char name[64];
 	u64 hash;
@@ -751,6 +758,8 @@ namespace MIPSAnalyst {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 		functions.clear();
 		hashToFunction.clear();
+		pendingPrecompiles.clear();
+		pendingPrecompilePos = 0;
 	}
 
 	void UpdateHashToFunctionMap() {
@@ -875,45 +884,60 @@ namespace MIPSAnalyst {
 		return DetermineRegisterUsage(reg, addr, instrs) == USAGE_CLOBBERED;
 	}
 
-	void HashFunctions() {
-		std::lock_guard<std::recursive_mutex> guard(functions_lock);
-		std::vector<u32> buffer;
+	static void HashFunction(AnalyzedFunction &f, std::vector<u32> &buffer) {
+		if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
+			return;
+		}
 
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			AnalyzedFunction &f = *iter;
-			if (!Memory::IsValidRange(f.start, f.end - f.start + 4)) {
-				continue;
+		// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
+		buffer.resize((f.end - f.start + 4) / 4);
+		size_t pos = 0;
+		for (u32 addr = f.start; addr <= f.end; addr += 4) {
+			u32 validbits = 0xFFFFFFFF;
+			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
+			if (MIPS_IS_EMUHACK(instr)) {
+				f.hasHash = false;
+				return;
 			}
 
-			// This is unfortunate.  In case of emuhacks or relocs, we have to make a copy.
-			buffer.resize((f.end - f.start + 4) / 4);
-			size_t pos = 0;
-			for (u32 addr = f.start; addr <= f.end; addr += 4) {
-				u32 validbits = 0xFFFFFFFF;
-				MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr, true);
-				if (MIPS_IS_EMUHACK(instr)) {
-					f.hasHash = false;
-					goto skip;
-				}
+			MIPSInfo flags = MIPSGetInfo(instr);
+			if (flags & IN_IMM16)
+				validbits &= ~0xFFFF;
+			if (flags & IN_IMM26)
+				validbits &= ~0x03FFFFFF;
+			buffer[pos++] = instr & validbits;
+		}
 
-				MIPSInfo flags = MIPSGetInfo(instr);
-				if (flags & IN_IMM16)
-					validbits &= ~0xFFFF;
-				if (flags & IN_IMM26)
-					validbits &= ~0x03FFFFFF;
-				buffer[pos++] = instr & validbits;
-			}
+		f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
+		f.hasHash = true;
+	}
+
+	void HashFunctions() {
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 
-			f.hash = CityHash64((const char *) &buffer[0], buffer.size() * sizeof(u32));
-			f.hasHash = true;
-skip:
-			;
+		// Not worth waking up threads for a handful (like from RegisterFunction.)
+		static const int MIN_PARALLEL_FUNCTIONS = 256;
+		const int count = (int)functions.size();
+		auto hashRange = [](int lower, int upper) {
+			std::vector<u32> buffer;
+			for (int i = lower; i < upper; ++i) {
+				HashFunction(functions[i], buffer);
+			}
+		};
+
+		// Each function only touches its own entry, so the result is the same either way.
+		// The loading thread is blocked meanwhile, so memory won't change under us.
+		if (count >= MIN_PARALLEL_FUNCTIONS) {
+			GlobalThreadPool::Loop(hashRange, 0, count);
+		} else {
+			hashRange(0, count);
 		}
 	}
 
 	void PrecompileFunction(u32 startAddr, u32 length) {
 		// Direct calls to this ignore the bPreloadFunctions flag, since it's just for stubs.
-		if (MIPSComp::jit) {
+		// The range may have been unmapped since it was queued, so don't let the jit read it then.
+		if (MIPSComp::jit && length != 0 && Memory::IsValidRange(startAddr, length)) {
 			MIPSComp::jit->CompileFunction(startAddr, length);
 		}
 	}
@@ -926,15 +950,39 @@ namespace MIPSAnalyst {
 
 		// TODO: Load from cache file if available instead.
 
-		double st = time_now_d();
-		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
-			const AnalyzedFunction &f = *iter;
+		// Compiling everything here used to hold up the game start. Now we just queue them up
+		// and PrecompilePendingFunctions() gets through them while the game runs.
+		// Anything the game reaches first is compiled normally, and skipped later.
+		pendingPrecompiles.clear();
+		pendingPrecompiles.reserve(functions.size());
+		for (const AnalyzedFunction &f : functions) {
+			pendingPrecompiles.push_back(std::make_pair(f.start, f.end - f.start + 4));
+		}
+		pendingPrecompilePos = 0;
+		pendingPrecompileTime = 0.0;
+	}
 
-			PrecompileFunction(f.start, f.end - f.start + 4);
+	void PrecompilePendingFunctions(double budget) {
+		// The list changes under this lock too, so check it with the lock held.
+		std::lock_guard<std::recursive_mutex> guard(functions_lock);
+		if (pendingPrecompilePos >= pendingPrecompiles.size()) {
+			return;
 		}
-		double et = time_now_d();
 
-		NOTICE_LOG(JIT, "Precompiled %d MIPS functions in %0.2f milliseconds", (int)functions.size(), (et - st) * 1000.0);
+		double st = time_now_d();
+		double et = st;
+		while (pendingPrecompilePos < pendingPrecompiles.size() && et - st < budget) {
+			const auto &range = pendingPrecompiles[pendingPrecompilePos++];
+			PrecompileFunction(range.first, range.second);
+			et = time_now_d();
+		}
+		pendingPrecompileTime += et - st;
+
+		if (pendingPrecompilePos >= pendingPrecompiles.size()) {
+			NOTICE_LOG(JIT, "Precompiled %d MIPS functions in %0.2f milliseconds", (int)pendingPrecompiles.size(), pendingPrecompileTime * 1000.0);
+			pendingPrecompiles.clear();
+			pendingPrecompilePos = 0;
+		}
 	}
 
 	static const char *DefaultFunctionName(char buffer[256], u32 startAddr) {
@@ -1232,6 +1280,16 @@ namespace MIPSAnalyst {
 	void ForgetFunctions(u32 startAddr, u32 endAddr) {
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 
+		// Don't precompile anything from the unloaded module, the memory may be reused for another.
+		// Entries before pendingPrecompilePos were already compiled and don't matter.
+		if (pendingPrecompilePos < pendingPrecompiles.size()) {
+			auto overlaps = [&](const std::pair<u32, u32> &range) {
+				return range.first < endAddr && range.first + range.second > startAddr;
+			};
+			auto first = pendingPrecompiles.begin() + pendingPrecompilePos;
+			pendingPrecompiles.erase(std::remove_if(first, pendingPrecompiles.end(), overlaps), pendingPrecompiles.end());
+		}
+
 		// It makes sense to forget functions as modules are unloaded but it breaks
 		// the easy way of saving a hashmap by unloading and loading a game. I added
 		// an alternative way.
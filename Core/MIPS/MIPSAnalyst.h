@@ -109,8 +109,11 @@ namespace MIPSAnalyst
 	bool ScanForFunctions(u32 startAddr, u32 endAddr, bool insertSymbols);
 	void FinalizeScan(bool insertSymbols);
 	void ForgetFunctions(u32 startAddr, u32 endAddr);
+	// Queues all known functions for PrecompilePendingFunctions().
 	void PrecompileFunctions();
 	void PrecompileFunction(u32 startAddr, u32 length);
+	// Compiles queued functions until budget (in seconds) runs out.  Emu thread only, once per frame.
+	void PrecompilePendingFunctions(double budget);
 
 	void SetHashMapFilename(const std::string& filename = "");
 	void LoadBuiltinHashMap();
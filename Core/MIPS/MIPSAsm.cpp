@@ -9,7 +9,7 @@
 #include "Common/Data/Encoding/Utf8.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/MemMapHelpers.h"
-#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSAsm.h"
 
 namespace MIPSAsm
@@ -38,8 +38,7 @@ class PspAssemblerFile: public AssemblerFile
 		Memory::Memcpy((u32)address,data,(u32)length);
 		
 		// In case this is a delay slot or combined instruction, clear cache above it too.
-		if (MIPSComp::jit)
-			MIPSComp::jit->InvalidateCacheAt((u32)(address - 4),(int)length+4);
+		currentMIPS->InvalidateICache((u32)(address - 4), (int)length + 4);
 
 		address += length;
 		return true;
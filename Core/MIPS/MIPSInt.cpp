@@ -108,9 +108,7 @@ namespace MIPSInt
 		// Icache
 		case 8:
 			// Invalidate the instruction cache at this address
-			if (MIPSComp::jit) {
-				MIPSComp::jit->InvalidateCacheAt(addr, 0x40);
-			}
+			currentMIPS->InvalidateICache(addr, 0x40);
 			break;
 
 		// Dcache
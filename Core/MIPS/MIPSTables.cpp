@@ -15,6 +15,10 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
 #include "Core/Core.h"
 #include "Core/System.h"
 #include "Core/MemMap.h"
@@ -731,7 +735,7 @@ const MIPSInstruction tableVFPU9[32] = // 110100 00010 xxxxx . ....... . .......
 	INSTR("vbfy2", JITFUNC(Comp_Vbfy), Dis_Vbfy, Int_Vbfy, IN_OTHER|OUT_OTHER|IS_VFPU|OUT_EAT_PREFIX),
 	//4
 	INSTR("vocp", JITFUNC(Comp_Vocp), Dis_Vbfy, Int_Vocp, IN_OTHER|OUT_OTHER|IS_VFPU|OUT_EAT_PREFIX),  // one's complement
-	INSTR("vsocp", JITFUNC(Comp_Generic), Dis_Vbfy, Int_Vsocp, IN_OTHER|OUT_OTHER|IS_VFPU|OUT_EAT_PREFIX),
+	INSTR("vsocp", JITFUNC(Comp_Vsocp), Dis_Vbfy, Int_Vsocp, IN_OTHER|OUT_OTHER|IS_VFPU|OUT_EAT_PREFIX),
 	INSTR("vfad", JITFUNC(Comp_Vhoriz), Dis_Vfad, Int_Vfad, IN_OTHER|OUT_OTHER|IS_VFPU|OUT_EAT_PREFIX),
 	INSTR("vavg", JITFUNC(Comp_Vhoriz), Dis_Vfad, Int_Vavg, IN_OTHER|OUT_OTHER|IS_VFPU|OUT_EAT_PREFIX),
 	//8
@@ -952,6 +956,116 @@ void MIPSInterpret(MIPSOpcode op) {
 	}
 }
 
+// Interpreting used to mean walking the tables above for every single instruction executed.
+// Instead, we remember the handler per address, a page at a time.  Not every write to code goes
+// through InvalidateICache, so the opcode is still compared with memory before each use.
+struct PredecodedOp {
+	MIPSInterpretFunc func;
+	MIPSOpcode op;
+};
+
+static const int PREDECODE_PAGE_SHIFT = 12;
+static const u32 PREDECODE_PAGE_SIZE = 1 << PREDECODE_PAGE_SHIFT;
+static const u32 PREDECODE_PAGE_MASK = PREDECODE_PAGE_SIZE - 1;
+// Kernel and uncached mirrors all share the same code.
+static const u32 PREDECODE_ADDR_MASK = 0x3FFFFFFF;
+// 16 MB of decoded pages, for 4 MB of code.  Beyond that, we just start over.
+static const size_t MAX_PREDECODED_PAGES = 1024;
+
+struct PredecodedPage {
+	PredecodedOp ops[PREDECODE_PAGE_SIZE / 4];
+};
+
+static std::unordered_map<u32, std::unique_ptr<PredecodedPage>> predecodedPages;
+static u32 lastPredecodedPageNum = 0xFFFFFFFF;
+static PredecodedPage *lastPredecodedPage = nullptr;
+
+static PredecodedPage *GetPredecodedPage(u32 pc) {
+	const u32 pageNum = (pc & PREDECODE_ADDR_MASK) >> PREDECODE_PAGE_SHIFT;
+	if (pageNum == lastPredecodedPageNum)
+		return lastPredecodedPage;
+
+	auto it = predecodedPages.find(pageNum);
+	PredecodedPage *page;
+	if (it != predecodedPages.end()) {
+		page = it->second.get();
+	} else {
+		// Let the slow path report bad addresses, and don't cache them.
+		if (!Memory::IsValidAddress(pc))
+			return nullptr;
+		if (predecodedPages.size() >= MAX_PREDECODED_PAGES)
+			predecodedPages.clear();
+		// Value-initialized, so no handlers yet.
+		page = new PredecodedPage();
+		predecodedPages[pageNum].reset(page);
+	}
+
+	lastPredecodedPageNum = pageNum;
+	lastPredecodedPage = page;
+	return page;
+}
+
+static inline void MIPSInterpretAt(u32 pc) {
+	PredecodedPage *page = GetPredecodedPage(pc);
+	if (!page) {
+		MIPSInterpret(MIPSOpcode(Memory::Read_U32(pc)));
+		return;
+	}
+
+	PredecodedOp &entry = page->ops[(pc & PREDECODE_PAGE_MASK) >> 2];
+	const MIPSOpcode op = MIPSOpcode(Memory::Read_U32(pc));
+	if (!entry.func || entry.op.encoding != op.encoding) {
+		const MIPSInstruction *instr = MIPSGetInstruction(op);
+		if (!instr || !instr->interpret) {
+			MIPSInterpret(op);
+			return;
+		}
+		entry.op = op;
+		entry.func = instr->interpret;
+	}
+
+	// Copy first, the instruction itself might invalidate the cache (e.g. cache or syscall.)
+	const PredecodedOp decoded = entry;
+	decoded.func(decoded.op);
+}
+
+void MIPSInterpret_InvalidateCache(u32 address, int length) {
+	if (predecodedPages.empty() || length <= 0)
+		return;
+
+	const u32 start = (address & PREDECODE_ADDR_MASK) & ~3;
+	const u64 end = std::min((u64)start + (u32)length + 3, (u64)PREDECODE_ADDR_MASK + 1) & ~3ULL;
+	auto clearPage = [&](u32 pageNum, PredecodedPage *page) {
+		const u64 pageStart = (u64)pageNum << PREDECODE_PAGE_SHIFT;
+		const u64 clearStart = std::max((u64)start, pageStart);
+		const u64 clearEnd = std::min(end, pageStart + PREDECODE_PAGE_SIZE);
+		for (u64 addr = clearStart; addr < clearEnd; addr += 4) {
+			page->ops[(addr - pageStart) >> 2].func = nullptr;
+		}
+	};
+
+	const u32 firstPage = start >> PREDECODE_PAGE_SHIFT;
+	const u32 lastPage = (u32)((end - 1) >> PREDECODE_PAGE_SHIFT);
+	if (lastPage - firstPage + 1 > predecodedPages.size()) {
+		// Big range (like the whole address space), cheaper to just walk what we have.
+		for (auto &it : predecodedPages) {
+			clearPage(it.first, it.second.get());
+		}
+	} else {
+		for (u32 pageNum = firstPage; pageNum <= lastPage; ++pageNum) {
+			auto it = predecodedPages.find(pageNum);
+			if (it != predecodedPages.end())
+				clearPage(pageNum, it->second.get());
+		}
+	}
+}
+
+void MIPSInterpret_ClearCache() {
+	predecodedPages.clear();
+	lastPredecodedPageNum = 0xFFFFFFFF;
+	lastPredecodedPage = nullptr;
+}
+
 #define _RS   ((op>>21) & 0x1F)
 #define _RT   ((op>>16) & 0x1F)
 #define _RD   ((op>>11) & 0x1F)
@@ -972,20 +1086,6 @@ int MIPSInterpret_RunUntil(u64 globalTicks)
 			// int cycles = 0;
 			{
 				again:
-				MIPSOpcode op = MIPSOpcode(Memory::Read_U32(curMips->pc));
-				//MIPSOpcode op = Memory::Read_Opcode_JIT(mipsr4k.pc);
-				/*
-				// Choke on VFPU
-				MIPSInfo info = MIPSGetInfo(op);
-				if (info & IS_VFPU)
-				{
-					if (!Core_IsStepping() && !GetAsyncKeyState(VK_LSHIFT))
-					{
-						Core_EnableStepping(true);
-						return;
-					}
-				}*/
-
 		//2: check for breakpoint (VERY SLOW)
 #if defined(_DEBUG)
 				if (CBreakPoints::IsAddressBreakPoint(curMips->pc))
@@ -1014,7 +1114,7 @@ int MIPSInterpret_RunUntil(u64 globalTicks)
 				}
 				lastPC = curMips->pc;
 				*/
-				MIPSInterpret(op);
+				MIPSInterpretAt(curMips->pc);
 
 				if (curMips->inDelaySlot)
 				{
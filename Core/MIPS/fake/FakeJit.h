@@ -120,6 +120,7 @@ class FakeJit : public FakeGen::FakeXCodeBlock {
 	void Comp_VCrossQuat(MIPSOpcode op) {}
 	void Comp_Vsgn(MIPSOpcode op) {}
 	void Comp_Vocp(MIPSOpcode op) {}
+	void Comp_Vsocp(MIPSOpcode op) {}
 	void Comp_ColorConv(MIPSOpcode op) {}
 	void Comp_Vbfy(MIPSOpcode op) {}
 
@@ -3597,6 +3597,10 @@ void Jit::Comp_VRot(MIPSOpcode op) {
 	fpr.ReleaseSpillLocks();
 }
 
+void Jit::Comp_Vsocp(MIPSOpcode op) {
+	DISABLE;
+}
+
 void Jit::Comp_ColorConv(MIPSOpcode op) {
 	CONDITIONAL_DISABLE(VFPU_VEC);
 	if (js.HasUnknownPrefix())
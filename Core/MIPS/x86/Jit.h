@@ -133,6 +133,7 @@ class Jit : public Gen::XCodeBlock, public JitInterface, public MIPSFrontendInte
 	void Comp_VCrossQuat(MIPSOpcode op) override;
 	void Comp_Vsgn(MIPSOpcode op) override;
 	void Comp_Vocp(MIPSOpcode op) override;
+	void Comp_Vsocp(MIPSOpcode op) override;
 	void Comp_ColorConv(MIPSOpcode op) override;
 	void Comp_Vbfy(MIPSOpcode op) override;
 
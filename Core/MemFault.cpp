@@ -35,6 +35,7 @@
 #include "Core/Core.h"
 #include "Core/MemFault.h"
 #include "Core/MemMap.h"
+#include "Core/MemWriteTracker.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 
 namespace Memory {
@@ -86,6 +87,10 @@ bool HandleFault(uintptr_t hostAddress, void *ctx) {
 	SContext *context = (SContext *)ctx;
 	const uint8_t *codePtr = (uint8_t *)(context->CTX_PC);
 
+	// Writes to watched pages are expected from any code, and just need to be retried.
+	if (WriteTracker_HandleFault(hostAddress))
+		return true;
+
 	// We set this later if we think it can be resumed from.
 	g_lastCrashAddress = nullptr;
 
@@ -32,6 +32,7 @@
 
 #include "Core/MemMap.h"
 #include "Core/MemFault.h"
+#include "Core/MemWriteTracker.h"
 #include "Core/HDRemaster.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/HLE/HLE.h"
@@ -303,6 +304,7 @@ bool Init() {
 		base, m_pPhysicalRAM, m_pUncachedRAM);
 
 	MemFault_Init();
+	WriteTracker_Init();
 	return true;
 }
 
@@ -314,7 +316,7 @@ void Reinit() {
 	Core_NotifyLifecycle(CoreLifecycle::MEMORY_REINITED);
 }
 
-void DoState(PointerWrap &p) {
+void DoState(PointerWrap &p, bool includeRAM) {
 	auto s = p.Section("Memory", 1, 3);
 	if (!s)
 		return;
@@ -346,7 +348,11 @@ void DoState(PointerWrap &p) {
 		}
 	}
 
-	DoArray(p, GetPointer(PSP_GetKernelMemoryBase()), g_MemorySize);
+	if (includeRAM) {
+		if (p.mode == PointerWrap::MODE_READ)
+			WriteTracker_NotifyWrite(PSP_GetKernelMemoryBase(), g_MemorySize);
+		DoArray(p, GetPointer(PSP_GetKernelMemoryBase()), g_MemorySize);
+	}
 	p.DoMarker("RAM");
 
 	DoArray(p, m_pPhysicalVRAM1, VRAM_SIZE);
@@ -357,6 +363,7 @@ void DoState(PointerWrap &p) {
 
 void Shutdown() {
 	std::lock_guard<std::recursive_mutex> guard(g_shutdownLock);
+	WriteTracker_Shutdown();
 	u32 flags = 0;
 	MemoryMap_Shutdown(flags);
 	base = nullptr;
@@ -77,6 +77,8 @@ extern u8 *m_pVRAM;
 // 32-bit: Same as above
 extern u8 *m_pPhysicalRAM;
 extern u8 *m_pUncachedRAM;
+// May be null, on platforms that skip the kernel mirror.
+extern u8 *m_pKernelRAM;
 
 // This replaces RAM_NORMAL_SIZE at runtime.
 extern u32 g_MemorySize;
@@ -128,7 +130,8 @@ void MemoryMap_Shutdown(u32 flags);
 // Init and Shutdown
 bool Init();
 void Shutdown();
-void DoState(PointerWrap &p);
+// Rewind states may keep RAM separately, and skip it here.
+void DoState(PointerWrap &p, bool includeRAM = true);
 void Clear();
 // False when shutdown has already been called.
 bool IsActive();
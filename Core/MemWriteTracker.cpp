@@ -0,0 +1,256 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Common/Log.h"
+#include "Common/MachineContext.h"
+#include "Common/MemoryUtil.h"
+#include "Core/MemMap.h"
+#include "Core/MemWriteTracker.h"
+
+namespace Memory {
+
+// The Mach exception port on Apple platforms is only installed for the thread that set it up,
+// so a write from any other thread would crash.
+#if defined(MACHINE_CONTEXT_SUPPORTED) && !defined(MASKED_PSP_MEMORY) && !defined(__APPLE__)
+#define WRITE_TRACKER_SUPPORTED
+#endif
+
+// The fault handler may run on any thread, and can't block on a regular mutex.
+static std::atomic_flag g_trackerLock = ATOMIC_FLAG_INIT;
+static uint32_t g_pageShift;
+static uint32_t g_numPages;
+// Only accessed under g_trackerLock.
+static std::vector<bool> g_pageWatched;
+static std::atomic<bool> g_anyWatched;
+// Only accessed under g_trackerLock.
+static std::unique_ptr<std::atomic<uint32_t>[]> g_pageStamps;
+// Only accessed under g_trackerLock.  Pages unprotected by writes from g_ignoringThread.
+static std::thread::id g_ignoringThread;
+static std::vector<uint32_t> g_ignoredPages;
+// Never reset, so stamps handed out before a reinit still compare sensibly.
+static std::atomic<uint32_t> g_stamp;
+
+struct TrackerLockGuard {
+	TrackerLockGuard() {
+		while (g_trackerLock.test_and_set(std::memory_order_acquire))
+			continue;
+	}
+	~TrackerLockGuard() {
+		g_trackerLock.clear(std::memory_order_release);
+	}
+};
+
+void WriteTracker_Init() {
+	WriteTracker_Shutdown();
+	if (!WriteTracker_Supported())
+		return;
+
+	TrackerLockGuard guard;
+	g_pageShift = 12;
+	while ((1U << g_pageShift) < (uint32_t)GetMemoryProtectPageSize())
+		g_pageShift++;
+	g_numPages = g_MemorySize >> g_pageShift;
+	g_pageWatched.assign(g_numPages, false);
+	g_anyWatched = false;
+
+	// Anything watched before is stale now, so consider every page written.
+	const uint32_t stamp = ++g_stamp;
+	g_pageStamps.reset(new std::atomic<uint32_t>[g_numPages]);
+	for (uint32_t i = 0; i < g_numPages; ++i)
+		g_pageStamps[i].store(stamp, std::memory_order_relaxed);
+}
+
+void WriteTracker_Shutdown() {
+	TrackerLockGuard guard;
+	// The views are about to be unmapped, so there's no need to unprotect anything.
+	g_numPages = 0;
+	g_pageWatched.clear();
+	g_anyWatched = false;
+	g_pageStamps.reset();
+	g_ignoringThread = std::thread::id();
+	g_ignoredPages.clear();
+}
+
+bool WriteTracker_Supported() {
+#ifdef WRITE_TRACKER_SUPPORTED
+	return true;
+#else
+	return false;
+#endif
+}
+
+// Must hold g_trackerLock.  Returns false if the range isn't entirely inside RAM.
+static bool GetPageRange(uint32_t address, uint32_t size, uint32_t &first, uint32_t &end) {
+	const uint32_t offset = (address & 0x3FFFFFFF) - PSP_GetKernelMemoryBase();
+	if (size == 0 || g_numPages == 0 || offset >= g_numPages << g_pageShift || size > (g_numPages << g_pageShift) - offset)
+		return false;
+	first = offset >> g_pageShift;
+	end = (offset + size - 1) >> g_pageShift;
+	end++;
+	return true;
+}
+
+// Must hold g_trackerLock.  Applies to every mirror of RAM.
+static void ProtectPages(uint32_t first, uint32_t end, bool watch) {
+	const uint32_t offset = first << g_pageShift;
+	const uint32_t size = (end - first) << g_pageShift;
+	const uint32_t flags = watch ? MEM_PROT_READ : (MEM_PROT_READ | MEM_PROT_WRITE);
+	ProtectMemoryPages(m_pPhysicalRAM + offset, size, flags);
+	ProtectMemoryPages(m_pUncachedRAM + offset, size, flags);
+	if (m_pKernelRAM)
+		ProtectMemoryPages(m_pKernelRAM + offset, size, flags);
+	for (uint32_t i = first; i < end; ++i)
+		g_pageWatched[i] = watch;
+}
+
+// Must hold g_trackerLock.  Calls ProtectPages() once per run of pages not yet in the wanted state.
+static void ProtectPageRuns(uint32_t first, uint32_t end, bool watch) {
+	uint32_t runStart = first;
+	for (uint32_t i = first; i <= end; ++i) {
+		if (i == end || g_pageWatched[i] == watch) {
+			if (runStart < i)
+				ProtectPages(runStart, i, watch);
+			runStart = i + 1;
+		}
+	}
+}
+
+uint32_t WriteTracker_Watch(uint32_t address, uint32_t size) {
+	TrackerLockGuard guard;
+	uint32_t first, end;
+	if (!GetPageRange(address, size, first, end))
+		return 0;
+
+	ProtectPageRuns(first, end, true);
+	g_anyWatched = true;
+	return g_stamp.load();
+}
+
+bool WriteTracker_WrittenSince(uint32_t address, uint32_t size, uint32_t stamp) {
+	// Shutdown may free the stamps at any time.
+	TrackerLockGuard guard;
+	uint32_t first, end;
+	if (stamp == 0 || !GetPageRange(address, size, first, end))
+		return true;
+
+	for (uint32_t i = first; i < end; ++i) {
+		if (g_pageStamps[i].load(std::memory_order_relaxed) > stamp)
+			return true;
+	}
+	return false;
+}
+
+uint32_t WriteTracker_PageSize() {
+	return 1U << g_pageShift;
+}
+
+void WriteTracker_GetWrittenPages(uint32_t address, uint32_t size, uint32_t stamp, std::vector<uint32_t> &pages) {
+	TrackerLockGuard guard;
+	uint32_t first, end;
+	if (!GetPageRange(address, size, first, end))
+		return;
+
+	for (uint32_t i = first; i < end; ++i) {
+		if (stamp == 0 || g_pageStamps[i].load(std::memory_order_relaxed) > stamp)
+			pages.push_back(PSP_GetKernelMemoryBase() + (i << g_pageShift));
+	}
+}
+
+void WriteTracker_NotifyWrite(uint32_t address, uint32_t size) {
+	TrackerLockGuard guard;
+	if (g_numPages == 0 || size == 0)
+		return;
+	// Clip to RAM, in case the write only partially overlaps it.
+	const uint32_t ramSize = g_numPages << g_pageShift;
+	uint32_t offset = (address & 0x3FFFFFFF) - PSP_GetKernelMemoryBase();
+	if (offset >= ramSize)
+		return;
+	if (size > ramSize - offset)
+		size = ramSize - offset;
+	const uint32_t first = offset >> g_pageShift;
+	const uint32_t end = ((offset + size - 1) >> g_pageShift) + 1;
+
+	const uint32_t stamp = ++g_stamp;
+	for (uint32_t i = first; i < end; ++i)
+		g_pageStamps[i].store(stamp, std::memory_order_relaxed);
+	if (g_anyWatched)
+		ProtectPageRuns(first, end, false);
+}
+
+void WriteTracker_NotifyHostWrite(const void *ptr, uint32_t size) {
+	// Callers may also pass host buffers that aren't PSP memory at all, those are ignored.
+	const uintptr_t baseAddress = (uintptr_t)base;
+	const uintptr_t hostAddress = (uintptr_t)ptr;
+	if (hostAddress < baseAddress || hostAddress >= baseAddress + 0x100000000ULL)
+		return;
+	WriteTracker_NotifyWrite((uint32_t)(hostAddress - baseAddress), size);
+}
+
+void WriteTracker_BeginIgnoringWrites() {
+	TrackerLockGuard guard;
+	g_ignoringThread = std::this_thread::get_id();
+}
+
+void WriteTracker_EndIgnoringWrites() {
+	TrackerLockGuard guard;
+	g_ignoringThread = std::thread::id();
+	// Watch them again.  WriteTracker_NotifyWrite() still stamps them meanwhile, but direct writes
+	// from other threads while ignoring are missed, so keep it short.
+	for (uint32_t page : g_ignoredPages) {
+		if (page < g_numPages && !g_pageWatched[page])
+			ProtectPages(page, page + 1, true);
+	}
+	g_ignoredPages.clear();
+}
+
+bool WriteTracker_HandleFault(uintptr_t hostAddress) {
+	if (!g_anyWatched)
+		return false;
+
+	const uintptr_t baseAddress = (uintptr_t)base;
+	if (hostAddress < baseAddress || hostAddress >= baseAddress + 0x100000000ULL)
+		return false;
+	const uint32_t guestAddress = (uint32_t)(hostAddress - baseAddress);
+	// Only the cached, uncached, and kernel mirrors are ever protected.
+	const uint32_t mirror = guestAddress & 0xC0000000;
+	if (mirror == 0xC0000000 || (mirror == 0x80000000 && !m_pKernelRAM))
+		return false;
+
+	TrackerLockGuard guard;
+	uint32_t first, end;
+	if (!GetPageRange(guestAddress, 1, first, end))
+		return false;
+
+	if (g_pageWatched[first]) {
+		if (g_ignoringThread == std::this_thread::get_id())
+			g_ignoredPages.push_back(first);
+		else
+			g_pageStamps[first].store(++g_stamp, std::memory_order_relaxed);
+		ProtectPages(first, end, false);
+	}
+	// If it wasn't watched, another thread just beat us to it.  RAM is otherwise always writable.
+	return true;
+}
+
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Tracks writes to PSP RAM using host page protection.
+//
+// Watched pages are made read-only in every mirror of RAM.  The first write to one faults,
+// and the fault handler stamps the page and makes it writable again.  This catches writes
+// from jitted code, the interpreter, HLE, and other threads alike, and costs nothing for
+// memory that is only read.
+//
+// The OS doesn't fault on our behalf: a read() or recv() directly into a watched page just fails.
+// Code that hands guest memory to the OS to write into must call WriteTracker_NotifyWrite() first.
+
+namespace Memory {
+
+void WriteTracker_Init();
+void WriteTracker_Shutdown();
+
+// Whether this platform can track writes at all.  If not, the functions below are no-ops.
+bool WriteTracker_Supported();
+
+// Write protects the range (if not already) and returns a stamp to check it against later.
+// Returns 0 if the range can't be tracked, e.g. it's outside RAM.
+uint32_t WriteTracker_Watch(uint32_t address, uint32_t size);
+// Whether any page in the range was written after the stamp was returned by WriteTracker_Watch().
+bool WriteTracker_WrittenSince(uint32_t address, uint32_t size, uint32_t stamp);
+// Marks the range written and makes it writable, before something writes without faulting.
+void WriteTracker_NotifyWrite(uint32_t address, uint32_t size);
+// Same, for a host pointer that may or may not point into PSP memory.
+void WriteTracker_NotifyHostWrite(const void *ptr, uint32_t size);
+
+// Granularity of tracking, at least 4 KB but may be larger depending on the host.
+uint32_t WriteTracker_PageSize();
+// Appends the address of each page in the range written after stamp.  The range should be page aligned.
+void WriteTracker_GetWrittenPages(uint32_t address, uint32_t size, uint32_t stamp, std::vector<uint32_t> &pages);
+
+// Writes by the calling thread between these don't count, though the pages stay writable until
+// the end.  For code that temporarily changes RAM and puts it back, like removing emuhacks.
+void WriteTracker_BeginIgnoringWrites();
+void WriteTracker_EndIgnoringWrites();
+
+// Called by the exception handler.  Returns true if this was a write to a watched page,
+// in which case the write can simply be retried.
+bool WriteTracker_HandleFault(uintptr_t hostAddress);
+
+}
@@ -16,9 +16,13 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <snappy-c.h>
 
 #include "Common/Data/Text/I18n.h"
 #include "Common/Thread/ThreadUtil.h"
@@ -42,9 +46,11 @@
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/sceDisplay.h"
 #include "Core/HLE/ReplaceTables.h"
+#include "Core/HLE/sceIo.h"
 #include "Core/HLE/sceKernel.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/MemMap.h"
+#include "Core/MemWriteTracker.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "HW/MemoryStick.h"
@@ -60,6 +66,10 @@ namespace SaveState
 	struct SaveStart
 	{
 		void DoState(PointerWrap &p);
+
+		bool includeRAM = true;
+		// When loading without RAM, puts it back right where Memory::DoState() would have.
+		std::function<void()> restoreRAM;
 	};
 
 	enum OperationType
@@ -86,29 +96,79 @@ namespace SaveState
 		void *cbUserData;
 	};
 
-	CChunkFileReader::Error SaveToRam(std::vector<u8> &data) {
+	CChunkFileReader::Error SaveToRam(std::vector<u8> &data, bool includeRAM) {
 		SaveStart state;
+		state.includeRAM = includeRAM;
 		size_t sz = CChunkFileReader::MeasurePtr(state);
 		if (data.size() < sz)
 			data.resize(sz);
 		return CChunkFileReader::SavePtr(&data[0], state);
 	}
 
-	CChunkFileReader::Error LoadFromRam(std::vector<u8> &data, std::string *errorString) {
+	CChunkFileReader::Error LoadFromRam(std::vector<u8> &data, std::string *errorString, bool includeRAM) {
 		SaveStart state;
+		state.includeRAM = includeRAM;
 		return CChunkFileReader::LoadPtr(&data[0], state, errorString);
 	}
 
+	// Memory is a bit tricky when jit is enabled, since there's emuhacks in it.
+	// This runs func with RAM as the game wrote it when saving, and keeps replacements when loading.
+	// Either way RAM ends up as it was, so the write tracker shouldn't see these writes.
+	template <typename F>
+	static void WithCleanRAM(bool saving, F func)
+	{
+		Memory::WriteTracker_BeginIgnoringWrites();
+		auto savedReplacements = SaveAndClearReplacements();
+		if (MIPSComp::jit && saving)
+		{
+			std::vector<u32> savedBlocks;
+			savedBlocks = MIPSComp::jit->SaveAndClearEmuHackOps();
+			func();
+			MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks);
+		}
+		else
+			func();
+		RestoreSavedReplacements(savedReplacements);
+		Memory::WriteTracker_EndIgnoringWrites();
+	}
+
 	struct StateRingbuffer
 	{
+		typedef std::vector<u8> StateBuffer;
+
+		// With write tracking, RAM isn't in the states, but kept as a shared full copy plus changed pages.
+		struct RAMBase
+		{
+			StateBuffer data;
+			u32 stamp;
+		};
+		struct RAMPages
+		{
+			std::shared_ptr<RAMBase> base;
+			std::vector<u32> addresses;
+			// Raw pages at first, then xored with the base and compressed on the compress thread.
+			StateBuffer data;
+			bool compressed = false;
+		};
+
 		StateRingbuffer(int size) : first_(0), next_(0), size_(size), base_(-1)
 		{
 			states_.resize(size);
 			baseMapping_.resize(size);
+			ramPages_.resize(size);
 		}
 
 		CChunkFileReader::Error Save()
 		{
+			const bool trackRAM = g_Config.bRewindTrackWrites && Memory::WriteTracker_Supported();
+			if (trackRAM != trackingRAM_)
+			{
+				// The states we have are in the other format, so start over.
+				Clear();
+				base_ = -1;
+				trackingRAM_ = trackRAM;
+			}
+
 			std::lock_guard<std::mutex> guard(lock_);
 
 			int n = next_++ % size_;
@@ -123,21 +183,103 @@ namespace SaveState
 			{
 				base_ = (base_ + 1) % ARRAY_SIZE(bases_);
 				baseUsage_ = 0;
-				err = SaveToRam(bases_[base_]);
+				err = SaveToRam(bases_[base_], !trackingRAM_);
 				// Let's not bother savestating twice.
 				compressBuffer = &bases_[base_];
 			}
 			else
-				err = SaveToRam(buffer);
+				err = SaveToRam(buffer, !trackingRAM_);
 
 			if (err == CChunkFileReader::ERROR_NONE)
-				ScheduleCompress(&states_[n], compressBuffer, &bases_[base_]);
+			{
+				RAMPages *pages = nullptr;
+				if (trackingRAM_)
+				{
+					pages = &ramPages_[n];
+					SaveRAMPages(*pages);
+				}
+				ScheduleCompress(&states_[n], compressBuffer, &bases_[base_], pages);
+			}
 			else
 				states_[n].clear();
 			baseMapping_[n] = base_;
 			return err;
 		}
 
+		// Saves only the pages written since the last full copy of RAM, which is usually small.
+		void SaveRAMPages(RAMPages &pages)
+		{
+			const u32 ramBase = PSP_GetKernelMemoryBase();
+			const u32 pageSize = Memory::WriteTracker_PageSize();
+
+			pages.addresses.clear();
+			pages.compressed = false;
+			if (ramBase_ && ramBase_->data.size() != Memory::g_MemorySize)
+				ramBase_.reset();
+			if (ramBase_)
+				Memory::WriteTracker_GetWrittenPages(ramBase, Memory::g_MemorySize, ramBase_->stamp, pages.addresses);
+
+			// If most of RAM changed (or after loading a state), a new full copy is cheaper.
+			if (!ramBase_ || pages.addresses.size() * pageSize > Memory::g_MemorySize / 2)
+			{
+				ramBase_ = std::make_shared<RAMBase>();
+				pages.addresses.clear();
+				// An async read already in flight would fail on watched pages, so let it finish.
+				__IoSyncThread();
+				// Watch first, so that nothing written during the copy is missed.
+				// Removing and restoring emuhacks doesn't count as writing.
+				ramBase_->stamp = Memory::WriteTracker_Watch(ramBase, Memory::g_MemorySize);
+				WithCleanRAM(true, [&] {
+					ramBase_->data.resize(Memory::g_MemorySize);
+					memcpy(&ramBase_->data[0], Memory::GetPointer(ramBase), Memory::g_MemorySize);
+				});
+			}
+
+			pages.base = ramBase_;
+			pages.data.resize(pages.addresses.size() * pageSize);
+			if (!pages.addresses.empty())
+			{
+				WithCleanRAM(true, [&] {
+					for (size_t i = 0; i < pages.addresses.size(); ++i)
+						memcpy(&pages.data[i * pageSize], Memory::GetPointer(pages.addresses[i]), pageSize);
+				});
+			}
+		}
+
+		// Must run with clean RAM, from SaveStart::restoreRAM.
+		void RestoreRAMPages(const RAMPages &pages)
+		{
+			const u32 ramBase = PSP_GetKernelMemoryBase();
+			const u32 pageSize = Memory::WriteTracker_PageSize();
+			if (!pages.base)
+				return;
+
+			static StateBuffer buffer;
+			const StateBuffer *data = &pages.data;
+			if (pages.compressed)
+			{
+				size_t rawSize = pages.addresses.size() * pageSize;
+				buffer.resize(rawSize);
+				if (snappy_uncompress((const char *)&pages.data[0], pages.data.size(), (char *)&buffer[0], &rawSize) != SNAPPY_OK || rawSize != buffer.size())
+				{
+					ERROR_LOG(SAVESTATE, "Rewind: failed to decompress RAM pages");
+					return;
+				}
+				XorPagesWithBase(&buffer[0], pages);
+				data = &buffer;
+			}
+
+			const u32 size = std::min((u32)pages.base->data.size(), Memory::g_MemorySize);
+			Memory::WriteTracker_NotifyWrite(ramBase, Memory::g_MemorySize);
+			memcpy(Memory::GetPointer(ramBase), &pages.base->data[0], size);
+
+			for (size_t i = 0; i < pages.addresses.size(); ++i)
+			{
+				if (Memory::IsValidRange(pages.addresses[i], pageSize))
+					memcpy(Memory::GetPointer(pages.addresses[i]), &(*data)[i * pageSize], pageSize);
+			}
+		}
+
 		CChunkFileReader::Error Restore(std::string *errorString)
 		{
 			std::lock_guard<std::mutex> guard(lock_);
@@ -152,26 +294,38 @@ namespace SaveState
 
 			static std::vector<u8> buffer;
 			LockedDecompress(buffer, states_[n], bases_[baseMapping_[n]]);
-			return LoadFromRam(buffer, errorString);
+			if (!trackingRAM_)
+				return LoadFromRam(buffer, errorString);
+
+			// RAM has to be back before the kernel and HLE modules load, since some of them look at it.
+			SaveStart state;
+			state.includeRAM = false;
+			state.restoreRAM = [&] {
+				RestoreRAMPages(ramPages_[n]);
+			};
+			return CChunkFileReader::LoadPtr(&buffer[0], state, errorString);
 		}
 
-		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base)
+		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base, RAMPages *pages)
 		{
 			if (compressThread_.joinable())
 				compressThread_.join();
 			compressThread_ = std::thread([=]{
 				setCurrentThreadName("SaveStateCompress");
-				Compress(*result, *state, *base);
+				Compress(*result, *state, *base, pages);
 			});
 		}
 
-		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base)
+		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base, RAMPages *pages)
 		{
 			std::lock_guard<std::mutex> guard(lock_);
 			// Bail if we were cleared before locking.
 			if (first_ == 0 && next_ == 0)
 				return;
 
+			if (pages)
+				CompressRAMPages(*pages);
+
 			result.clear();
 			for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
 			{
@@ -186,6 +340,42 @@ namespace SaveState
 			}
 		}
 
+		// The base always covers all of RAM, see SaveRAMPages().
+		static void XorPagesWithBase(u8 *data, const RAMPages &pages)
+		{
+			const u32 ramBase = PSP_GetKernelMemoryBase();
+			const u32 pageSize = Memory::WriteTracker_PageSize();
+			const u8 *base = &pages.base->data[0];
+			for (size_t i = 0; i < pages.addresses.size(); ++i)
+			{
+				u8 *page = data + i * pageSize;
+				const u8 *basePage = base + (pages.addresses[i] - ramBase);
+				for (u32 j = 0; j < pageSize; ++j)
+					page[j] ^= basePage[j];
+			}
+		}
+
+		// Written pages mostly still match the base, so the xor is mostly zeros and compresses well.
+		void CompressRAMPages(RAMPages &pages)
+		{
+			if (pages.compressed || pages.data.empty())
+				return;
+
+			static StateBuffer buffer;
+			XorPagesWithBase(&pages.data[0], pages);
+			size_t compressedSize = snappy_max_compressed_length(pages.data.size());
+			buffer.resize(compressedSize);
+			if (snappy_compress((const char *)&pages.data[0], pages.data.size(), (char *)&buffer[0], &compressedSize) != SNAPPY_OK)
+			{
+				// Raw pages still work, just put them back.
+				XorPagesWithBase(&pages.data[0], pages);
+				return;
+			}
+			pages.data.assign(buffer.begin(), buffer.begin() + compressedSize);
+			pages.data.shrink_to_fit();
+			pages.compressed = true;
+		}
+
 		void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
 		{
 			result.clear();
@@ -220,6 +410,9 @@ namespace SaveState
 			std::lock_guard<std::mutex> guard(lock_);
 			first_ = 0;
 			next_ = 0;
+			for (RAMPages &pages : ramPages_)
+				pages = RAMPages();
+			ramBase_.reset();
 		}
 
 		bool Empty() const
@@ -231,8 +424,6 @@ namespace SaveState
 		// TODO: Instead, based on size of compressed state?
 		static const int BASE_USAGE_INTERVAL;
 
-		typedef std::vector<u8> StateBuffer;
-
 		int first_;
 		int next_;
 		int size_;
@@ -240,6 +431,9 @@ namespace SaveState
 		std::vector<StateBuffer> states_;
 		StateBuffer bases_[2];
 		std::vector<int> baseMapping_;
+		std::vector<RAMPages> ramPages_;
+		std::shared_ptr<RAMBase> ramBase_;
+		bool trackingRAM_ = false;
 		std::mutex lock_;
 		std::thread compressThread_;
 
@@ -289,18 +483,11 @@ namespace SaveState
 		// Gotta do CoreTiming first since we'll restore into it.
 		CoreTiming::DoState(p);
 
-		// Memory is a bit tricky when jit is enabled, since there's emuhacks in it.
-		auto savedReplacements = SaveAndClearReplacements();
-		if (MIPSComp::jit && p.mode == p.MODE_WRITE)
-		{
-			std::vector<u32> savedBlocks;
-			savedBlocks = MIPSComp::jit->SaveAndClearEmuHackOps();
-			Memory::DoState(p);
-			MIPSComp::jit->RestoreSavedEmuHackOps(savedBlocks);
-		}
-		else
-			Memory::DoState(p);
-		RestoreSavedReplacements(savedReplacements);
+		WithCleanRAM(p.mode == p.MODE_WRITE, [&] {
+			Memory::DoState(p, includeRAM);
+			if (p.mode == p.MODE_READ && !includeRAM && restoreRAM)
+				restoreRAM();
+		});
 
 		MemoryStick_DoState(p);
 		currentMIPS->DoState(p);
@@ -68,8 +68,9 @@ namespace SaveState
 	// Warning: callback will be called on a different thread.
 	void Save(const std::string &filename, int slot, Callback callback = Callback(), void *cbUserData = 0);
 
-	CChunkFileReader::Error SaveToRam(std::vector<u8> &state);
-	CChunkFileReader::Error LoadFromRam(std::vector<u8> &state, std::string *errorString);
+	// Without includeRAM, PSP RAM is left out of the state and must be saved and restored separately.
+	CChunkFileReader::Error SaveToRam(std::vector<u8> &state, bool includeRAM = true);
+	CChunkFileReader::Error LoadFromRam(std::vector<u8> &state, std::string *errorString, bool includeRAM = true);
 
 	// For testing / automated tests.  Runs a save state verification pass (async.)
 	// Warning: callback will be called on a different thread.
@@ -88,6 +88,10 @@ ParamSFOData g_paramSFO;
 static GlobalUIState globalUIState;
 static CoreParameter coreParameter;
 static FileLoader *loadedFile;
+// Same as loadedFile when it's being cached in RAM.  The UI reads progress from it, so it's
+// changed under ramCachedFileLock, and cleared before loadedFile is deleted.
+static RamCachingFileLoader *ramCachedFile;
+static std::mutex ramCachedFileLock;
 // For background loading thread.
 static std::mutex loadingLock;
 // For loadingReason updates.
@@ -232,7 +236,9 @@ bool CPU_Init() {
 	loadedFile = ResolveFileLoaderTarget(ConstructFileLoader(filename));
 #ifdef _M_X64
 	if (g_Config.bCacheFullIsoInRam) {
-		loadedFile = new RamCachingFileLoader(loadedFile);
+		std::lock_guard<std::mutex> guard(ramCachedFileLock);
+		ramCachedFile = new RamCachingFileLoader(loadedFile);
+		loadedFile = ramCachedFile;
 	}
 #endif
 	IdentifiedFileType type = Identify_File(loadedFile);
@@ -357,6 +363,10 @@ void CPU_Shutdown() {
 	Memory::Shutdown();
 	HLEPlugins::Shutdown();
 
+	{
+		std::lock_guard<std::mutex> guard(ramCachedFileLock);
+		ramCachedFile = nullptr;
+	}
 	delete loadedFile;
 	loadedFile = nullptr;
 
@@ -369,10 +379,19 @@ void CPU_Shutdown() {
 
 // TODO: Maybe loadedFile doesn't even belong here...
 void UpdateLoadedFile(FileLoader *fileLoader) {
+	{
+		std::lock_guard<std::mutex> guard(ramCachedFileLock);
+		ramCachedFile = nullptr;
+	}
 	delete loadedFile;
 	loadedFile = fileLoader;
 }
 
+float PSP_GetFileCacheProgress() {
+	std::lock_guard<std::mutex> guard(ramCachedFileLock);
+	return ramCachedFile ? ramCachedFile->CachedFraction() : -1.0f;
+}
+
 void Core_UpdateState(CoreState newState) {
 	if ((coreState == CORE_RUNNING || coreState == CORE_NEXTFRAME) && newState != CORE_RUNNING)
 		coreStatePending = true;
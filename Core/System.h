@@ -95,6 +95,8 @@ void Audio_Shutdown();
 bool IsAudioInitialised();
 
 void UpdateLoadedFile(FileLoader *fileLoader);
+// Fraction of the game file loaded into RAM, or -1 if it's not cached in RAM.
+float PSP_GetFileCacheProgress();
 
 std::string GetSysDirectory(PSPDirectories directoryType);
 #ifdef _WIN32
@@ -15,9 +15,22 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
+
 #include <png.h>
 
 #include <algorithm>
+#include <cstring>
+
+#if PPSSPP_PLATFORM(WINDOWS)
+#include "Common/CommonWindows.h"
+#include "Common/Data/Encoding/Utf8.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "ext/xxhash.h"
 
@@ -25,8 +38,11 @@
 #include "Common/Data/Format/IniFile.h"
 #include "Common/Data/Text/Parsers.h"
 #include "Common/ColorConv.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/StringUtils.h"
+#include "Common/Swap.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Core/Config.h"
 #include "Core/Host.h"
 #include "Core/System.h"
@@ -36,14 +52,205 @@
 
 static const std::string INI_FILENAME = "textures.ini";
 static const std::string NEW_TEXTURE_DIR = "new/";
+static const std::string PACK_FILENAME = "textures.pack";
 static const int VERSION = 1;
 static const int MAX_MIP_LEVELS = 12;  // 12 should be plenty, 8 is the max mip levels supported by the PSP.
+static const int MAX_LOADER_THREADS = 4;
+// Decoded replacements are kept around for rebuilds, but only up to this much (pack data doesn't count.)
+static const size_t MAX_LOADED_BYTES = sizeof(void *) == 8 ? 512 * 1024 * 1024 : 128 * 1024 * 1024;
+
+static const u32 PACK_MAGIC = 0x4B505050;  // PPPK
+static const u32 PACK_VERSION = 1;
+
+struct ReplacementPackHeader {
+	u32_le magic;
+	u32_le version;
+	u32_le count;
+	u32_le reserved;
+	u64_le indexOffset;
+};
+
+// The index is sorted by nameHash, followed by RGBA8888 texels at offset.
+struct ReplacementPackEntry {
+	u64_le nameHash;
+	u64_le offset;
+	u32_le w;
+	u32_le h;
+	u32_le alphaStatus;
+	u32_le reserved;
+};
+
+// Filenames relative to the game's textures directory, as in the ini.
+static u64 PackNameHash(const std::string &hashfile) {
+	std::string name = hashfile;
+	for (char &c : name) {
+		c = c == '\\' ? '/' : tolower(c);
+	}
+	return XXH64(name.c_str(), name.size(), 0xBACD7814);
+}
+
+class ReplacementPack {
+public:
+	~ReplacementPack() {
+		Close();
+	}
+
+	bool Open(const std::string &filename);
+	const ReplacementPackEntry *Find(u64 nameHash) const;
+	const u8 *Data(const ReplacementPackEntry *entry) const {
+		return base_ + entry->offset;
+	}
+
+private:
+	bool Validate();
+	void Close();
+
+#if PPSSPP_PLATFORM(WINDOWS)
+	HANDLE file_ = INVALID_HANDLE_VALUE;
+	HANDLE mapping_ = nullptr;
+#endif
+	const u8 *base_ = nullptr;
+	size_t size_ = 0;
+	const ReplacementPackEntry *index_ = nullptr;
+	u32 count_ = 0;
+};
+
+bool ReplacementPack::Open(const std::string &filename) {
+#if PPSSPP_PLATFORM(UWP)
+	return false;
+#elif PPSSPP_PLATFORM(WINDOWS)
+	file_ = CreateFile(ConvertUTF8ToWString(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_ == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file_, &size) || size.QuadPart < (LONGLONG)sizeof(ReplacementPackHeader) || (u64)size.QuadPart > (u64)SIZE_MAX) {
+		Close();
+		return false;
+	}
+	mapping_ = CreateFileMapping(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_)
+		base_ = (const u8 *)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+	size_ = (size_t)size.QuadPart;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ReplacementPackHeader) || (u64)st.st_size > (u64)SIZE_MAX) {
+		close(fd);
+		return false;
+	}
+	size_ = (size_t)st.st_size;
+	void *base = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+	// The mapping stays valid after closing.
+	close(fd);
+	base_ = base == MAP_FAILED ? nullptr : (const u8 *)base;
+#endif
+
+	if (!base_ || !Validate()) {
+		ERROR_LOG(G3D, "Invalid texture replacement pack: %s", filename.c_str());
+		Close();
+		return false;
+	}
+	INFO_LOG(G3D, "Using texture replacement pack with %d textures: %s", count_, filename.c_str());
+	return true;
+}
+
+bool ReplacementPack::Validate() {
+	const ReplacementPackHeader *header = (const ReplacementPackHeader *)base_;
+	if (header->magic != PACK_MAGIC || header->version != PACK_VERSION)
+		return false;
+	const u64 indexSize = (u64)header->count * sizeof(ReplacementPackEntry);
+	if (header->indexOffset > size_ || indexSize > size_ - header->indexOffset || (header->indexOffset & 7) != 0)
+		return false;
+
+	index_ = (const ReplacementPackEntry *)(base_ + header->indexOffset);
+	count_ = header->count;
+	for (u32 i = 0; i < count_; ++i) {
+		const ReplacementPackEntry &entry = index_[i];
+		const u64 dataSize = (u64)entry.w * entry.h * 4;
+		if (entry.w == 0 || entry.h == 0 || entry.offset > size_ || dataSize > size_ - entry.offset)
+			return false;
+		if (i != 0 && index_[i - 1].nameHash >= entry.nameHash)
+			return false;
+	}
+	return true;
+}
+
+void ReplacementPack::Close() {
+#if PPSSPP_PLATFORM(WINDOWS)
+	if (base_)
+		UnmapViewOfFile(base_);
+	if (mapping_)
+		CloseHandle(mapping_);
+	if (file_ != INVALID_HANDLE_VALUE)
+		CloseHandle(file_);
+	mapping_ = nullptr;
+	file_ = INVALID_HANDLE_VALUE;
+#else
+	if (base_)
+		munmap((void *)base_, size_);
+#endif
+	base_ = nullptr;
+	index_ = nullptr;
+	count_ = 0;
+}
+
+const ReplacementPackEntry *ReplacementPack::Find(u64 nameHash) const {
+	const ReplacementPackEntry *end = index_ + count_;
+	const ReplacementPackEntry *entry = std::lower_bound(index_, end, nameHash, [](const ReplacementPackEntry &e, u64 h) {
+		return e.nameHash < h;
+	});
+	if (entry != end && entry->nameHash == nameHash)
+		return entry;
+	return nullptr;
+}
+
+static bool DecodeReplacementPNG(const std::string &filename, ReplacedTextureLevel *level, CheckAlphaResult *alpha) {
+	png_image png = {};
+	png.version = PNG_IMAGE_VERSION;
+
+	FILE *fp = File::OpenCFile(filename, "rb");
+	if (!fp) {
+		ERROR_LOG(G3D, "Could not open texture replacement: %s", filename.c_str());
+		return false;
+	}
+
+	bool good = false;
+	if (!png_image_begin_read_from_stdio(&png, fp)) {
+		ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s", filename.c_str(), png.message);
+	} else {
+		// If there's no alpha channel, we know for sure without checking.
+		bool checkAlpha = (png.format & PNG_FORMAT_FLAG_ALPHA) != 0;
+		png.format = PNG_FORMAT_RGBA;
+		level->texels.resize((size_t)png.width * png.height * 4);
+		if (!png_image_finish_read(&png, nullptr, level->texels.data(), png.width * 4, nullptr)) {
+			ERROR_LOG(G3D, "Could not load texture replacement: %s - %s", filename.c_str(), png.message);
+			level->texels.clear();
+		} else {
+			level->dataW = png.width;
+			level->dataH = png.height;
+			if (checkAlpha) {
+				*alpha = CheckAlphaRGBA8888Basic((const u32 *)level->texels.data(), png.width, png.width, png.height);
+			} else {
+				*alpha = CHECKALPHA_FULL;
+			}
+			good = true;
+		}
+	}
+
+	fclose(fp);
+	png_image_free(&png);
+	return good;
+}
 
 TextureReplacer::TextureReplacer() {
 	none_.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
+	none_.ready_ = true;
 }
 
 TextureReplacer::~TextureReplacer() {
+	StopLoaderThreads();
 }
 
 void TextureReplacer::Init() {
@@ -51,6 +258,12 @@ void TextureReplacer::Init() {
 }
 
 void TextureReplacer::NotifyConfigChanged() {
+	// Anything already loaded might be for another game or from the old pack.
+	StopLoaderThreads();
+	cache_.clear();
+	pack_.reset();
+	loadedBytes_ = 0;
+
 	gameID_ = g_paramSFO.GetDiscID();
 
 	enabled_ = g_Config.bReplaceTextures || g_Config.bSaveNewTextures;
@@ -69,6 +282,13 @@ void TextureReplacer::NotifyConfigChanged() {
 	if (enabled_) {
 		enabled_ = LoadIni();
 	}
+
+	if (enabled_ && g_Config.bReplaceTextures && File::Exists(basePath_ + PACK_FILENAME)) {
+		pack_.reset(new ReplacementPack());
+		if (!pack_->Open(basePath_ + PACK_FILENAME)) {
+			pack_.reset();
+		}
+	}
 }
 
 bool TextureReplacer::LoadIni() {
@@ -297,15 +517,30 @@ ReplacedTexture &TextureReplacer::FindReplacement(u64 cachekey, u32 hash, int w,
 
 	ReplacementCacheKey replacementKey(cachekey, hash);
 	auto it = cache_.find(replacementKey);
+	ReplacedTexture *result;
 	if (it != cache_.end()) {
-		return it->second;
+		result = &it->second;
+	} else {
+		// Okay, let's construct the result.
+		result = &cache_[replacementKey];
+		result->alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
+		PopulateReplacement(result, cachekey, hash, w, h);
 	}
 
-	// Okay, let's construct the result.
-	ReplacedTexture &result = cache_[replacementKey];
-	result.alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
-	PopulateReplacement(&result, cachekey, hash, w, h);
-	return result;
+	result->lastUsed_ = ++useCounter_;
+	if (!result->ready_) {
+		ReplacedTextureLoad state = result->loadState_;
+		if (state == ReplacedTextureLoad::DONE) {
+			result->ready_ = true;
+		} else if (state == ReplacedTextureLoad::NONE) {
+			QueueLoad(result);
+		}
+	}
+
+	if (loadedBytes_ > MAX_LOADED_BYTES) {
+		EvictReplacements(result);
+	}
+	return *result;
 }
 
 void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h) {
@@ -317,50 +552,168 @@ void TextureReplacer::PopulateReplacement(ReplacedTexture *result, u64 cachekey,
 		cachekey = cachekey & 0xFFFFFFFFULL;
 	}
 
+	result->w_ = w;
+	result->h_ = h;
+	result->newW_ = newW;
+	result->newH_ = newH;
+
+	// Only figure out the names here, checking and decoding the files happens on the loader threads.
 	for (int i = 0; i < MAX_MIP_LEVELS; ++i) {
 		const std::string hashfile = LookupHashFile(cachekey, hash, i);
-		const std::string filename = basePath_ + hashfile;
-		if (hashfile.empty() || !File::Exists(filename)) {
-			// Out of valid mip levels.  Bail out.
+		if (hashfile.empty()) {
 			break;
 		}
+		result->files_.push_back(basePath_ + hashfile);
+		result->packKeys_.push_back(PackNameHash(hashfile));
+	}
+
+	if (result->files_.empty()) {
+		// Explicitly ignored, nothing to load.
+		result->loadState_ = ReplacedTextureLoad::DONE;
+	}
+}
+
+bool TextureReplacer::PackContains(const std::string &hashfile) {
+	return pack_ && pack_->Find(PackNameHash(hashfile)) != nullptr;
+}
+
+void TextureReplacer::QueueLoad(ReplacedTexture *texture) {
+	texture->loadState_ = ReplacedTextureLoad::QUEUED;
+
+	std::lock_guard<std::mutex> guard(loaderLock_);
+	if (loaderThreads_.empty()) {
+		loaderStop_ = false;
+		int numThreads = std::max(1, std::min(g_Config.iNumWorkerThreads, MAX_LOADER_THREADS));
+		for (int i = 0; i < numThreads; ++i) {
+			loaderThreads_.push_back(std::thread(&TextureReplacer::LoaderThreadFunc, this));
+		}
+	}
+	loaderQueue_.push_back(texture);
+	loaderCond_.notify_one();
+}
+
+void TextureReplacer::LoaderThreadFunc() {
+	setCurrentThreadName("TexReplace");
+
+	std::unique_lock<std::mutex> guard(loaderLock_);
+	while (true) {
+		loaderCond_.wait(guard, [&] {
+			return loaderStop_ || !loaderQueue_.empty();
+		});
+		if (loaderStop_) {
+			break;
+		}
+
+		ReplacedTexture *texture = loaderQueue_.front();
+		loaderQueue_.pop_front();
+		guard.unlock();
+		LoadReplacement(texture);
+		guard.lock();
+	}
+}
+
+void TextureReplacer::StopLoaderThreads() {
+	{
+		std::lock_guard<std::mutex> guard(loaderLock_);
+		loaderStop_ = true;
+		// Anything that didn't get a chance will be queued again when it's next used.
+		for (ReplacedTexture *texture : loaderQueue_) {
+			texture->loadState_ = ReplacedTextureLoad::NONE;
+		}
+		loaderQueue_.clear();
+	}
+	loaderCond_.notify_all();
+
+	for (std::thread &th : loaderThreads_) {
+		th.join();
+	}
+	loaderThreads_.clear();
+}
+
+// Runs on a loader thread.  Only touches the texture and the pack, which stays mapped while the threads run.
+void TextureReplacer::LoadReplacement(ReplacedTexture *texture) {
+	std::vector<ReplacedTextureLevel> &levels = texture->levels_;
+	ReplacedTextureAlpha alphaStatus = ReplacedTextureAlpha::UNKNOWN;
+	size_t loadedBytes = 0;
+
+	levels.clear();
+	for (size_t i = 0; i < texture->files_.size(); ++i) {
+		const std::string &filename = texture->files_[i];
 
-		bool good = false;
 		ReplacedTextureLevel level;
 		level.fmt = ReplacedTextureFormat::F_8888;
 		level.file = filename;
 
-		png_image png = {};
-		png.version = PNG_IMAGE_VERSION;
-		FILE *fp = File::OpenCFile(filename, "rb");
-		if (png_image_begin_read_from_stdio(&png, fp)) {
-			// We pad files that have been hashrange'd so they are the same texture size.
-			level.w = (png.width * w) / newW;
-			level.h = (png.height * h) / newH;
+		bool good = false;
+		CheckAlphaResult alpha = CHECKALPHA_ANY;
+		const ReplacementPackEntry *packed = pack_ ? pack_->Find(texture->packKeys_[i]) : nullptr;
+		if (packed) {
+			level.dataW = packed->w;
+			level.dataH = packed->h;
+			level.mapped = pack_->Data(packed);
+			alpha = packed->alphaStatus == CHECKALPHA_FULL ? CHECKALPHA_FULL : CHECKALPHA_ANY;
 			good = true;
-		} else {
-			ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s", filename.c_str(), png.message);
+		} else if (File::Exists(filename)) {
+			good = DecodeReplacementPNG(filename, &level, &alpha);
 		}
-		fclose(fp);
 
-		png_image_free(&png);
+		if (good) {
+			// We pad files that have been hashrange'd so they are the same texture size.
+			level.w = (level.dataW * texture->w_) / texture->newW_;
+			level.h = (level.dataH * texture->h_) / texture->newH_;
+		}
 
 		if (good && i != 0) {
 			// Check that the mipmap size is correct.  Can't load mips of the wrong size.
-			if (level.w != (result->levels_[0].w >> i) || level.h != (result->levels_[0].h >> i)) {
-				 WARN_LOG(G3D, "Replacement mipmap invalid: size=%dx%d, expected=%dx%d (level %d, '%s')", level.w, level.h, result->levels_[0].w >> i, result->levels_[0].h >> i, i, filename.c_str());
-				 good = false;
+			if (level.w != (levels[0].w >> i) || level.h != (levels[0].h >> i)) {
+				WARN_LOG(G3D, "Replacement mipmap invalid: size=%dx%d, expected=%dx%d (level %d, '%s')", level.w, level.h, levels[0].w >> i, levels[0].h >> i, (int)i, filename.c_str());
+				good = false;
 			}
 		}
 
-		if (good)
-			result->levels_.push_back(level);
-		// Otherwise, we're done loading mips (bad PNG or bad size, either way.)
-		else
+		// Otherwise, we're done loading mips (missing file, bad PNG or bad size.)
+		if (!good)
 			break;
+
+		// This only checks the hashed bits.
+		if (alpha == CHECKALPHA_ANY || i == 0) {
+			alphaStatus = ReplacedTextureAlpha(alpha);
+		}
+		loadedBytes += level.texels.size();
+		levels.push_back(std::move(level));
 	}
 
-	result->alphaStatus_ = ReplacedTextureAlpha::UNKNOWN;
+	texture->alphaStatus_ = alphaStatus;
+	texture->loadedBytes_ = loadedBytes;
+	loadedBytes_ += loadedBytes;
+	texture->loadState_ = ReplacedTextureLoad::DONE;
+}
+
+void TextureReplacer::EvictReplacements(ReplacedTexture *keep) {
+	std::vector<ReplacedTexture *> loaded;
+	for (auto &item : cache_) {
+		ReplacedTexture &texture = item.second;
+		if (&texture != keep && texture.loadState_ == ReplacedTextureLoad::DONE && texture.loadedBytes_ != 0) {
+			loaded.push_back(&texture);
+		}
+	}
+
+	// Drop the least recently used first, leaving some room so we don't do this every time.
+	std::sort(loaded.begin(), loaded.end(), [](const ReplacedTexture *a, const ReplacedTexture *b) {
+		return a->lastUsed_ < b->lastUsed_;
+	});
+	for (ReplacedTexture *texture : loaded) {
+		if (loadedBytes_ <= MAX_LOADED_BYTES / 4 * 3) {
+			break;
+		}
+
+		// It'll be loaded again if a texture using it needs to be rebuilt.
+		loadedBytes_ -= texture->loadedBytes_;
+		texture->levels_.clear();
+		texture->loadedBytes_ = 0;
+		texture->ready_ = false;
+		texture->loadState_ = ReplacedTextureLoad::NONE;
+	}
 }
 
 static bool WriteTextureToPNG(png_imagep image, const std::string &filename, int convert_to_8bit, const void *buffer, png_int_32 row_stride, const void *colormap) {
@@ -407,7 +760,7 @@ void TextureReplacer::NotifyTextureDecoded(const ReplacedTextureDecodeInfo &repl
 	const std::string saveFilename = basePath_ + NEW_TEXTURE_DIR + hashfile;
 
 	// If it's empty, it's an ignored hash, we intentionally don't save.
-	if (hashfile.empty() || File::Exists(filename)) {
+	if (hashfile.empty() || File::Exists(filename) || PackContains(hashfile)) {
 		// If it exists, must've been decoded and saved as a new texture already.
 		return;
 	}
@@ -575,45 +928,21 @@ bool TextureReplacer::LookupHashRange(u32 addr, int &w, int &h) {
 }
 
 void ReplacedTexture::Load(int level, void *out, int rowPitch) {
-	_assert_msg_((size_t)level < levels_.size(), "Invalid miplevel");
+	_assert_msg_(ready_ && (size_t)level < levels_.size(), "Invalid miplevel");
 	_assert_msg_(out != nullptr && rowPitch > 0, "Invalid out/pitch");
 
+	// Already decoded by the loader, we just copy it in (possibly into a padded texture.)
 	const ReplacedTextureLevel &info = levels_[level];
-
-	png_image png = {};
-	png.version = PNG_IMAGE_VERSION;
-
-	FILE *fp = File::OpenCFile(info.file, "rb");
-	if (!png_image_begin_read_from_stdio(&png, fp)) {
-		ERROR_LOG(G3D, "Could not load texture replacement info: %s - %s", info.file.c_str(), png.message);
-		return;
-	}
-
-	bool checkedAlpha = false;
-	if ((png.format & PNG_FORMAT_FLAG_ALPHA) == 0) {
-		// Well, we know for sure it doesn't have alpha.
-		if (level == 0) {
-			alphaStatus_ = ReplacedTextureAlpha::FULL;
-		}
-		checkedAlpha = true;
-	}
-	png.format = PNG_FORMAT_RGBA;
-
-	if (!png_image_finish_read(&png, nullptr, out, rowPitch, nullptr)) {
-		ERROR_LOG(G3D, "Could not load texture replacement: %s - %s", info.file.c_str(), png.message);
-		return;
-	}
-
-	if (!checkedAlpha) {
-		// This will only check the hashed bits.
-		CheckAlphaResult res = CheckAlphaRGBA8888Basic((u32 *)out, rowPitch / sizeof(u32), png.width, png.height);
-		if (res == CHECKALPHA_ANY || level == 0) {
-			alphaStatus_ = ReplacedTextureAlpha(res);
+	const u8 *src = info.Data();
+	const int srcPitch = info.dataW * 4;
+	u8 *dst = (u8 *)out;
+	if (srcPitch == rowPitch) {
+		memcpy(dst, src, (size_t)srcPitch * info.dataH);
+	} else {
+		for (int y = 0; y < info.dataH; ++y) {
+			memcpy(dst + (size_t)rowPitch * y, src + (size_t)srcPitch * y, srcPitch);
 		}
 	}
-
-	fclose(fp);
-	png_image_free(&png);
 }
 
 bool TextureReplacer::GenerateIni(const std::string &gameID, std::string *generatedFilename) {
@@ -660,3 +989,113 @@ bool TextureReplacer::GenerateIni(const std::string &gameID, std::string *genera
 	}
 	return File::Exists(texturesDirectory + INI_FILENAME);
 }
+
+static void CollectReplacementPNGs(const std::string &directory, const std::string &prefix, std::vector<std::string> *files) {
+	std::vector<FileInfo> entries;
+	getFilesInDir(directory.c_str(), &entries, "png:");
+	for (const FileInfo &entry : entries) {
+		if (entry.isDirectory) {
+			// Textures in new/ are just dumped, they aren't used for replacement.
+			if (prefix.empty() && entry.name + "/" == NEW_TEXTURE_DIR)
+				continue;
+			CollectReplacementPNGs(entry.fullName, prefix + entry.name + "/", files);
+		} else {
+			files->push_back(prefix + entry.name);
+		}
+	}
+}
+
+bool TextureReplacer::GeneratePack(const std::string &gameID, std::string *generatedFilename) {
+	if (gameID.empty())
+		return false;
+
+	std::string texturesDirectory = GetSysDirectory(DIRECTORY_TEXTURES) + gameID + "/";
+	if (!File::Exists(texturesDirectory))
+		return false;
+
+	const std::string packFilename = texturesDirectory + PACK_FILENAME;
+	const std::string tempFilename = packFilename + ".tmp";
+	if (generatedFilename)
+		*generatedFilename = packFilename;
+
+	std::vector<std::string> files;
+	CollectReplacementPNGs(texturesDirectory, "", &files);
+
+	FILE *f = File::OpenCFile(tempFilename, "wb");
+	if (!f) {
+		ERROR_LOG(G3D, "Unable to create texture replacement pack: %s", tempFilename.c_str());
+		return false;
+	}
+
+	// We write the header again at the end, once the index is known.
+	ReplacementPackHeader header{};
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+	u64 offset = sizeof(header);
+
+	std::vector<ReplacementPackEntry> index;
+	for (size_t i = 0; i < files.size() && success; ++i) {
+		ReplacedTextureLevel level;
+		CheckAlphaResult alpha = CHECKALPHA_ANY;
+		if (!DecodeReplacementPNG(texturesDirectory + files[i], &level, &alpha)) {
+			continue;
+		}
+
+		// Keep texels aligned, it makes the copies a bit faster.
+		static const u8 padding[16]{};
+		const size_t pad = (size_t)(-(s64)offset & 15);
+		if (pad != 0) {
+			success = fwrite(padding, 1, pad, f) == pad;
+			offset += pad;
+		}
+
+		ReplacementPackEntry entry{};
+		entry.nameHash = PackNameHash(files[i]);
+		entry.offset = offset;
+		entry.w = level.dataW;
+		entry.h = level.dataH;
+		entry.alphaStatus = alpha;
+		index.push_back(entry);
+
+		success = success && fwrite(level.texels.data(), 1, level.texels.size(), f) == level.texels.size();
+		offset += level.texels.size();
+	}
+
+	std::sort(index.begin(), index.end(), [](const ReplacementPackEntry &a, const ReplacementPackEntry &b) {
+		return a.nameHash < b.nameHash;
+	});
+	// Only the same name with different case or slashes could collide, keep the first.
+	index.erase(std::unique(index.begin(), index.end(), [](const ReplacementPackEntry &a, const ReplacementPackEntry &b) {
+		return a.nameHash == b.nameHash;
+	}), index.end());
+
+	static const u8 padding[8]{};
+	const size_t pad = (size_t)(-(s64)offset & 7);
+	success = success && fwrite(padding, 1, pad, f) == pad;
+	offset += pad;
+
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	header.count = (u32)index.size();
+	header.indexOffset = offset;
+	if (success && !index.empty()) {
+		success = fwrite(index.data(), sizeof(ReplacementPackEntry), index.size(), f) == index.size();
+	}
+	success = success && fseek(f, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, f) == 1;
+	fclose(f);
+
+	if (success && File::Exists(packFilename)) {
+		// This fails if it's mapped by a running game on some platforms.
+		success = File::Delete(packFilename);
+	}
+	if (success) {
+		success = File::Rename(tempFilename, packFilename);
+	}
+	if (!success) {
+		ERROR_LOG(G3D, "Unable to write texture replacement pack: %s", packFilename.c_str());
+		File::Delete(tempFilename);
+		return false;
+	}
+
+	NOTICE_LOG(G3D, "Packed %d of %d texture replacements into %s", (int)index.size(), (int)files.size(), packFilename.c_str());
+	return true;
+}
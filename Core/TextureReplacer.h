@@ -17,8 +17,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include "Common/Common.h"
@@ -26,6 +32,7 @@
 #include "GPU/ge_constants.h"
 
 class IniFile;
+class ReplacementPack;
 class TextureCacheCommon;
 class TextureReplacer;
 
@@ -58,6 +65,17 @@ struct ReplacedTextureLevel {
 	int h;
 	ReplacedTextureFormat fmt;
 	std::string file;
+
+	// Size of the decoded image, smaller than w/h when padded for a hashrange.
+	int dataW = 0;
+	int dataH = 0;
+	// Decoded RGBA8888 texels, unless they're in a memory mapped pack.
+	std::vector<u8> texels;
+	const u8 *mapped = nullptr;
+
+	const u8 *Data() const {
+		return texels.empty() ? mapped : texels.data();
+	}
 };
 
 struct ReplacementCacheKey {
@@ -120,13 +138,25 @@ namespace std {
 	};
 }
 
+enum class ReplacedTextureLoad {
+	NONE,
+	QUEUED,
+	DONE,
+};
+
 struct ReplacedTexture {
+	// Replacements are loaded in the background.  Until this is true, use the original texture.
+	// Only changes inside TextureReplacer::FindReplacement(), so it's stable while building a texture.
+	inline bool IsReady() {
+		return ready_;
+	}
+
 	inline bool Valid() {
-		return !levels_.empty();
+		return ready_ && !levels_.empty();
 	}
 
 	bool GetSize(int level, int &w, int &h) {
-		if ((size_t)level < levels_.size()) {
+		if (ready_ && (size_t)level < levels_.size()) {
 			w = levels_[level].w;
 			h = levels_[level].h;
 			return true;
@@ -155,6 +185,20 @@ struct ReplacedTexture {
 	std::vector<ReplacedTextureLevel> levels_;
 	ReplacedTextureAlpha alphaStatus_;
 
+	// What to load, decided on the emu thread.
+	std::vector<std::string> files_;
+	std::vector<u64> packKeys_;
+	int w_ = 0;
+	int h_ = 0;
+	int newW_ = 0;
+	int newH_ = 0;
+
+	// Written by the loader threads, levels_ and alphaStatus_ belong to them until DONE.
+	std::atomic<ReplacedTextureLoad> loadState_{ ReplacedTextureLoad::NONE };
+	size_t loadedBytes_ = 0;
+	bool ready_ = false;
+	u64 lastUsed_ = 0;
+
 	friend TextureReplacer;
 };
 
@@ -187,6 +231,8 @@ class TextureReplacer {
 	void NotifyTextureDecoded(const ReplacedTextureDecodeInfo &replacedInfo, const void *data, int pitch, int level, int w, int h);
 
 	static bool GenerateIni(const std::string &gameID, std::string *generatedFilename);
+	// Packs all PNGs for a game into one pre-decoded, memory mappable file.
+	static bool GeneratePack(const std::string &gameID, std::string *generatedFilename);
 
 protected:
 	bool LoadIni();
@@ -196,6 +242,13 @@ class TextureReplacer {
 	std::string LookupHashFile(u64 cachekey, u32 hash, int level);
 	std::string HashName(u64 cachekey, u32 hash, int level);
 	void PopulateReplacement(ReplacedTexture *result, u64 cachekey, u32 hash, int w, int h);
+	bool PackContains(const std::string &hashfile);
+
+	void QueueLoad(ReplacedTexture *texture);
+	void LoadReplacement(ReplacedTexture *texture);
+	void LoaderThreadFunc();
+	void StopLoaderThreads();
+	void EvictReplacements(ReplacedTexture *keep);
 
 	SimpleBuf<u32> saveBuf;
 	bool enabled_ = false;
@@ -213,4 +266,13 @@ class TextureReplacer {
 	ReplacedTexture none_;
 	std::unordered_map<ReplacementCacheKey, ReplacedTexture> cache_;
 	std::unordered_map<ReplacementCacheKey, ReplacedTextureLevel> savedCache_;
+	std::unique_ptr<ReplacementPack> pack_;
+	u64 useCounter_ = 0;
+
+	std::vector<std::thread> loaderThreads_;
+	std::mutex loaderLock_;
+	std::condition_variable loaderCond_;
+	std::deque<ReplacedTexture *> loaderQueue_;
+	bool loaderStop_ = false;
+	std::atomic<size_t> loadedBytes_{ 0 };
 };
@@ -17,6 +17,7 @@
 
 #include <cstring>
 
+#include "Common/BitScan.h"
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -24,7 +25,13 @@
 #include "Core/Util/BlockAllocator.h"
 #include "Core/Reporting.h"
 
-// Slow freaking thing but works (eventually) :)
+// Blocks are kept in a list in address order, which is what's saved.  Lookups go through
+// indexes by address, and free blocks are also binned by size so allocating doesn't walk every block.
+
+static inline int FreeBinForSize(u32 size)
+{
+	return size == 0 ? 0 : 31 - (int)clz32_nonzero(size);
+}
 
 BlockAllocator::BlockAllocator(int grain) : bottom_(NULL), top_(NULL), grain_(grain)
 {
@@ -43,6 +50,7 @@ void BlockAllocator::Init(u32 rangeStart, u32 rangeSize)
 	//Initial block, covering everything
 	top_ = new Block(rangeStart_, rangeSize_, false, NULL, NULL);
 	bottom_ = top_;
+	IndexBlock(top_);
 }
 
 void BlockAllocator::Shutdown()
@@ -54,6 +62,10 @@ void BlockAllocator::Shutdown()
 		bottom_ = next;
 	}
 	top_ = NULL;
+
+	blocks_.clear();
+	for (auto &bin : freeBins_)
+		bin.clear();
 }
 
 u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop, const char *tag)
@@ -73,67 +85,37 @@ u32 BlockAllocator::AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromT
 	// upalign size to grain
 	size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
 
-	if (!fromTop)
+	Block *bp = FindFreeBlock(size, grain, fromTop);
+	if (bp != NULL)
 	{
-		//Allocate from bottom of mem
-		for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		Block &b = *bp;
+		UnindexBlock(&b);
+		if (!fromTop)
 		{
-			Block &b = *bp;
+			//Allocate from bottom of mem
 			u32 offset = b.start % grain;
 			if (offset != 0)
 				offset = grain - offset;
 			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetTag(tag);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeAfter(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeBefore(&b, offset);
-					b.taken = true;
-					b.SetTag(tag);
-					return b.start;
-				}
-			}
+			if (b.size != needed)
+				InsertFreeAfter(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeBefore(&b, offset);
 		}
-	}
-	else
-	{
-		// Allocate from top of mem.
-		for (Block *bp = top_; bp != NULL; bp = bp->prev)
+		else
 		{
-			Block &b = *bp;
+			// Allocate from top of mem.
 			u32 offset = (b.start + b.size - size) % grain;
 			u32 needed = offset + size;
-			if (b.taken == false && b.size >= needed)
-			{
-				if (b.size == needed)
-				{
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetTag(tag);
-					return b.start;
-				}
-				else
-				{
-					InsertFreeBefore(&b, b.size - needed);
-					if (offset >= grain_)
-						InsertFreeAfter(&b, offset);
-					b.taken = true;
-					b.SetTag(tag);
-					return b.start;
-				}
-			}
+			if (b.size != needed)
+				InsertFreeBefore(&b, b.size - needed);
+			if (offset >= grain_)
+				InsertFreeAfter(&b, offset);
 		}
+		b.taken = true;
+		b.SetTag(tag);
+		IndexBlock(&b);
+		return b.start;
 	}
 
 	//Out of memory :(
@@ -192,20 +174,24 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 			//good to go
 			else if (b.start == alignedPosition)
 			{
+				UnindexBlock(&b);
 				if (b.size != alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
 				b.taken = true;
 				b.SetTag(tag);
+				IndexBlock(&b);
 				CheckBlocks();
 				return position;
 			}
 			else
 			{
+				UnindexBlock(&b);
 				InsertFreeBefore(&b, alignedPosition - b.start);
 				if (b.size > alignedSize)
 					InsertFreeAfter(&b, b.size - alignedSize);
 				b.taken = true;
 				b.SetTag(tag);
+				IndexBlock(&b);
 
 				return position;
 			}
@@ -223,6 +209,7 @@ u32 BlockAllocator::AllocAt(u32 position, u32 size, const char *tag)
 	return -1;
 }
 
+// fromBlock must be free and not indexed, and the merged block is indexed after.
 void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 {
 	DEBUG_LOG(SCEKERNEL, "Merging Blocks");
@@ -231,6 +218,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (prev != NULL && prev->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(prev);
 		prev->size += fromBlock->size;
 		if (fromBlock->next == NULL)
 			top_ = prev;
@@ -251,6 +239,7 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 	while (next != NULL && next->taken == false)
 	{
 		DEBUG_LOG(SCEKERNEL, "Block Alloc found adjacent free blocks - merging");
+		UnindexBlock(next);
 		fromBlock->size += next->size;
 		fromBlock->next = next->next;
 		delete next;
@@ -261,6 +250,8 @@ void BlockAllocator::MergeFreeBlocks(Block *fromBlock)
 		top_ = fromBlock;
 	else
 		next->prev = fromBlock;
+
+	IndexBlock(fromBlock);
 }
 
 bool BlockAllocator::Free(u32 position)
@@ -268,6 +259,7 @@ bool BlockAllocator::Free(u32 position)
 	Block *b = GetBlockFromAddress(position);
 	if (b && b->taken)
 	{
+		UnindexBlock(b);
 		b->taken = false;
 		MergeFreeBlocks(b);
 		return true;
@@ -284,6 +276,7 @@ bool BlockAllocator::FreeExact(u32 position)
 	Block *b = GetBlockFromAddress(position);
 	if (b && b->taken && b->start == position)
 	{
+		UnindexBlock(b);
 		b->taken = false;
 		MergeFreeBlocks(b);
 		return true;
@@ -295,6 +288,7 @@ bool BlockAllocator::FreeExact(u32 position)
 	}
 }
 
+// b must not be indexed, since its start or size changes.  The new free block is indexed.
 BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 {
 	Block *inserted = new Block(b->start, size, false, b->prev, b);
@@ -306,9 +300,11 @@ BlockAllocator::Block *BlockAllocator::InsertFreeBefore(Block *b, u32 size)
 
 	b->start += size;
 	b->size -= size;
+	IndexBlock(inserted);
 	return inserted;
 }
 
+// Same as InsertFreeBefore().
 BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 {
 	Block *inserted = new Block(b->start + b->size - size, size, false, b, b->next);
@@ -319,9 +315,81 @@ BlockAllocator::Block *BlockAllocator::InsertFreeAfter(Block *b, u32 size)
 		inserted->next->prev = inserted;
 
 	b->size -= size;
+	IndexBlock(inserted);
 	return inserted;
 }
 
+void BlockAllocator::IndexBlock(Block *b)
+{
+	if (b->size == 0)
+		return;
+	blocks_[b->start] = b;
+	if (!b->taken)
+		freeBins_[FreeBinForSize(b->size)][b->start] = b;
+}
+
+void BlockAllocator::UnindexBlock(Block *b)
+{
+	if (b->size == 0)
+		return;
+	blocks_.erase(b->start);
+	if (!b->taken)
+		freeBins_[FreeBinForSize(b->size)].erase(b->start);
+}
+
+void BlockAllocator::IndexAllBlocks()
+{
+	blocks_.clear();
+	for (auto &bin : freeBins_)
+		bin.clear();
+	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
+		IndexBlock(bp);
+}
+
+// Finds the same block as checking each block from the bottom (or top) for the first fit.
+BlockAllocator::Block *BlockAllocator::FindFreeBlock(u32 size, u32 grain, bool fromTop)
+{
+	Block *best = NULL;
+	// Smaller bins can't fit, and within each, the first fit by address is the only candidate.
+	for (int bin = FreeBinForSize(size); bin < FREE_BIN_COUNT; ++bin)
+	{
+		const std::map<u32, Block *> &blocks = freeBins_[bin];
+		if (!fromTop)
+		{
+			for (auto it = blocks.begin(); it != blocks.end(); ++it)
+			{
+				Block *b = it->second;
+				if (best != NULL && b->start > best->start)
+					break;
+				u32 offset = b->start % grain;
+				if (offset != 0)
+					offset = grain - offset;
+				if (b->size >= offset + size)
+				{
+					best = b;
+					break;
+				}
+			}
+		}
+		else
+		{
+			for (auto it = blocks.rbegin(); it != blocks.rend(); ++it)
+			{
+				Block *b = it->second;
+				if (best != NULL && b->start < best->start)
+					break;
+				u32 offset = (b->start + b->size - size) % grain;
+				if (b->size >= offset + size)
+				{
+					best = b;
+					break;
+				}
+			}
+		}
+	}
+	return best;
+}
+
 void BlockAllocator::CheckBlocks() const
 {
 	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
@@ -344,29 +412,26 @@ const char *BlockAllocator::GetBlockTag(u32 addr) const {
 
 inline BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr)
 {
-	for (Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
+	// The last block starting at or before addr is the only one that might contain it.
+	auto it = blocks_.upper_bound(addr);
+	if (it == blocks_.begin())
+		return NULL;
+	--it;
+	Block *bp = it->second;
+	if (bp->start + bp->size > addr)
+		return bp;
 	return NULL;
 }
 
 const BlockAllocator::Block *BlockAllocator::GetBlockFromAddress(u32 addr) const
 {
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
-	{
-		const Block &b = *bp;
-		if (b.start <= addr && b.start + b.size > addr)
-		{
-			// Got one!
-			return bp;
-		}
-	}
+	auto it = blocks_.upper_bound(addr);
+	if (it == blocks_.begin())
+		return NULL;
+	--it;
+	const Block *bp = it->second;
+	if (bp->start + bp->size > addr)
+		return bp;
 	return NULL;
 }
 
@@ -402,13 +467,13 @@ void BlockAllocator::ListBlocks() const
 u32 BlockAllocator::GetLargestFreeBlockSize() const
 {
 	u32 maxFreeBlock = 0;
-	for (const Block *bp = bottom_; bp != NULL; bp = bp->next)
+	// Only the largest non-empty bin matters.
+	for (int bin = FREE_BIN_COUNT - 1; bin >= 0 && maxFreeBlock == 0; --bin)
 	{
-		const Block &b = *bp;
-		if (!b.taken)
+		for (const auto &it : freeBins_[bin])
 		{
-			if (b.size > maxFreeBlock)
-				maxFreeBlock = b.size;
+			if (it.second->size > maxFreeBlock)
+				maxFreeBlock = it.second->size;
 		}
 	}
 	if (maxFreeBlock & (grain_ - 1))
@@ -456,6 +521,8 @@ void BlockAllocator::DoState(PointerWrap &p)
 			top_->next->DoState(p);
 			top_ = top_->next;
 		}
+
+		IndexAllBlocks();
 	}
 	else
 	{
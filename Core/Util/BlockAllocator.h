@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <map>
+
 class PointerWrap;
 
 #include "Common/CommonTypes.h"
@@ -72,6 +74,9 @@ class BlockAllocator
 		Block *next;
 	};
 
+	// Free blocks are binned by log2 of their size.
+	enum { FREE_BIN_COUNT = 32 };
+
 	Block *bottom_;
 	Block *top_;
 	u32 rangeStart_;
@@ -79,6 +84,17 @@ class BlockAllocator
 
 	u32 grain_;
 
+	// The list above is the real state, these are indexes into it by start address.
+	// Empty blocks are never indexed, since they can't be looked up or allocated.
+	std::map<u32, Block *> blocks_;
+	std::map<u32, Block *> freeBins_[FREE_BIN_COUNT];
+
+	// A block must be removed from the indexes before changing its start, size, or taken.
+	void IndexBlock(Block *b);
+	void UnindexBlock(Block *b);
+	void IndexAllBlocks();
+	Block *FindFreeBlock(u32 size, u32 grain, bool fromTop);
+
 	void MergeFreeBlocks(Block *fromBlock);
 	Block *GetBlockFromAddress(u32 addr);
 	const Block *GetBlockFromAddress(u32 addr) const;
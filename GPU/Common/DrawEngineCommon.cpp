@@ -19,7 +19,9 @@
 
 #include "Common/Profiler/Profiler.h"
 #include "Common/ColorConv.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -91,12 +93,15 @@ int DrawEngineCommon::ComputeNumVertsToDecode() const {
 }
 
 void DrawEngineCommon::DecodeVerts(u8 *dest) {
+	const double decodeStart = coreCollectDebugStats ? time_now_d() : 0.0;
 	const UVScale origUV = gstate_c.uv;
 	for (; decodeCounter_ < numDrawCalls; decodeCounter_++) {
 		gstate_c.uv = drawCalls[decodeCounter_].uvScale;
 		DecodeVertsStep(dest, decodeCounter_, decodedVerts_);  // NOTE! DecodeVertsStep can modify decodeCounter_!
 	}
 	gstate_c.uv = origUV;
+	if (decodeStart != 0.0)
+		gpuStats.msDecodingVertices += time_now_d() - decodeStart;
 
 	// Sanity check
 	if (indexGen.Prim() < 0) {
@@ -161,6 +161,10 @@ struct GPUDebugBuffer {
 		return fmt_;
 	}
 
+	u32 GetPixelSize() const {
+		return PixelSize(fmt_);
+	}
+
 private:
 	u32 PixelSize(GPUDebugBufferFormat fmt) const;
 
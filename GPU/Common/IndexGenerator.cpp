@@ -23,6 +23,9 @@
 
 #ifdef _M_SSE
 #include <emmintrin.h>
+#if _M_SSE >= 0x301
+#include <tmmintrin.h>
+#endif
 #endif
 #if PPSSPP_ARCH(ARM_NEON)
 
@@ -62,12 +65,408 @@ void IndexGenerator::AddPrim(int prim, int vertexCount, bool clockwise) {
 	}
 }
 
+// All the generated patterns repeat every 24 indices (8 triangles, 12 lines, or 24 points),
+// which is a multiple of both 3 and the 8 lanes of a 16-bit vector. Each table holds the
+// offsets for the first 24 indices, and the matching increment table holds how much each
+// of those grow for every following group of 24.
+
+alignas(16) static const u16 offsets_ramp[24] = {
+	0, 1, 2, 3, 4, 5, 6, 7,
+	8, 9, 10, 11, 12, 13, 14, 15,
+	16, 17, 18, 19, 20, 21, 22, 23,
+};
+
+alignas(16) static const u16 increments_24[24] = {
+	24, 24, 24, 24, 24, 24, 24, 24,
+	24, 24, 24, 24, 24, 24, 24, 24,
+	24, 24, 24, 24, 24, 24, 24, 24,
+};
+
+alignas(16) static const u16 offsets_list_counter_clockwise[24] = {
+	0, 2, 1,
+	3, 5, 4,
+	6, 8, 7,
+	9, 11, 10,
+	12, 14, 13,
+	15, 17, 16,
+	18, 20, 19,
+	21, 23, 22,
+};
+
+alignas(16) static const u16 offsets_line_strip[24] = {
+	0, 1, 1, 2, 2, 3, 3, 4,
+	4, 5, 5, 6, 6, 7, 7, 8,
+	8, 9, 9, 10, 10, 11, 11, 12,
+};
+
+alignas(16) static const u16 increments_12[24] = {
+	12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12,
+};
+
+alignas(16) static const u16 offsets_clockwise[24] = {
+	0, (u16)(0 + 1), (u16)(0 + 2),
+	1, (u16)(1 + 2), (u16)(1 + 1),
+	2, (u16)(2 + 1), (u16)(2 + 2),
+	3, (u16)(3 + 2), (u16)(3 + 1),
+	4, (u16)(4 + 1), (u16)(4 + 2),
+	5, (u16)(5 + 2), (u16)(5 + 1),
+	6, (u16)(6 + 1), (u16)(6 + 2),
+	7, (u16)(7 + 2), (u16)(7 + 1),
+};
+
+alignas(16) static const uint16_t offsets_counter_clockwise[24] = {
+	0, (u16)(0 + 2), (u16)(0 + 1),
+	1, (u16)(1 + 1), (u16)(1 + 2),
+	2, (u16)(2 + 2), (u16)(2 + 1),
+	3, (u16)(3 + 1), (u16)(3 + 2),
+	4, (u16)(4 + 2), (u16)(4 + 1),
+	5, (u16)(5 + 1), (u16)(5 + 2),
+	6, (u16)(6 + 2), (u16)(6 + 1),
+	7, (u16)(7 + 1), (u16)(7 + 2),
+};
+
+alignas(16) static const u16 increments_8[24] = {
+	8, 8, 8, 8, 8, 8, 8, 8,
+	8, 8, 8, 8, 8, 8, 8, 8,
+	8, 8, 8, 8, 8, 8, 8, 8,
+};
+
+// The first vertex of a fan never moves, so its increment is zero.
+alignas(16) static const u16 offsets_fan_clockwise[24] = {
+	0, 1, 2,
+	0, 2, 3,
+	0, 3, 4,
+	0, 4, 5,
+	0, 5, 6,
+	0, 6, 7,
+	0, 7, 8,
+	0, 8, 9,
+};
+
+alignas(16) static const u16 offsets_fan_counter_clockwise[24] = {
+	0, 2, 1,
+	0, 3, 2,
+	0, 4, 3,
+	0, 5, 4,
+	0, 6, 5,
+	0, 7, 6,
+	0, 8, 7,
+	0, 9, 8,
+};
+
+alignas(16) static const u16 increments_fan[24] = {
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+	0, 8, 8,
+};
+
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+
+// Lane masks for swapping the second and third index of every triangle in a group of 24.
+alignas(16) static const u16 list_take_next[24] = {
+	0, 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF,
+	0, 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0,
+	0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0,
+};
+
+alignas(16) static const u16 list_take_prev[24] = {
+	0, 0, 0xFFFF, 0, 0, 0xFFFF, 0, 0,
+	0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF, 0,
+	0, 0xFFFF, 0, 0, 0xFFFF, 0, 0, 0xFFFF,
+};
+
+// Writes base + offsets[i % 24] + (i / 24) * increments[i % 24] for i in [0, count).
+// We allow ourselves to write up to 23 extra indices to avoid a fallback loop.
+// That's alright as we're appending to a buffer - they will get overwritten anyway.
+static void GenerateIndices(u16 *dst, int base, int count, const u16 *offsets, const u16 *increments) {
+	int numChunks = (count + 23) / 24;
+#ifdef _M_SSE
+	__m128i ibase8 = _mm_set1_epi16(base);
+	__m128i cur0 = _mm_add_epi16(ibase8, _mm_load_si128((const __m128i *)offsets));
+	__m128i cur1 = _mm_add_epi16(ibase8, _mm_load_si128((const __m128i *)offsets + 1));
+	__m128i cur2 = _mm_add_epi16(ibase8, _mm_load_si128((const __m128i *)offsets + 2));
+	__m128i inc0 = _mm_load_si128((const __m128i *)increments);
+	__m128i inc1 = _mm_load_si128((const __m128i *)increments + 1);
+	__m128i inc2 = _mm_load_si128((const __m128i *)increments + 2);
+	__m128i *out = (__m128i *)dst;
+	for (int i = 0; i < numChunks; i++) {
+		_mm_storeu_si128(out, cur0);
+		_mm_storeu_si128(out + 1, cur1);
+		_mm_storeu_si128(out + 2, cur2);
+		cur0 = _mm_add_epi16(cur0, inc0);
+		cur1 = _mm_add_epi16(cur1, inc1);
+		cur2 = _mm_add_epi16(cur2, inc2);
+		out += 3;
+	}
+#else
+	uint16x8_t ibase8 = vdupq_n_u16(base);
+	uint16x8_t cur0 = vaddq_u16(ibase8, vld1q_u16(offsets));
+	uint16x8_t cur1 = vaddq_u16(ibase8, vld1q_u16(offsets + 8));
+	uint16x8_t cur2 = vaddq_u16(ibase8, vld1q_u16(offsets + 16));
+	uint16x8_t inc0 = vld1q_u16(increments);
+	uint16x8_t inc1 = vld1q_u16(increments + 8);
+	uint16x8_t inc2 = vld1q_u16(increments + 16);
+	for (int i = 0; i < numChunks; i++) {
+		vst1q_u16(dst, cur0);
+		vst1q_u16(dst + 8, cur1);
+		vst1q_u16(dst + 16, cur2);
+		cur0 = vaddq_u16(cur0, inc0);
+		cur1 = vaddq_u16(cur1, inc1);
+		cur2 = vaddq_u16(cur2, inc2);
+		dst += 24;
+	}
+#endif
+}
+
+// Loads 8 indices and narrows them to 16 bits. Wider indices wrap just like the scalar paths.
+// Callers must make sure all 8 source indices are within the range of the draw,
+// since the index data can sit right at the end of PSP memory.
+#ifdef _M_SSE
+static inline __m128i LoadIndices8(const u8 *inds) {
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)inds), _mm_setzero_si128());
+}
+
+static inline __m128i LoadIndices8(const u16_le *inds) {
+	return _mm_loadu_si128((const __m128i *)inds);
+}
+
+static inline __m128i LoadIndices8(const u32_le *inds) {
+	// packs saturates, so sign extend the low halves first to keep just the low 16 bits.
+	__m128i lo = _mm_loadu_si128((const __m128i *)inds);
+	__m128i hi = _mm_loadu_si128((const __m128i *)(inds + 4));
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+	return _mm_packs_epi32(lo, hi);
+}
+#else
+static inline uint16x8_t LoadIndices8(const u8 *inds) {
+	return vmovl_u8(vld1_u8(inds));
+}
+
+static inline uint16x8_t LoadIndices8(const u16_le *inds) {
+	return vld1q_u16(inds);
+}
+
+static inline uint16x8_t LoadIndices8(const u32_le *inds) {
+	return vcombine_u16(vmovn_u32(vld1q_u32(inds)), vmovn_u32(vld1q_u32(inds + 4)));
+}
+#endif
+
+// Translates indices 8 at a time, returns how many were done. The caller handles the rest.
+template <class ITypeLE>
+static int TranslateIndices(u16 *outInds, const ITypeLE *inds, int numInds, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	__m128i offset = _mm_set1_epi16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		_mm_storeu_si128((__m128i *)(outInds + i), _mm_add_epi16(offset, LoadIndices8(inds + i)));
+	}
+#else
+	uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 8 <= numInds; i += 8) {
+		vst1q_u16(outInds + i, vaddq_u16(offset, LoadIndices8(inds + i)));
+	}
+#endif
+	return i;
+}
+
+// Like TranslateIndices, but swaps the last two indices of each triangle. Works 24 indices at a time
+// by taking each lane either from itself or from its neighbor on either side.
+template <class ITypeLE>
+static int TranslateListSwapped(u16 *outInds, const ITypeLE *inds, int numInds, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i *next = (const __m128i *)list_take_next;
+	const __m128i *prev = (const __m128i *)list_take_prev;
+	__m128i next0 = _mm_load_si128(next), next1 = _mm_load_si128(next + 1), next2 = _mm_load_si128(next + 2);
+	__m128i prev0 = _mm_load_si128(prev), prev1 = _mm_load_si128(prev + 1), prev2 = _mm_load_si128(prev + 2);
+	__m128i keep0 = _mm_andnot_si128(_mm_or_si128(next0, prev0), _mm_set1_epi16(-1));
+	__m128i keep1 = _mm_andnot_si128(_mm_or_si128(next1, prev1), _mm_set1_epi16(-1));
+	__m128i keep2 = _mm_andnot_si128(_mm_or_si128(next2, prev2), _mm_set1_epi16(-1));
+	__m128i offset = _mm_set1_epi16(indexOffset);
+	for (; i + 24 <= numInds; i += 24) {
+		__m128i v0 = _mm_add_epi16(offset, LoadIndices8(inds + i));
+		__m128i v1 = _mm_add_epi16(offset, LoadIndices8(inds + i + 8));
+		__m128i v2 = _mm_add_epi16(offset, LoadIndices8(inds + i + 16));
+		// The first lane of v0 and last lane of v2 are never swapped, so no need to look past them.
+		__m128i n0 = _mm_or_si128(_mm_srli_si128(v0, 2), _mm_slli_si128(v1, 14));
+		__m128i n1 = _mm_or_si128(_mm_srli_si128(v1, 2), _mm_slli_si128(v2, 14));
+		__m128i p1 = _mm_or_si128(_mm_slli_si128(v1, 2), _mm_srli_si128(v0, 14));
+		__m128i p2 = _mm_or_si128(_mm_slli_si128(v2, 2), _mm_srli_si128(v1, 14));
+		__m128i p0 = _mm_slli_si128(v0, 2);
+		__m128i n2 = _mm_srli_si128(v2, 2);
+		__m128i *out = (__m128i *)(outInds + i);
+		_mm_storeu_si128(out, _mm_or_si128(_mm_and_si128(v0, keep0), _mm_or_si128(_mm_and_si128(n0, next0), _mm_and_si128(p0, prev0))));
+		_mm_storeu_si128(out + 1, _mm_or_si128(_mm_and_si128(v1, keep1), _mm_or_si128(_mm_and_si128(n1, next1), _mm_and_si128(p1, prev1))));
+		_mm_storeu_si128(out + 2, _mm_or_si128(_mm_and_si128(v2, keep2), _mm_or_si128(_mm_and_si128(n2, next2), _mm_and_si128(p2, prev2))));
+	}
+#else
+	uint16x8_t next0 = vld1q_u16(list_take_next), next1 = vld1q_u16(list_take_next + 8), next2 = vld1q_u16(list_take_next + 16);
+	uint16x8_t prev0 = vld1q_u16(list_take_prev), prev1 = vld1q_u16(list_take_prev + 8), prev2 = vld1q_u16(list_take_prev + 16);
+	uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 24 <= numInds; i += 24) {
+		uint16x8_t v0 = vaddq_u16(offset, LoadIndices8(inds + i));
+		uint16x8_t v1 = vaddq_u16(offset, LoadIndices8(inds + i + 8));
+		uint16x8_t v2 = vaddq_u16(offset, LoadIndices8(inds + i + 16));
+		uint16x8_t o0 = vbslq_u16(next0, vextq_u16(v0, v1, 1), vbslq_u16(prev0, vextq_u16(v0, v0, 7), v0));
+		uint16x8_t o1 = vbslq_u16(next1, vextq_u16(v1, v2, 1), vbslq_u16(prev1, vextq_u16(v0, v1, 7), v1));
+		uint16x8_t o2 = vbslq_u16(next2, vextq_u16(v2, v2, 1), vbslq_u16(prev2, vextq_u16(v1, v2, 7), v2));
+		vst1q_u16(outInds + i, o0);
+		vst1q_u16(outInds + i + 8, o1);
+		vst1q_u16(outInds + i + 16, o2);
+	}
+#endif
+	return i;
+}
+
+// Translates 8 line strip segments at a time, returns how many were done.
+template <class ITypeLE>
+static int TranslateLineStripSegments(u16 *outInds, const ITypeLE *inds, int numLines, int indexOffset) {
+	int i = 0;
+#ifdef _M_SSE
+	__m128i offset = _mm_set1_epi16(indexOffset);
+	// Each batch reads one index past the last segment start, which is the end of the segment.
+	for (; i + 8 <= numLines; i += 8) {
+		__m128i a = _mm_add_epi16(offset, LoadIndices8(inds + i));
+		__m128i b = _mm_add_epi16(offset, LoadIndices8(inds + i + 1));
+		_mm_storeu_si128((__m128i *)(outInds + i * 2), _mm_unpacklo_epi16(a, b));
+		_mm_storeu_si128((__m128i *)(outInds + i * 2 + 8), _mm_unpackhi_epi16(a, b));
+	}
+#else
+	uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 8 <= numLines; i += 8) {
+		uint16x8x2_t lines;
+		lines.val[0] = vaddq_u16(offset, LoadIndices8(inds + i));
+		lines.val[1] = vaddq_u16(offset, LoadIndices8(inds + i + 1));
+		vst2q_u16(outInds + i * 2, lines);
+	}
+#endif
+	return i;
+}
+
+#if _M_SSE >= 0x301
+// Builds pshufb masks that gather 16-bit lanes from a window of 10 indices, given as lanes 0-7 of lo
+// and lanes 6-7 of hi (which starts two indices later.) Lanes that come from the other register are zeroed.
+static void BuildWindowMasks(const u16 *offsets, __m128i loMasks[3], __m128i hiMasks[3]) {
+	const __m128i spread = _mm_set1_epi16(0x0202);
+	const __m128i upperByte = _mm_set1_epi16(0x0100);
+	const __m128i zeroLane = _mm_set1_epi16((short)0x8080);
+	for (int k = 0; k < 3; k++) {
+		__m128i offs = _mm_load_si128((const __m128i *)offsets + k);
+		__m128i inHi = _mm_cmpgt_epi16(offs, _mm_set1_epi16(7));
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(offs, spread), upperByte);
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(offs, _mm_set1_epi16(2)), spread), upperByte);
+		loMasks[k] = _mm_or_si128(lo, _mm_and_si128(inHi, zeroLane));
+		hiMasks[k] = _mm_or_si128(hi, _mm_andnot_si128(inHi, zeroLane));
+	}
+}
+
+static inline __m128i GatherWindow(__m128i lo, __m128i hi, __m128i loMask, __m128i hiMask) {
+	return _mm_or_si128(_mm_shuffle_epi8(lo, loMask), _mm_shuffle_epi8(hi, hiMask));
+}
+#endif
+
+// Translates 8 strip triangles at a time, returns how many were done. Since that's an even
+// number, the winding is the same afterward.
+template <class ITypeLE>
+static int TranslateStripTriangles(u16 *outInds, const ITypeLE *inds, int numTris, int indexOffset, bool clockwise) {
+	int i = 0;
+#if _M_SSE >= 0x301
+	if (!cpu_info.bSSSE3)
+		return 0;
+	__m128i loMasks[3], hiMasks[3];
+	BuildWindowMasks(clockwise ? offsets_clockwise : offsets_counter_clockwise, loMasks, hiMasks);
+	__m128i offset = _mm_set1_epi16(indexOffset);
+	for (; i + 8 <= numTris; i += 8) {
+		__m128i lo = _mm_add_epi16(offset, LoadIndices8(inds + i));
+		__m128i hi = _mm_add_epi16(offset, LoadIndices8(inds + i + 2));
+		__m128i *out = (__m128i *)(outInds + i * 3);
+		_mm_storeu_si128(out, GatherWindow(lo, hi, loMasks[0], hiMasks[0]));
+		_mm_storeu_si128(out + 1, GatherWindow(lo, hi, loMasks[1], hiMasks[1]));
+		_mm_storeu_si128(out + 2, GatherWindow(lo, hi, loMasks[2], hiMasks[2]));
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	static const u16 oddLanes[8] = { 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF };
+	// Odd triangles take the third vertex second when clockwise, and even ones do when not.
+	uint16x8_t swapped = vld1q_u16(oddLanes);
+	if (!clockwise)
+		swapped = vmvnq_u16(swapped);
+	uint16x8_t offset = vdupq_n_u16(indexOffset);
+	for (; i + 8 <= numTris; i += 8) {
+		uint16x8_t b = vaddq_u16(offset, LoadIndices8(inds + i + 1));
+		uint16x8_t c = vaddq_u16(offset, LoadIndices8(inds + i + 2));
+		uint16x8x3_t tris;
+		tris.val[0] = vaddq_u16(offset, LoadIndices8(inds + i));
+		tris.val[1] = vbslq_u16(swapped, c, b);
+		tris.val[2] = vbslq_u16(swapped, b, c);
+		vst3q_u16(outInds + i * 3, tris);
+	}
+#endif
+	return i;
+}
+
+// Translates 8 fan triangles at a time, returns how many were done.
+template <class ITypeLE>
+static int TranslateFanTriangles(u16 *outInds, const ITypeLE *inds, int numTris, int indexOffset, bool clockwise) {
+	int i = 0;
+#if _M_SSE >= 0x301
+	if (!cpu_info.bSSSE3)
+		return 0;
+	__m128i loMasks[3], hiMasks[3];
+	BuildWindowMasks(clockwise ? offsets_fan_clockwise : offsets_fan_counter_clockwise, loMasks, hiMasks);
+	__m128i offset = _mm_set1_epi16(indexOffset);
+	// The center vertex goes where the gather would pick the start of the window.
+	__m128i center = _mm_set1_epi16((u16)(indexOffset + inds[0]));
+	__m128i centerMasks[3];
+	for (int k = 0; k < 3; k++) {
+		__m128i others = _mm_or_si128(_mm_load_si128((const __m128i *)list_take_next + k), _mm_load_si128((const __m128i *)list_take_prev + k));
+		centerMasks[k] = _mm_andnot_si128(others, _mm_set1_epi16(-1));
+	}
+	for (; i + 8 <= numTris; i += 8) {
+		__m128i lo = _mm_add_epi16(offset, LoadIndices8(inds + i));
+		__m128i hi = _mm_add_epi16(offset, LoadIndices8(inds + i + 2));
+		__m128i *out = (__m128i *)(outInds + i * 3);
+		for (int k = 0; k < 3; k++) {
+			__m128i tris = GatherWindow(lo, hi, loMasks[k], hiMasks[k]);
+			_mm_storeu_si128(out + k, _mm_or_si128(_mm_andnot_si128(centerMasks[k], tris), _mm_and_si128(centerMasks[k], center)));
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	uint16x8_t offset = vdupq_n_u16(indexOffset);
+	uint16x8_t center = vdupq_n_u16((u16)(indexOffset + inds[0]));
+	for (; i + 8 <= numTris; i += 8) {
+		uint16x8_t b = vaddq_u16(offset, LoadIndices8(inds + i + 1));
+		uint16x8_t c = vaddq_u16(offset, LoadIndices8(inds + i + 2));
+		uint16x8x3_t tris;
+		tris.val[0] = center;
+		tris.val[1] = clockwise ? b : c;
+		tris.val[2] = clockwise ? c : b;
+		vst3q_u16(outInds + i * 3, tris);
+	}
+#endif
+	return i;
+}
+
+#endif
+
 void IndexGenerator::AddPoints(int numVerts) {
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	GenerateIndices(inds_, index_, numVerts, offsets_ramp, increments_24);
+	inds_ += numVerts;
+#else
 	u16 *outInds = inds_;
 	const int startIndex = index_;
 	for (int i = 0; i < numVerts; i++)
 		*outInds++ = startIndex + i;
 	inds_ = outInds;
+#endif
 	// ignore overflow verts
 	index_ += numVerts;
 	count_ += numVerts;
@@ -76,6 +475,12 @@ void IndexGenerator::AddPoints(int numVerts) {
 }
 
 void IndexGenerator::AddList(int numVerts, bool clockwise) {
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	// Like the scalar loop, a partial triangle at the end is written out whole.
+	int numInds = ((numVerts + 2) / 3) * 3;
+	GenerateIndices(inds_, index_, numInds, clockwise ? offsets_ramp : offsets_list_counter_clockwise, increments_24);
+	inds_ += numInds;
+#else
 	u16 *outInds = inds_;
 	const int startIndex = index_;
 	const int v1 = clockwise ? 1 : 2;
@@ -86,6 +491,7 @@ void IndexGenerator::AddList(int numVerts, bool clockwise) {
 		*outInds++ = startIndex + i + v2;
 	}
 	inds_ = outInds;
+#endif
 	// ignore overflow verts
 	index_ += numVerts;
 	count_ += numVerts;
@@ -97,73 +503,19 @@ void IndexGenerator::AddList(int numVerts, bool clockwise) {
 	}
 }
 
-alignas(16) static const u16 offsets_clockwise[24] = {
-	0, (u16)(0 + 1), (u16)(0 + 2),
-	1, (u16)(1 + 2), (u16)(1 + 1),
-	2, (u16)(2 + 1), (u16)(2 + 2),
-	3, (u16)(3 + 2), (u16)(3 + 1),
-	4, (u16)(4 + 1), (u16)(4 + 2),
-	5, (u16)(5 + 2), (u16)(5 + 1),
-	6, (u16)(6 + 1), (u16)(6 + 2),
-	7, (u16)(7 + 2), (u16)(7 + 1),
-};
-
-alignas(16) static const uint16_t offsets_counter_clockwise[24] = {
-	0, (u16)(0 + 2), (u16)(0 + 1),
-	1, (u16)(1 + 1), (u16)(1 + 2),
-	2, (u16)(2 + 2), (u16)(2 + 1),
-	3, (u16)(3 + 1), (u16)(3 + 2),
-	4, (u16)(4 + 2), (u16)(4 + 1),
-	5, (u16)(5 + 1), (u16)(5 + 2),
-	6, (u16)(6 + 2), (u16)(6 + 1),
-	7, (u16)(7 + 1), (u16)(7 + 2),
-};
-
 void IndexGenerator::AddStrip(int numVerts, bool clockwise) {
 	int numTris = numVerts - 2;
 
-#ifdef _M_SSE
-	// In an SSE2 register we can fit 8 16-bit integers.
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	// In a 128-bit register we can fit 8 16-bit integers.
 	// However, we need to output a multiple of 3 indices.
 	// The first such multiple is 24, which means we'll generate 24 indices per cycle,
 	// which corresponds to 8 triangles. That's pretty cool.
-
-	// We allow ourselves to write some extra indices to avoid the fallback loop.
-	// That's alright as we're appending to a buffer - they will get overwritten anyway.
-	int numChunks = (numTris + 7) / 8;
-	__m128i ibase8 = _mm_set1_epi16(index_);
-	__m128i increment = _mm_set1_epi16(8);
-	const __m128i *offsets = (const __m128i *)(clockwise ? offsets_clockwise : offsets_counter_clockwise);
-	__m128i offsets0 = _mm_load_si128(offsets);
-	__m128i offsets1 = _mm_load_si128(offsets + 1);
-	__m128i offsets2 = _mm_load_si128(offsets + 2);
-	__m128i *dst = (__m128i *)inds_;
-	for (int i = 0; i < numChunks; i++) {
-		_mm_storeu_si128(dst, _mm_add_epi16(ibase8, offsets0));
-		_mm_storeu_si128(dst + 1, _mm_add_epi16(ibase8, offsets1));
-		_mm_storeu_si128(dst + 2, _mm_add_epi16(ibase8, offsets2));
-		ibase8 = _mm_add_epi16(ibase8, increment);
-		dst += 3;
+	if (numTris > 0) {
+		GenerateIndices(inds_, index_, numTris * 3, clockwise ? offsets_clockwise : offsets_counter_clockwise, increments_8);
 	}
 	inds_ += numTris * 3;
 	// wind doesn't need to be updated, an even number of triangles have been drawn.
-#elif PPSSPP_ARCH(ARM_NEON)
-	int numChunks = (numTris + 7) / 8;
-	uint16x8_t ibase8 = vdupq_n_u16(index_);
-	uint16x8_t increment = vdupq_n_u16(8);
-	const u16 *offsets = clockwise ? offsets_clockwise : offsets_counter_clockwise;
-	uint16x8_t offsets0 = vld1q_u16(offsets);
-	uint16x8_t offsets1 = vld1q_u16(offsets + 8);
-	uint16x8_t offsets2 = vld1q_u16(offsets + 16);
-	u16 *dst = inds_;
-	for (int i = 0; i < numChunks; i++) {
-		vst1q_u16(dst, vaddq_u16(ibase8, offsets0));
-		vst1q_u16(dst + 8, vaddq_u16(ibase8, offsets1));
-		vst1q_u16(dst + 16, vaddq_u16(ibase8, offsets2));
-		ibase8 = vaddq_u16(ibase8, increment);
-		dst += 3 * 8;
-	}
-	inds_ += numTris * 3;
 #else
 	// Slow fallback loop.
 	int wind = clockwise ? 1 : 2;
@@ -206,6 +558,12 @@ void IndexGenerator::AddStrip(int numVerts, bool clockwise) {
 
 void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 	const int numTris = numVerts - 2;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	if (numTris > 0) {
+		GenerateIndices(inds_, index_, numTris * 3, clockwise ? offsets_fan_clockwise : offsets_fan_counter_clockwise, increments_fan);
+		inds_ += numTris * 3;
+	}
+#else
 	u16 *outInds = inds_;
 	const int startIndex = index_;
 	const int v1 = clockwise ? 1 : 2;
@@ -216,6 +574,7 @@ void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 		*outInds++ = startIndex + i + v2;
 	}
 	inds_ = outInds;
+#endif
 	index_ += numVerts;
 	count_ += numTris * 3;
 	prim_ = GE_PRIM_TRIANGLES;
@@ -228,6 +587,12 @@ void IndexGenerator::AddFan(int numVerts, bool clockwise) {
 
 //Lines
 void IndexGenerator::AddLineList(int numVerts) {
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	// An odd vertex at the end still gets a (bogus) line, like in the scalar loop.
+	int numInds = (numVerts + 1) & ~1;
+	GenerateIndices(inds_, index_, numInds, offsets_ramp, increments_24);
+	inds_ += numInds;
+#else
 	u16 *outInds = inds_;
 	const int startIndex = index_;
 	for (int i = 0; i < numVerts; i += 2) {
@@ -235,6 +600,7 @@ void IndexGenerator::AddLineList(int numVerts) {
 		*outInds++ = startIndex + i + 1;
 	}
 	inds_ = outInds;
+#endif
 	index_ += numVerts;
 	count_ += numVerts;
 	prim_ = GE_PRIM_LINES;
@@ -243,6 +609,12 @@ void IndexGenerator::AddLineList(int numVerts) {
 
 void IndexGenerator::AddLineStrip(int numVerts) {
 	const int numLines = numVerts - 1;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	if (numLines > 0) {
+		GenerateIndices(inds_, index_, numLines * 2, offsets_line_strip, increments_12);
+		inds_ += numLines * 2;
+	}
+#else
 	u16 *outInds = inds_;
 	const int startIndex = index_;
 	for (int i = 0; i < numLines; i++) {
@@ -250,6 +622,7 @@ void IndexGenerator::AddLineStrip(int numVerts) {
 		*outInds++ = startIndex + i + 1;
 	}
 	inds_ = outInds;
+#endif
 	index_ += numVerts;
 	count_ += numLines * 2;
 	prim_ = GE_PRIM_LINES;
@@ -257,15 +630,20 @@ void IndexGenerator::AddLineStrip(int numVerts) {
 }
 
 void IndexGenerator::AddRectangles(int numVerts) {
-	u16 *outInds = inds_;
-	const int startIndex = index_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numVerts = numVerts & ~1;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	GenerateIndices(inds_, index_, numVerts, offsets_ramp, increments_24);
+	inds_ += numVerts;
+#else
+	u16 *outInds = inds_;
+	const int startIndex = index_;
 	for (int i = 0; i < numVerts; i += 2) {
 		*outInds++ = startIndex + i;
 		*outInds++ = startIndex + i + 1;
 	}
 	inds_ = outInds;
+#endif
 	index_ += numVerts;
 	count_ += numVerts;
 	prim_ = GE_PRIM_RECTANGLES;
@@ -276,7 +654,12 @@ template <class ITypeLE, int flag>
 void IndexGenerator::TranslatePoints(int numInds, const ITypeLE *inds, int indexOffset) {
 	indexOffset = index_ - indexOffset;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numInds; i++)
+	int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	i = TranslateIndices(outInds, inds, numInds, indexOffset);
+	outInds += i;
+#endif
+	for (; i < numInds; i++)
 		*outInds++ = indexOffset + inds[i];
 	inds_ = outInds;
 	count_ += numInds;
@@ -289,7 +672,12 @@ void IndexGenerator::TranslateLineList(int numInds, const ITypeLE *inds, int ind
 	indexOffset = index_ - indexOffset;
 	u16 *outInds = inds_;
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
+	int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	i = TranslateIndices(outInds, inds, numInds, indexOffset);
+	outInds += i;
+#endif
+	for (; i < numInds; i += 2) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i + 1];
 	}
@@ -304,7 +692,12 @@ void IndexGenerator::TranslateLineStrip(int numInds, const ITypeLE *inds, int in
 	indexOffset = index_ - indexOffset;
 	int numLines = numInds - 1;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numLines; i++) {
+	int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	i = TranslateLineStripSegments(outInds, inds, numLines, indexOffset);
+	outInds += i * 2;
+#endif
+	for (; i < numLines; i++) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i + 1];
 	}
@@ -329,7 +722,17 @@ void IndexGenerator::TranslateList(int numInds, const ITypeLE *inds, int indexOf
 		numInds = numTris * 3;
 		const int v1 = clockwise ? 1 : 2;
 		const int v2 = clockwise ? 2 : 1;
-		for (int i = 0; i < numInds; i += 3) {
+		int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+		if (clockwise) {
+			// Stop at a triangle boundary so the scalar loop can pick up from there.
+			i = (TranslateIndices(outInds, inds, numInds, indexOffset) / 3) * 3;
+		} else {
+			i = TranslateListSwapped(outInds, inds, numInds, indexOffset);
+		}
+		outInds += i;
+#endif
+		for (; i < numInds; i += 3) {
 			*outInds++ = indexOffset + inds[i];
 			*outInds++ = indexOffset + inds[i + v1];
 			*outInds++ = indexOffset + inds[i + v2];
@@ -347,7 +750,12 @@ void IndexGenerator::TranslateStrip(int numInds, const ITypeLE *inds, int indexO
 	indexOffset = index_ - indexOffset;
 	int numTris = numInds - 2;
 	u16 *outInds = inds_;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	i = TranslateStripTriangles(outInds, inds, numTris, indexOffset, clockwise);
+	outInds += i * 3;
+#endif
+	for (; i < numTris; i++) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i + wind];
 		wind ^= 3;  // Toggle between 1 and 2
@@ -367,7 +775,12 @@ void IndexGenerator::TranslateFan(int numInds, const ITypeLE *inds, int indexOff
 	u16 *outInds = inds_;
 	const int v1 = clockwise ? 1 : 2;
 	const int v2 = clockwise ? 2 : 1;
-	for (int i = 0; i < numTris; i++) {
+	int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	i = TranslateFanTriangles(outInds, inds, numTris, indexOffset, clockwise);
+	outInds += i * 3;
+#endif
+	for (; i < numTris; i++) {
 		*outInds++ = indexOffset + inds[0];
 		*outInds++ = indexOffset + inds[i + v1];
 		*outInds++ = indexOffset + inds[i + v2];
@@ -384,7 +797,12 @@ inline void IndexGenerator::TranslateRectangles(int numInds, const ITypeLE *inds
 	u16 *outInds = inds_;
 	//rectangles always need 2 vertices, disregard the last one if there's an odd number
 	numInds = numInds & ~1;
-	for (int i = 0; i < numInds; i += 2) {
+	int i = 0;
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	i = TranslateIndices(outInds, inds, numInds, indexOffset);
+	outInds += i;
+#endif
+	for (; i < numInds; i += 2) {
 		*outInds++ = indexOffset + inds[i];
 		*outInds++ = indexOffset + inds[i+1];
 	}
@@ -22,6 +22,7 @@
 
 #include "Common/CPUDetect.h"
 
+#include "Core/ThreadPools.h"
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/DrawEngineCommon.h"
@@ -50,6 +51,9 @@ class SimpleBufferManager {
 
 namespace Spline {
 
+// Below this, handing the work to the thread pool costs more than it saves.
+static const int PARALLEL_TESSELLATION_MIN_VERTICES = 4096;
+
 static void CopyQuadIndex(u16 *&indices, GEPatchPrimType type, const int idx0, const int idx1, const int idx2, const int idx3) {
 	if (type == GE_PATCHPRIM_LINES) {
 		*(indices++) = idx0;
@@ -115,6 +119,10 @@ class Bezier3DWeight {
 		return tess + 1;
 	}
 
+	static int CalcSizeFromKey(u32 key) {
+		return (int)key + 1;
+	}
+
 	static WeightCache<Bezier3DWeight> weightsCache;
 };
 
@@ -272,6 +280,12 @@ class Spline3DWeight {
 		return (count - 3) * tess + 1;
 	}
 
+	static int CalcSizeFromKey(u32 key) {
+		int tess, count, type;
+		FromKey(key, tess, count, type);
+		return CalcSize(tess, count);
+	}
+
 	static WeightCache<Spline3DWeight> weightsCache;
 };
 
@@ -315,8 +329,33 @@ class Tessellator {
 
 		return Sample(u, weights);
 	}
+
+	// Samples component c of 4 consecutive points along V at once, one per lane.
+	// Same operation order as Sample(), so the results match it exactly.
+	Vec4f SampleV4(int c, const Vec4f weights[4]) const {
+		return weights[0] * u[0][c] + weights[1] * u[1][c] + weights[2] * u[2][c] + weights[3] * u[3][c];
+	}
 };
 
+// Normalizes 4 vectors at once, given as one component per argument.
+static inline void NormalizeLanes(Vec4f &x, Vec4f &y, Vec4f &z) {
+	const Vec4f len2 = x * x + y * y + z * z;
+#ifdef _M_SSE
+	// Matches Vec3f::Normalized(), which also uses rsqrt.
+	const Vec4f factor(_mm_rsqrt_ps(len2.vec));
+	x = x * factor;
+	y = y * factor;
+	z = z * factor;
+#else
+	for (int l = 0; l < 4; ++l) {
+		const float len = sqrtf(len2[l]);
+		x[l] /= len;
+		y[l] /= len;
+		z[l] /= len;
+	}
+#endif
+}
+
 ControlPoints::ControlPoints(const SimpleVertex *const *points, int size, SimpleBufferManager &managedBuf) {
 	pos = (Vec3f *)managedBuf.Allocate(sizeof(Vec3f) * size);
 	tex = (Vec2f *)managedBuf.Allocate(sizeof(Vec2f) * size);
@@ -336,13 +375,24 @@ void ControlPoints::Convert(const SimpleVertex *const *points, int size) {
 template<class Surface>
 class SubdivisionSurface {
 public:
-	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool useSSE4, bool patchFacing>
-	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights) {
+	// Tessellates a range of U columns, each column being one tile_u of one patch_u.
+	// Every vertex is written by exactly one column, so ranges can run in parallel.
+	// Along V, points are evaluated 4 at a time, one per lane.
+	template <bool sampleNrm, bool sampleCol, bool sampleTex, bool patchFacing>
+	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, int lower, int upper) {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
+		const int columns_per_patch = surface.tess_u + 1;
+
+		for (int column = lower; column < upper; ++column) {
+			const int patch_u = column / columns_per_patch;
+			const int tile_u = column % columns_per_patch;
+			if (tile_u < surface.GetTessStart(patch_u))
+				continue;
+
+			const int index_u = surface.GetIndexU(patch_u, tile_u);
+			const Weight &wu = weights.u[index_u];
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
-			const int start_u = surface.GetTessStart(patch_u);
 			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
 				const int start_v = surface.GetTessStart(patch_v);
 
@@ -354,46 +404,94 @@ class SubdivisionSurface {
 				Tessellator<Vec2f> tess_tex(points.tex, idx_v);
 				Tessellator<Vec3f> tess_nrm(points.pos, idx_v);
 
-				for (int tile_u = start_u; tile_u <= surface.tess_u; ++tile_u) {
-					const int index_u = surface.GetIndexU(patch_u, tile_u);
-					const Weight &wu = weights.u[index_u];
+				// Pre-tessellate U lines
+				tess_pos.SampleU(wu.basis);
+				if (sampleCol)
+					tess_col.SampleU(wu.basis);
+				if (sampleTex)
+					tess_tex.SampleU(wu.basis);
+				if (sampleNrm)
+					tess_nrm.SampleU(wu.deriv);
 
-					// Pre-tessellate U lines
-					tess_pos.SampleU(wu.basis);
-					if (sampleCol)
-						tess_col.SampleU(wu.basis);
-					if (sampleTex)
-						tess_tex.SampleU(wu.basis);
-					if (sampleNrm)
-						tess_nrm.SampleU(wu.deriv);
+				for (int tile_v = start_v; tile_v <= surface.tess_v; tile_v += 4) {
+					const int index_v = surface.GetIndexV(patch_v, tile_v);
+					const int lanes = std::min(4, surface.tess_v + 1 - tile_v);
+					const Vec4f basis[4] = {
+						Vec4f(weights.v_soa.basis[0] + index_v),
+						Vec4f(weights.v_soa.basis[1] + index_v),
+						Vec4f(weights.v_soa.basis[2] + index_v),
+						Vec4f(weights.v_soa.basis[3] + index_v),
+					};
+
+					// Tessellate
+					const Vec4f pos_x = tess_pos.SampleV4(0, basis);
+					const Vec4f pos_y = tess_pos.SampleV4(1, basis);
+					const Vec4f pos_z = tess_pos.SampleV4(2, basis);
+
+					Vec4f col_r, col_g, col_b, col_a;
+					if (sampleCol) {
+						col_r = tess_col.SampleV4(0, basis);
+						col_g = tess_col.SampleV4(1, basis);
+						col_b = tess_col.SampleV4(2, basis);
+						col_a = tess_col.SampleV4(3, basis);
+					}
 
-					for (int tile_v = start_v; tile_v <= surface.tess_v; ++tile_v) {
-						const int index_v = surface.GetIndexV(patch_v, tile_v);
-						const Weight &wv = weights.v[index_v];
+					Vec4f tex_u, tex_v;
+					if (sampleTex) {
+						tex_u = tess_tex.SampleV4(0, basis);
+						tex_v = tess_tex.SampleV4(1, basis);
+					}
+
+					Vec4f nrm_x, nrm_y, nrm_z;
+					if (sampleNrm) {
+						const Vec4f deriv[4] = {
+							Vec4f(weights.v_soa.deriv[0] + index_v),
+							Vec4f(weights.v_soa.deriv[1] + index_v),
+							Vec4f(weights.v_soa.deriv[2] + index_v),
+							Vec4f(weights.v_soa.deriv[3] + index_v),
+						};
+						const Vec4f derivU_x = tess_nrm.SampleV4(0, basis);
+						const Vec4f derivU_y = tess_nrm.SampleV4(1, basis);
+						const Vec4f derivU_z = tess_nrm.SampleV4(2, basis);
+						const Vec4f derivV_x = tess_pos.SampleV4(0, deriv);
+						const Vec4f derivV_y = tess_pos.SampleV4(1, deriv);
+						const Vec4f derivV_z = tess_pos.SampleV4(2, deriv);
+
+						// Cross(derivU, derivV)
+						nrm_x = derivU_y * derivV_z - derivU_z * derivV_y;
+						nrm_y = derivU_z * derivV_x - derivU_x * derivV_z;
+						nrm_z = derivU_x * derivV_y - derivU_y * derivV_x;
+						NormalizeLanes(nrm_x, nrm_y, nrm_z);
+						if (patchFacing) {
+							nrm_x = -nrm_x;
+							nrm_y = -nrm_y;
+							nrm_z = -nrm_z;
+						}
+					}
 
-						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v, patch_u, patch_v)];
+					for (int l = 0; l < lanes; ++l) {
+						SimpleVertex &vert = output.vertices[surface.GetIndex(index_u, index_v + l, patch_u, patch_v)];
 
-						// Tessellate
-						vert.pos = tess_pos.SampleV(wv.basis);
+						vert.pos.x = pos_x[l];
+						vert.pos.y = pos_y[l];
+						vert.pos.z = pos_z[l];
 						if (sampleCol) {
-							vert.color_32 = tess_col.SampleV(wv.basis).ToRGBA();
+							vert.color_32 = Vec4f(col_r[l], col_g[l], col_b[l], col_a[l]).ToRGBA();
 						} else {
 							vert.color_32 = points.defcolor;
 						}
 						if (sampleTex) {
-							tess_tex.SampleV(wv.basis).Write(vert.uv);
+							vert.uv[0] = tex_u[l];
+							vert.uv[1] = tex_v[l];
 						} else {
 							// Generate texcoord
 							vert.uv[0] = patch_u + tile_u * inv_u;
-							vert.uv[1] = patch_v + tile_v * inv_v;
+							vert.uv[1] = patch_v + (tile_v + l) * inv_v;
 						}
 						if (sampleNrm) {
-							const Vec3f derivU = tess_nrm.SampleV(wv.basis);
-							const Vec3f derivV = tess_pos.SampleV(wv.deriv);
-
-							vert.nrm = Cross(derivU, derivV).Normalized(useSSE4);
-							if (patchFacing)
-								vert.nrm *= -1.0f;
+							vert.nrm.x = nrm_x[l];
+							vert.nrm.y = nrm_y[l];
+							vert.nrm.z = nrm_z[l];
 						} else {
 							vert.nrm.SetZero();
 							vert.nrm.z = 1.0f;
@@ -402,11 +500,9 @@ class SubdivisionSurface {
 				}
 			}
 		}
-
-		surface.BuildIndex(output.indices, output.count);
 	}
 
-	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &);
+	using TessFunc = void(*)(OutputBuffers &, const Surface &, const ControlPoints &, const Weight2D &, int, int);
 	TEMPLATE_PARAMETER_DISPATCHER_FUNCTION(Tess, SubdivisionSurface::Tessellate, TessFunc);
 
 	static void Tessellate(OutputBuffers &output, const Surface &surface, const ControlPoints &points, const Weight2D &weights, u32 origVertType) {
@@ -414,13 +510,23 @@ class SubdivisionSurface {
 			(origVertType & GE_VTYPE_NRM_MASK) != 0 || gstate.isLightingEnabled(),
 			(origVertType & GE_VTYPE_COL_MASK) != 0,
 			(origVertType & GE_VTYPE_TC_MASK) != 0,
-			cpu_info.bSSE4_1,
 			surface.patchFacing,
 		};
 		static TemplateParameterDispatcher<TessFunc, ARRAY_SIZE(params), Tess> dispatcher; // Initialize only once
 
 		TessFunc func = dispatcher.GetFunc(params);
-		func(output, surface, points, weights);
+		const int columns = surface.num_patches_u * (surface.tess_u + 1);
+		const int numVertices = columns * surface.num_patches_v * (surface.tess_v + 1);
+		if (numVertices >= PARALLEL_TESSELLATION_MIN_VERTICES) {
+			// Large patches are split by U column across the thread pool.
+			GlobalThreadPool::Loop([&](int lower, int upper) {
+				func(output, surface, points, weights, lower, upper);
+			}, 0, columns);
+		} else {
+			func(output, surface, points, weights, 0, columns);
+		}
+
+		surface.BuildIndex(output.indices, output.count);
 	}
 };
 
@@ -430,6 +536,7 @@ void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 ori
 	u32 key_u = WeightType::ToKey(surface.tess_u, surface.num_points_u, surface.type_u);
 	u32 key_v = WeightType::ToKey(surface.tess_v, surface.num_points_v, surface.type_v);
 	Weight2D weights(WeightType::weightsCache, key_u, key_v);
+	weights.v_soa = WeightType::weightsCache.GetSoA(key_v);
 
 	SubdivisionSurface<Surface>::Tessellate(output, surface, points, weights, origVertType);
 }
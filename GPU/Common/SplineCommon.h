@@ -155,10 +155,18 @@ struct Weight {
 	float basis[4], deriv[4];
 };
 
+// The same weights transposed into one array per term, so that several consecutive
+// points can be evaluated at once. Padded with zero weights so 4 can always be loaded.
+struct WeightSoA {
+	const float *basis[4];
+	const float *deriv[4];
+};
+
 template<class T>
 class WeightCache : public T {
 private:
 	std::unordered_map<u32, Weight*> weightsCache;
+	std::unordered_map<u32, float*> weightsSoACache;
 public:
 	Weight* operator [] (u32 key) {
 		Weight *&weights = weightsCache[key];
@@ -167,16 +175,44 @@ class WeightCache : public T {
 		return weights;
 	}
 
+	WeightSoA GetSoA(u32 key) {
+		const int size = T::CalcSizeFromKey(key);
+		const int stride = (size + 3 + 3) & ~3;
+		float *&planes = weightsSoACache[key];
+		if (!planes) {
+			const Weight *weights = (*this)[key];
+			planes = new float[stride * 8]();
+			for (int i = 0; i < size; ++i) {
+				for (int j = 0; j < 4; ++j) {
+					planes[stride * j + i] = weights[i].basis[j];
+					planes[stride * (j + 4) + i] = weights[i].deriv[j];
+				}
+			}
+		}
+
+		WeightSoA soa;
+		for (int j = 0; j < 4; ++j) {
+			soa.basis[j] = planes + stride * j;
+			soa.deriv[j] = planes + stride * (j + 4);
+		}
+		return soa;
+	}
+
 	void Clear() {
 		for (auto it : weightsCache)
 			delete[] it.second;
 		weightsCache.clear();
+		for (auto it : weightsSoACache)
+			delete[] it.second;
+		weightsSoACache.clear();
 	}
 };
 
 struct Weight2D {
 	const Weight *u, *v;
 	int size_u, size_v;
+	// Only filled in for software tessellation, which evaluates several points along V at once.
+	WeightSoA v_soa;
 
 	template<class T>
 	Weight2D(WeightCache<T> &cache, u32 key_u, u32 key_v) {
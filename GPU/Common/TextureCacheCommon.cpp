@@ -21,7 +21,9 @@
 #include "Common/Profiler/Profiler.h"
 #include "Common/ColorConv.h"
 #include "Common/MemoryUtil.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/MemWriteTracker.h"
 #include "Core/Reporting.h"
 #include "Core/System.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
@@ -431,6 +433,11 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 				match = false;
 			} else if (entry->GetHashStatus() == TexCacheEntry::STATUS_RELIABLE) {
 				rehash = false;
+			} else if (entry->writeStamp != 0 && g_Config.bTextureWriteTracking) {
+				// We know exactly whether it was written, so ignore the guesswork above.
+				// A wider bufw would cover pages we never watched, though.
+				const u32 sizeInRAM = (textureBitsPerPixel[format] * bufw * gstate.getTextureHeight(0)) / 8;
+				rehash = bufw != entry->bufw || Memory::WriteTracker_WrittenSince(texaddr, sizeInRAM, entry->writeStamp);
 			}
 		}
 
@@ -442,6 +449,15 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			}
 		}
 
+		if (match && (entry->status & TexCacheEntry::STATUS_TO_REPLACE)) {
+			// The replacement was still loading when we built this, rebuild if it's ready now.
+			int replaceW, replaceH;
+			if (FindReplacement(entry, replaceW, replaceH).Valid()) {
+				match = false;
+				reason = "replacing";
+			}
+		}
+
 		if (match) {
 			// got one!
 			gstate_c.curTextureWidth = w;
@@ -1286,6 +1302,7 @@ static inline void ConvertFormatToRGBA8888(GEPaletteFormat format, u32 *dst, con
 }
 
 void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, bool reverseColors, bool useBGRA, bool expandTo32bit) {
+	const double decodeStart = coreCollectDebugStats ? time_now_d() : 0.0;
 	bool swizzled = gstate.isTextureSwizzled();
 	if ((texaddr & 0x00600000) != 0 && Memory::IsVRAMAddress(texaddr)) {
 		// This means it's in a mirror, possibly a swizzled mirror.  Let's report.
@@ -1524,6 +1541,9 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		ERROR_LOG_REPORT(G3D, "Unknown Texture Format %d!!!", format);
 		break;
 	}
+
+	if (decodeStart != 0.0)
+		gpuStats.msDecodingTextures += time_now_d() - decodeStart;
 }
 
 void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool expandTo32Bit) {
@@ -1635,6 +1655,7 @@ void TextureCacheCommon::ApplyTexture() {
 			// Update the hash on the texture.
 			int w = gstate.getTextureWidth(0);
 			int h = gstate.getTextureHeight(0);
+			WatchTextureWrites(entry, h);
 			entry->fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
 
 			// TODO: Here we could check the secondary cache; maybe the texture is in there?
@@ -1697,10 +1718,34 @@ void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
 	cache_.erase(it);
 }
 
+ReplacedTexture &TextureCacheCommon::FindReplacement(TexCacheEntry *entry, int &w, int &h) {
+	u64 cachekey = replacer_.Enabled() ? entry->CacheKey() : 0;
+	w = gstate.getTextureWidth(0);
+	h = gstate.getTextureHeight(0);
+	ReplacedTexture &replaced = replacer_.FindReplacement(cachekey, entry->fullhash, w, h);
+	if (replaced.IsReady()) {
+		entry->status &= ~TexCacheEntry::STATUS_TO_REPLACE;
+	} else {
+		// Use the original texture for now, SetTexture() will notice once it's loaded.
+		entry->status |= TexCacheEntry::STATUS_TO_REPLACE;
+	}
+	return replaced;
+}
+
+void TextureCacheCommon::WatchTextureWrites(TexCacheEntry *entry, int h) {
+	// Must be before hashing, so that any write after the hash is seen.
+	entry->writeStamp = 0;
+	if (g_Config.bTextureWriteTracking) {
+		const u32 sizeInRAM = (textureBitsPerPixel[entry->format] * entry->bufw * h) / 8;
+		entry->writeStamp = Memory::WriteTracker_Watch(entry->addr, sizeInRAM);
+	}
+}
+
 bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	int w = gstate.getTextureWidth(0);
 	int h = gstate.getTextureHeight(0);
 	u32 fullhash;
+	WatchTextureWrites(entry, h);
 	{
 		PROFILE_THIS_SCOPE("texhash");
 		fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
@@ -138,6 +138,7 @@ struct TexCacheEntry {
 		STATUS_FRAMEBUFFER_OVERLAP = 0x800,
 
 		STATUS_FORCE_REBUILD = 0x1000,
+		STATUS_TO_REPLACE = 0x2000,    // Pending texture replacement, still loading when built.
 	};
 
 	// Status, but int so we can zero initialize.
@@ -165,6 +166,7 @@ struct TexCacheEntry {
 	u32 framesUntilNextFullHash;
 	u32 fullhash;
 	u32 cluthash;
+	u32 writeStamp;  // Nonzero if writes to level 0 are being tracked, see Memory::WriteTracker_Watch().
 	u16 maxSeenV;
 
 	TexStatus GetHashStatus() {
@@ -278,6 +280,8 @@ class TextureCacheCommon {
 	virtual void BuildTexture(TexCacheEntry *const entry) = 0;
 	virtual void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) = 0;
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
+	void WatchTextureWrites(TexCacheEntry *entry, int h);
+	ReplacedTexture &FindReplacement(TexCacheEntry *entry, int &w, int &h);
 
 	void DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, bool reverseColors, bool useBGRA, bool expandTo32Bit);
 	void UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel);
@@ -29,6 +29,9 @@
 
 #ifdef _M_SSE
 #include <emmintrin.h>
+#if _M_SSE >= 0x301
+#include <tmmintrin.h>
+#endif
 #if _M_SSE >= 0x401
 #include <smmintrin.h>
 #endif
@@ -409,7 +412,47 @@ void DXTDecoder::DecodeAlphaDXT5(const DXT5Block *src) {
 	}
 }
 
+#ifdef _M_SSE
+// Picks one of the four colors for each pixel in a line, by their 2-bit indices.
+struct DXTColorSelectSSE2 {
+	explicit DXTColorSelectSSE2(const u32 colors[4]) {
+		c0 = _mm_set1_epi32(colors[0]);
+		d01 = _mm_set1_epi32(colors[0] ^ colors[1]);
+		c2 = _mm_set1_epi32(colors[2]);
+		d23 = _mm_set1_epi32(colors[2] ^ colors[3]);
+	}
+
+	inline __m128i Select(u32 colordata) const {
+		const __m128i lowBits = _mm_set_epi32(1 << 6, 1 << 4, 1 << 2, 1 << 0);
+		const __m128i highBits = _mm_set_epi32(2 << 6, 2 << 4, 2 << 2, 2 << 0);
+		const __m128i data = _mm_set1_epi32(colordata);
+		const __m128i low = _mm_cmpeq_epi32(_mm_and_si128(data, lowBits), lowBits);
+		const __m128i high = _mm_cmpeq_epi32(_mm_and_si128(data, highBits), highBits);
+
+		// The low bit picks 0 or 1 and 2 or 3, then the high bit picks between those.
+		const __m128i c01 = _mm_xor_si128(c0, _mm_and_si128(d01, low));
+		const __m128i c23 = _mm_xor_si128(c2, _mm_and_si128(d23, low));
+		return _mm_xor_si128(c01, _mm_and_si128(_mm_xor_si128(c01, c23), high));
+	}
+
+	__m128i c0, d01, c2, d23;
+};
+#endif
+
 void DXTDecoder::WriteColorsDXT1(u32 *dst, const DXT1Block *src, int pitch, int height) {
+#ifdef _M_SSE
+	const DXTColorSelectSSE2 select(colors_);
+	for (int y = 0; y < height; y++) {
+		_mm_storeu_si128((__m128i *)dst, select.Select(src->lines[y]));
+		dst += pitch;
+	}
+#else
+#if PPSSPP_ARCH(ARM_NEON)
+	if (cpu_info.bNEON) {
+		WriteDXTColorsNEON(dst, colors_, src->lines, nullptr, pitch, height);
+		return;
+	}
+#endif
 	for (int y = 0; y < height; y++) {
 		int colordata = src->lines[y];
 		for (int x = 0; x < 4; x++) {
@@ -418,9 +461,36 @@ void DXTDecoder::WriteColorsDXT1(u32 *dst, const DXT1Block *src, int pitch, int
 		}
 		dst += pitch;
 	}
+#endif
 }
 
 void DXTDecoder::WriteColorsDXT3(u32 *dst, const DXT3Block *src, int pitch, int height) {
+#ifdef _M_SSE
+	const DXTColorSelectSSE2 select(colors_);
+	// Multiplying the high 16 bits shifts each pixel's 4-bit alpha to the top of its lane.
+	const __m128i alphaShift = _mm_set_epi32(1 << 16, 1 << 20, 1 << 24, 1 << 28);
+	const __m128i alphaMask = _mm_set1_epi32(0xF0000000);
+	for (int y = 0; y < height; y++) {
+		const __m128i alphadata = _mm_set1_epi32((u32)src->alphaLines[y] << 16);
+		const __m128i alpha = _mm_and_si128(_mm_mullo_epi16(alphadata, alphaShift), alphaMask);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(select.Select(src->color.lines[y]), alpha));
+		dst += pitch;
+	}
+#else
+#if PPSSPP_ARCH(ARM_NEON)
+	if (cpu_info.bNEON) {
+		u32 alphas[16];
+		for (int y = 0; y < height; y++) {
+			u32 alphadata = src->alphaLines[y];
+			for (int x = 0; x < 4; x++) {
+				alphas[y * 4 + x] = alphadata << 28;
+				alphadata >>= 4;
+			}
+		}
+		WriteDXTColorsNEON(dst, colors_, src->color.lines, alphas, pitch, height);
+		return;
+	}
+#endif
 	for (int y = 0; y < height; y++) {
 		int colordata = src->color.lines[y];
 		u32 alphadata = src->alphaLines[y];
@@ -431,12 +501,38 @@ void DXTDecoder::WriteColorsDXT3(u32 *dst, const DXT3Block *src, int pitch, int
 		}
 		dst += pitch;
 	}
+#endif
 }
 
 void DXTDecoder::WriteColorsDXT5(u32 *dst, const DXT5Block *src, int pitch, int height) {
 	// 48 bits, 3 bit index per pixel, 12 bits per line.
 	u64 alphadata = ((u64)(u16)src->alphadata1 << 32) | (u32)src->alphadata2;
 
+#if defined(_M_SSE) || PPSSPP_ARCH(ARM_NEON)
+	// The alpha lookup stays scalar, it's only 8 entries but 3 bits per pixel.
+	alignas(16) u32 alphas[16];
+	for (int i = 0; i < height * 4; i++) {
+		alphas[i] = alpha_[alphadata & 7] << 24;
+		alphadata >>= 3;
+	}
+#endif
+
+#ifdef _M_SSE
+	const DXTColorSelectSSE2 select(colors_);
+	for (int y = 0; y < height; y++) {
+		const __m128i alpha = _mm_load_si128((const __m128i *)&alphas[y * 4]);
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(select.Select(src->color.lines[y]), alpha));
+		dst += pitch;
+	}
+#else
+#if PPSSPP_ARCH(ARM_NEON)
+	if (cpu_info.bNEON) {
+		WriteDXTColorsNEON(dst, colors_, src->color.lines, alphas, pitch, height);
+		return;
+	}
+	// We already consumed the alpha data above.
+	alphadata = ((u64)(u16)src->alphadata1 << 32) | (u32)src->alphadata2;
+#endif
 	for (int y = 0; y < height; y++) {
 		int colordata = src->color.lines[y];
 		for (int x = 0; x < 4; x++) {
@@ -446,6 +542,7 @@ void DXTDecoder::WriteColorsDXT5(u32 *dst, const DXT5Block *src, int pitch, int
 		}
 		dst += pitch;
 	}
+#endif
 }
 
 // This could probably be done faster by decoding two or four blocks at a time with SSE/NEON.
@@ -469,6 +566,107 @@ void DecodeDXT5Block(u32 *dst, const DXT5Block *src, int pitch, int height) {
 	dxt.WriteColorsDXT5(dst, src, pitch, height);
 }
 
+template <typename ClutT>
+static inline void DeIndexTexture4Scalar(ClutT *dest, const u8 *indexed, int length, const ClutT *clut) {
+	for (int i = 0; i < length; i += 2) {
+		u8 index = *indexed++;
+		dest[i + 0] = clut[(index >> 0) & 0xf];
+		dest[i + 1] = clut[(index >> 4) & 0xf];
+	}
+}
+
+#if _M_SSE >= 0x301
+// Splits 16 bytes of 4-bit indices into two vectors of 8-bit indices, in pixel order.
+static inline void SplitIndices4SSSE3(const u8 *indexed, __m128i &index0, __m128i &index1) {
+	const __m128i mask4 = _mm_set1_epi8(0x0F);
+	const __m128i bytes = _mm_loadu_si128((const __m128i *)indexed);
+	const __m128i lo = _mm_and_si128(bytes, mask4);
+	const __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask4);
+	// The low nibble is the first pixel.
+	index0 = _mm_unpacklo_epi8(lo, hi);
+	index1 = _mm_unpackhi_epi8(lo, hi);
+}
+#endif
+
+void DeIndexTexture4Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	int i = 0;
+#if _M_SSE >= 0x301
+	if (length >= 32) {
+		// With only 16 entries, we can split the CLUT into byte tables and look up with pshufb.
+		const __m128i mask8 = _mm_set1_epi16(0x00FF);
+		const __m128i c0 = _mm_loadu_si128((const __m128i *)clut);
+		const __m128i c1 = _mm_loadu_si128((const __m128i *)(clut + 8));
+		const __m128i table0 = _mm_packus_epi16(_mm_and_si128(c0, mask8), _mm_and_si128(c1, mask8));
+		const __m128i table1 = _mm_packus_epi16(_mm_srli_epi16(c0, 8), _mm_srli_epi16(c1, 8));
+
+		for (; i + 32 <= length; i += 32) {
+			__m128i index[2];
+			SplitIndices4SSSE3(indexed + i / 2, index[0], index[1]);
+			for (int j = 0; j < 2; ++j) {
+				const __m128i b0 = _mm_shuffle_epi8(table0, index[j]);
+				const __m128i b1 = _mm_shuffle_epi8(table1, index[j]);
+				__m128i *d = (__m128i *)(dest + i + j * 16);
+				_mm_storeu_si128(d + 0, _mm_unpacklo_epi8(b0, b1));
+				_mm_storeu_si128(d + 1, _mm_unpackhi_epi8(b0, b1));
+			}
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	if (length >= 16 && cpu_info.bNEON) {
+		i = length & ~15;
+		DeIndexTexture4NEON(dest, indexed, i, clut);
+	}
+#endif
+	DeIndexTexture4Scalar(dest + i, indexed + i / 2, length - i, clut);
+}
+
+void DeIndexTexture4Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	int i = 0;
+#if _M_SSE >= 0x301
+	if (length >= 32) {
+		// Same idea, but four tables, one for each byte of the color.
+		const __m128i mask8 = _mm_set1_epi32(0x000000FF);
+		__m128i c[4];
+		for (int k = 0; k < 4; ++k)
+			c[k] = _mm_loadu_si128((const __m128i *)(clut + k * 4));
+		__m128i table[4];
+		for (int k = 0; k < 4; ++k) {
+			const __m128i shift = _mm_cvtsi32_si128(k * 8);
+			__m128i b[4];
+			for (int n = 0; n < 4; ++n)
+				b[n] = _mm_and_si128(_mm_srl_epi32(c[n], shift), mask8);
+			table[k] = _mm_packus_epi16(_mm_packs_epi32(b[0], b[1]), _mm_packs_epi32(b[2], b[3]));
+		}
+
+		for (; i + 32 <= length; i += 32) {
+			__m128i index[2];
+			SplitIndices4SSSE3(indexed + i / 2, index[0], index[1]);
+			for (int j = 0; j < 2; ++j) {
+				const __m128i b0 = _mm_shuffle_epi8(table[0], index[j]);
+				const __m128i b1 = _mm_shuffle_epi8(table[1], index[j]);
+				const __m128i b2 = _mm_shuffle_epi8(table[2], index[j]);
+				const __m128i b3 = _mm_shuffle_epi8(table[3], index[j]);
+				const __m128i b01lo = _mm_unpacklo_epi8(b0, b1);
+				const __m128i b01hi = _mm_unpackhi_epi8(b0, b1);
+				const __m128i b23lo = _mm_unpacklo_epi8(b2, b3);
+				const __m128i b23hi = _mm_unpackhi_epi8(b2, b3);
+				__m128i *d = (__m128i *)(dest + i + j * 16);
+				_mm_storeu_si128(d + 0, _mm_unpacklo_epi16(b01lo, b23lo));
+				_mm_storeu_si128(d + 1, _mm_unpackhi_epi16(b01lo, b23lo));
+				_mm_storeu_si128(d + 2, _mm_unpacklo_epi16(b01hi, b23hi));
+				_mm_storeu_si128(d + 3, _mm_unpackhi_epi16(b01hi, b23hi));
+			}
+		}
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	if (length >= 16 && cpu_info.bNEON) {
+		i = length & ~15;
+		DeIndexTexture4NEON(dest, indexed, i, clut);
+	}
+#endif
+	DeIndexTexture4Scalar(dest + i, indexed + i / 2, length - i, clut);
+}
+
 #ifdef _M_SSE
 static inline u32 CombineSSEBitsToDWORD(const __m128i &v) {
 	__m128i temp;
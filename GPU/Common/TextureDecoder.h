@@ -140,17 +140,17 @@ inline void DeIndexTexture(ClutT *dest, const u32 texaddr, int length, const Clu
 	DeIndexTexture(dest, indexed, length, clut);
 }
 
+// Expands 4-bit indices through the first 16 CLUT entries, without any offset, mask, or shift.
+void DeIndexTexture4Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+void DeIndexTexture4Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut);
+
 template <typename ClutT>
 inline void DeIndexTexture4(ClutT *dest, const u8 *indexed, int length, const ClutT *clut) {
 	// Usually, there is no special offset, mask, or shift.
 	const bool nakedIndex = gstate.isClutIndexSimple();
 
 	if (nakedIndex) {
-		for (int i = 0; i < length; i += 2) {
-			u8 index = *indexed++;
-			dest[i + 0] = clut[(index >> 0) & 0xf];
-			dest[i + 1] = clut[(index >> 4) & 0xf];
-		}
+		DeIndexTexture4Simple(dest, indexed, length, clut);
 	} else {
 		for (int i = 0; i < length; i += 2) {
 			u8 index = *indexed++;
@@ -292,4 +292,74 @@ CheckAlphaResult CheckAlphaRGBA5551NEON(const u32 *pixelData, int stride, int w,
 	return CHECKALPHA_FULL;
 }
 
+void WriteDXTColorsNEON(u32 *dst, const u32 *colors, const u8 *lines, const u32 *alphas, int pitch, int height) {
+	static const u32 lowBitsData[4] = { 1 << 0, 1 << 2, 1 << 4, 1 << 6 };
+	const uint32x4_t lowBits = vld1q_u32(lowBitsData);
+	const uint32x4_t highBits = vshlq_n_u32(lowBits, 1);
+	const uint32x4_t c0 = vdupq_n_u32(colors[0]);
+	const uint32x4_t c1 = vdupq_n_u32(colors[1]);
+	const uint32x4_t c2 = vdupq_n_u32(colors[2]);
+	const uint32x4_t c3 = vdupq_n_u32(colors[3]);
+
+	for (int y = 0; y < height; y++) {
+		const uint32x4_t data = vdupq_n_u32(lines[y]);
+		const uint32x4_t low = vtstq_u32(data, lowBits);
+		const uint32x4_t high = vtstq_u32(data, highBits);
+
+		// The low bit picks 0 or 1 and 2 or 3, then the high bit picks between those.
+		const uint32x4_t c01 = vbslq_u32(low, c1, c0);
+		const uint32x4_t c23 = vbslq_u32(low, c3, c2);
+		uint32x4_t res = vbslq_u32(high, c23, c01);
+		if (alphas)
+			res = vorrq_u32(res, vld1q_u32(alphas + y * 4));
+		vst1q_u32(dst, res);
+		dst += pitch;
+	}
+}
+
+// Splits 8 bytes of 4-bit indices into 16 8-bit indices, in pixel order (low nibble first.)
+static inline uint8x8x2_t SplitIndices4NEON(const u8 *indexed) {
+	const uint8x8_t bytes = vld1_u8(indexed);
+	return vzip_u8(vand_u8(bytes, vdup_n_u8(0x0F)), vshr_n_u8(bytes, 4));
+}
+
+void DeIndexTexture4NEON(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	// This deinterleaves the 16 entries into tables of low and high bytes.
+	const uint8x16x2_t clutBytes = vld2q_u8((const u8 *)clut);
+	uint8x8x2_t table[2];
+	for (int k = 0; k < 2; ++k) {
+		table[k].val[0] = vget_low_u8(clutBytes.val[k]);
+		table[k].val[1] = vget_high_u8(clutBytes.val[k]);
+	}
+
+	for (int i = 0; i < length; i += 16) {
+		const uint8x8x2_t index = SplitIndices4NEON(indexed + i / 2);
+		for (int j = 0; j < 2; ++j) {
+			uint8x8x2_t res;
+			res.val[0] = vtbl2_u8(table[0], index.val[j]);
+			res.val[1] = vtbl2_u8(table[1], index.val[j]);
+			vst2_u8((u8 *)(dest + i + j * 8), res);
+		}
+	}
+}
+
+void DeIndexTexture4NEON(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	const uint8x16x4_t clutBytes = vld4q_u8((const u8 *)clut);
+	uint8x8x2_t table[4];
+	for (int k = 0; k < 4; ++k) {
+		table[k].val[0] = vget_low_u8(clutBytes.val[k]);
+		table[k].val[1] = vget_high_u8(clutBytes.val[k]);
+	}
+
+	for (int i = 0; i < length; i += 16) {
+		const uint8x8x2_t index = SplitIndices4NEON(indexed + i / 2);
+		for (int j = 0; j < 2; ++j) {
+			uint8x8x4_t res;
+			for (int k = 0; k < 4; ++k)
+				res.val[k] = vtbl2_u8(table[k], index.val[j]);
+			vst4_u8((u8 *)(dest + i + j * 8), res);
+		}
+	}
+}
+
 #endif
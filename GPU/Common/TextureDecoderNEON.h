@@ -25,3 +25,9 @@ CheckAlphaResult CheckAlphaABGR4444NEON(const u32 *pixelData, int stride, int w,
 CheckAlphaResult CheckAlphaABGR1555NEON(const u32 *pixelData, int stride, int w, int h);
 CheckAlphaResult CheckAlphaRGBA4444NEON(const u32 *pixelData, int stride, int w, int h);
 CheckAlphaResult CheckAlphaRGBA5551NEON(const u32 *pixelData, int stride, int w, int h);
+
+// Writes lines of a DXT block, with alphas (already shifted, 4 per line) optionally ORed in.
+void WriteDXTColorsNEON(u32 *dst, const u32 *colors, const u8 *lines, const u32 *alphas, int pitch, int height);
+// Length must be a multiple of 16.
+void DeIndexTexture4NEON(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+void DeIndexTexture4NEON(u32 *dest, const u8 *indexed, int length, const u32 *clut);
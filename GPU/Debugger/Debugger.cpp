@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <atomic>
+
 #include "Common/Log.h"
 #include "GPU/GPU.h"
 #include "GPU/Debugger/Breakpoints.h"
@@ -32,6 +34,8 @@ static int primsLastFrame = 0;
 static int primsThisFrame = 0;
 static int thisFlipNum = 0;
 
+static std::atomic<BeginFrameListener> beginFrameListener;
+
 static void Init() {
 	if (!inited) {
 		GPUBreakpoints::Init();
@@ -136,6 +140,16 @@ void NotifyTextureAttachment(u32 texaddr) {
 		return;
 }
 
+void NotifyBeginFrame() {
+	BeginFrameListener listener = beginFrameListener;
+	if (listener)
+		listener();
+}
+
+void SetBeginFrameListener(BeginFrameListener listener) {
+	beginFrameListener = listener;
+}
+
 int PrimsThisFrame() {
 	return primsThisFrame;
 }
@@ -44,6 +44,12 @@ void NotifyCommand(u32 pc);
 void NotifyDraw();
 void NotifyDisplay(u32 framebuf, u32 stride, int format);
 void NotifyTextureAttachment(u32 texaddr);
+// Called on the emu thread at the start of each frame, after the last one was displayed.
+void NotifyBeginFrame();
+
+// Allows a debugger tool to sample each frame (i.e. read back the display.)  Pass nullptr to stop.
+typedef void (*BeginFrameListener)();
+void SetBeginFrameListener(BeginFrameListener listener);
 
 int PrimsThisFrame();
 int PrimsLastFrame();
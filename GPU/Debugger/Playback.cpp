@@ -45,6 +45,9 @@ namespace GPURecord {
 static std::string lastExecFilename;
 static std::vector<Command> lastExecCommands;
 static std::vector<u8> lastExecPushbuf;
+// Index of the first command of each frame, and the next frame to run.
+static std::vector<size_t> lastExecFrames;
+static size_t lastExecFrame = 0;
 static std::mutex executeLock;
 
 // This class maps pushbuffer (dump data) sections to PSP memory.
@@ -280,7 +283,8 @@ class DumpExecute {
 	}
 	~DumpExecute();
 
-	bool Run();
+	// Runs commands from start up to (not including) end.
+	bool Run(size_t start, size_t end);
 
 private:
 	void SyncStall();
@@ -562,8 +566,9 @@ DumpExecute::~DumpExecute() {
 	mapping_.Reset();
 }
 
-bool DumpExecute::Run() {
-	for (const Command &cmd : commands_) {
+bool DumpExecute::Run(size_t start, size_t end) {
+	for (size_t i = start; i < end; ++i) {
+		const Command &cmd = commands_[i];
 		switch (cmd.type) {
 		case CommandType::INIT:
 			Init(cmd.ptr, cmd.sz);
@@ -662,9 +667,32 @@ static void ReplayStop() {
 	lastExecFilename.clear();
 	lastExecCommands.clear();
 	lastExecPushbuf.clear();
+	lastExecFrames.clear();
+	lastExecFrame = 0;
 }
 
-bool RunMountedReplay(const std::string &filename) {
+// Reads one frame's commands and data, appending them to what we have.
+static bool ReadChunk(u32 fp, bool *truncated) {
+	u32 sz = 0;
+	if (pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz)) != sizeof(sz)) {
+		// Not truncated, this is just the end.
+		return false;
+	}
+	u32 bufsz = 0;
+	pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
+
+	size_t commandsPos = lastExecCommands.size();
+	size_t bufPos = lastExecPushbuf.size();
+	lastExecFrames.push_back(commandsPos);
+	lastExecCommands.resize(commandsPos + sz);
+	lastExecPushbuf.resize(bufPos + bufsz);
+
+	*truncated = *truncated || !ReadCompressed(fp, lastExecCommands.data() + commandsPos, sizeof(Command) * sz);
+	*truncated = *truncated || !ReadCompressed(fp, lastExecPushbuf.data() + bufPos, bufsz);
+	return !*truncated;
+}
+
+bool RunMountedReplay(const std::string &filename, bool *lastFrame) {
 	_assert_msg_(!GPURecord::IsActivePending(), "Cannot run replay while recording.");
 
 	std::lock_guard<std::mutex> guard(executeLock);
@@ -690,30 +718,44 @@ bool RunMountedReplay(const std::string &filename) {
 			g_paramSFO.SetValue("DISC_ID", std::string(header.gameID, gameIDLength), (int)sizeof(header.gameID));
 		}
 
-		u32 sz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
-		u32 bufsz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
-
-		lastExecCommands.resize(sz);
-		lastExecPushbuf.resize(bufsz);
+		lastExecCommands.clear();
+		lastExecPushbuf.clear();
+		lastExecFrames.clear();
+		lastExecFrame = 0;
 
 		bool truncated = false;
-		truncated = truncated || !ReadCompressed(fp, lastExecCommands.data(), sizeof(Command) * sz);
-		truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data(), bufsz);
+		if (header.version >= 5) {
+			while (ReadChunk(fp, &truncated))
+				continue;
+		} else {
+			// Before version 5, there was always exactly one frame.
+			if (!ReadChunk(fp, &truncated))
+				truncated = true;
+		}
 
 		pspFileSystem.CloseFile(fp);
 
-		if (truncated) {
+		if (truncated || lastExecFrames.empty()) {
 			ERROR_LOG(SYSTEM, "Truncated GE dump");
+			lastExecCommands.clear();
+			lastExecPushbuf.clear();
+			lastExecFrames.clear();
 			return false;
 		}
 
 		lastExecFilename = filename;
 	}
 
+	// Each call runs the next frame, starting over after the last one.
+	size_t frame = lastExecFrame;
+	size_t start = lastExecFrames[frame];
+	size_t end = frame + 1 < lastExecFrames.size() ? lastExecFrames[frame + 1] : lastExecCommands.size();
+	lastExecFrame = (frame + 1) % lastExecFrames.size();
+	if (lastFrame)
+		*lastFrame = lastExecFrame == 0;
+
 	DumpExecute executor(lastExecPushbuf, lastExecCommands);
-	return executor.Run();
+	return executor.Run(start, end);
 }
 
 };
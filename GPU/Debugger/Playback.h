@@ -21,6 +21,7 @@
 
 namespace GPURecord {
 
-bool RunMountedReplay(const std::string &filename);
+// Runs the next frame of the dump, looping back to the first after the last.
+bool RunMountedReplay(const std::string &filename, bool *lastFrame = nullptr);
 
 };
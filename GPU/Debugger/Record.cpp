@@ -16,16 +16,23 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <functional>
+#include <mutex>
 #include <set>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 #include <snappy-c.h>
+#include "ext/xxhash.h"
 
 #include "Common/Common.h"
 #include "Common/File/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadUtil.h"
 
 #include "Core/Core.h"
 #include "Core/ELF/ParamSFO.h"
@@ -45,21 +52,57 @@ namespace GPURecord {
 static bool active = false;
 static bool nextFrame = false;
 static int flipLastAction = -1;
+// How many frames to record once started, and how many are left.  0 means until Deactivate().
+static int nextFrameCount = 1;
+static int framesLeft = 0;
+static bool stopPending = false;
 static std::function<void(const std::string &)> writeCallback;
 
+// Only the current frame's data.  Earlier frames were already handed to the write thread.
 static std::vector<u8> pushbuf;
+// Size of all data before pushbuf.  Command ptrs are relative to all data, not just this frame.
+static u32 pushbufBase = 0;
 static std::vector<Command> commands;
 static std::vector<u32> lastRegisters;
 static std::vector<u32> lastTextures;
 static std::set<u32> lastRenderTargets;
 
+// Replay has to load all of it, and ptrs are u32 anyway.
+static const u32 MAX_RECORDING_BYTES = 0x40000000;
+
+// Lets later frames point to textures, verts, etc. written in earlier frames.
+struct EmittedData {
+	u32 ptr;
+	u32 sz;
+};
+static std::unordered_map<u64, EmittedData> emittedData;
+
+// Each frame is compressed and written on this thread, so long recordings keep up.
+struct FrameChunk {
+	std::vector<Command> commands;
+	std::vector<u8> pushbuf;
+};
+static std::thread writeThread;
+static std::mutex writeLock;
+static std::condition_variable writeCond;
+static std::deque<FrameChunk> writeQueue;
+static bool writeFinished = false;
+static FILE *writeFile = nullptr;
+static std::string writeFilename;
+
+// Appends to the pushbuf, returning the ptr to use in a command.
+static u32 PushData(const void *p, u32 sz) {
+	u32 pos = (u32)pushbuf.size();
+	pushbuf.resize(pos + sz);
+	memcpy(pushbuf.data() + pos, p, sz);
+	return pushbufBase + pos;
+}
+
 static void FlushRegisters() {
 	if (!lastRegisters.empty()) {
 		Command last{CommandType::REGISTERS};
-		last.ptr = (u32)pushbuf.size();
 		last.sz = (u32)(lastRegisters.size() * sizeof(u32));
-		pushbuf.resize(pushbuf.size() + last.sz);
-		memcpy(pushbuf.data() + last.ptr, lastRegisters.data(), last.sz);
+		last.ptr = PushData(lastRegisters.data(), last.sz);
 		lastRegisters.clear();
 
 		commands.push_back(last);
@@ -82,21 +125,6 @@ static std::string GenRecordingFilename() {
 	return StringFromFormat("%s_%04d.ppdmp", prefix.c_str(), 9999);
 }
 
-static void BeginRecording() {
-	active = true;
-	nextFrame = false;
-	lastTextures.clear();
-	lastRenderTargets.clear();
-	flipLastAction = gpuStats.numFlips;
-
-	u32 ptr = (u32)pushbuf.size();
-	u32 sz = 512 * 4;
-	pushbuf.resize(pushbuf.size() + sz);
-	gstate.Save((u32_le *)(pushbuf.data() + ptr));
-
-	commands.push_back({CommandType::INIT, sz, ptr});
-}
-
 static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
 	size_t compressed_size = snappy_max_compressed_length(sz);
 	u8 *compressed = new u8[compressed_size];
@@ -109,31 +137,111 @@ static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
 	delete [] compressed;
 }
 
-static std::string WriteRecording() {
-	FlushRegisters();
+static void WriteChunk(FILE *fp, const FrameChunk &chunk) {
+	u32 sz = (u32)chunk.commands.size();
+	fwrite(&sz, sizeof(sz), 1, fp);
+	u32 bufsz = (u32)chunk.pushbuf.size();
+	fwrite(&bufsz, sizeof(bufsz), 1, fp);
 
-	const std::string filename = GenRecordingFilename();
+	WriteCompressed(fp, chunk.commands.data(), chunk.commands.size() * sizeof(Command));
+	WriteCompressed(fp, chunk.pushbuf.data(), bufsz);
+}
+
+static void WriteThreadFunc() {
+	setCurrentThreadName("GERecordWrite");
+
+	std::unique_lock<std::mutex> guard(writeLock);
+	while (true) {
+		writeCond.wait(guard, [] { return !writeQueue.empty() || writeFinished; });
+		if (writeQueue.empty()) {
+			break;
+		}
+
+		FrameChunk chunk = std::move(writeQueue.front());
+		writeQueue.pop_front();
+
+		guard.unlock();
+		WriteChunk(writeFile, chunk);
+		guard.lock();
+	}
+}
+
+// Drains the queue and stops the write thread, if one is running.
+static void StopWriteThread() {
+	if (!writeThread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(writeLock);
+		writeFinished = true;
+		writeCond.notify_one();
+	}
+	writeThread.join();
+}
+
+static bool BeginRecording() {
+	nextFrame = false;
+
+	// A previous recording should always have been finished, but never assign over a running thread.
+	StopWriteThread();
+	if (writeFile) {
+		fclose(writeFile);
+		writeFile = nullptr;
+	}
+
+	writeFilename = GenRecordingFilename();
+	writeFile = File::OpenCFile(writeFilename, "wb");
+	if (!writeFile) {
+		ERROR_LOG(G3D, "Could not open recording file: %s", writeFilename.c_str());
+		if (writeCallback)
+			writeCallback("");
+		writeCallback = nullptr;
+		return false;
+	}
 
-	NOTICE_LOG(G3D, "Recording filename: %s", filename.c_str());
+	NOTICE_LOG(G3D, "Recording filename: %s", writeFilename.c_str());
 
-	FILE *fp = File::OpenCFile(filename, "wb");
 	Header header{};
 	strncpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
 	header.version = VERSION;
 	strncpy(header.gameID, g_paramSFO.GetDiscID().c_str(), sizeof(header.gameID));
-	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(&header, sizeof(header), 1, writeFile);
 
-	u32 sz = (u32)commands.size();
-	fwrite(&sz, sizeof(sz), 1, fp);
-	u32 bufsz = (u32)pushbuf.size();
-	fwrite(&bufsz, sizeof(bufsz), 1, fp);
+	active = true;
+	framesLeft = nextFrameCount;
+	stopPending = false;
+	pushbufBase = 0;
+	emittedData.clear();
+	lastTextures.clear();
+	lastRenderTargets.clear();
+	flipLastAction = gpuStats.numFlips;
+
+	writeFinished = false;
+	writeThread = std::thread(&WriteThreadFunc);
+
+	u32_le regs[512];
+	gstate.Save(regs);
+	u32 sz = (u32)sizeof(regs);
+	commands.push_back({CommandType::INIT, sz, PushData(regs, sz)});
+	return true;
+}
 
-	WriteCompressed(fp, commands.data(), commands.size() * sizeof(Command));
-	WriteCompressed(fp, pushbuf.data(), bufsz);
+// Hands the current frame to the write thread.
+static void FlushChunk() {
+	FlushRegisters();
+
+	// Keep the next frame's data aligned, since ptrs are aligned relative to all data.
+	pushbuf.resize((pushbuf.size() + 15) & ~15);
 
-	fclose(fp);
+	FrameChunk chunk;
+	chunk.commands.swap(commands);
+	chunk.pushbuf.swap(pushbuf);
+	pushbufBase += (u32)chunk.pushbuf.size();
+	// These are positions in pushbuf, which is now empty.
+	lastTextures.clear();
 
-	return filename;
+	std::lock_guard<std::mutex> guard(writeLock);
+	writeQueue.push_back(std::move(chunk));
+	writeCond.notify_one();
 }
 
 static void GetVertDataSizes(int vcount, const void *indices, u32 &vbytes, u32 &ibytes) {
@@ -202,6 +310,15 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 alig
 	Command cmd{t, sz, 0};
 
 	if (sz) {
+		// Maybe we've seen this exact data before, even in a previous frame.
+		const u64 hash = XXH3_64bits(p, sz);
+		auto it = emittedData.find(hash);
+		if (it != emittedData.end() && it->second.sz == sz && (it->second.ptr & (align - 1)) == 0) {
+			cmd.ptr = it->second.ptr;
+			commands.push_back(cmd);
+			return cmd;
+		}
+
 		// If at all possible, try to find it already in the buffer.
 		const u8 *prev = nullptr;
 		const size_t NEAR_WINDOW = std::max((int)sz * 2, 1024 * 10);
@@ -214,20 +331,22 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 alig
 		}
 
 		if (prev) {
-			cmd.ptr = (u32)(prev - pushbuf.data());
+			cmd.ptr = pushbufBase + (u32)(prev - pushbuf.data());
 		} else {
-			cmd.ptr = (u32)pushbuf.size();
+			u32 pos = (u32)pushbuf.size();
 			int pad = 0;
-			if (cmd.ptr & (align - 1)) {
-				pad = align - (cmd.ptr & (align - 1));
-				cmd.ptr += pad;
+			if (pos & (align - 1)) {
+				pad = align - (pos & (align - 1));
+				pos += pad;
 			}
 			pushbuf.resize(pushbuf.size() + sz + pad);
 			if (pad) {
-				memset(pushbuf.data() + cmd.ptr - pad, 0, pad);
+				memset(pushbuf.data() + pos - pad, 0, pad);
 			}
-			memcpy(pushbuf.data() + cmd.ptr, p, sz);
+			memcpy(pushbuf.data() + pos, p, sz);
+			cmd.ptr = pushbufBase + pos;
 		}
+		emittedData[hash] = { cmd.ptr, sz };
 	}
 
 	commands.push_back(cmd);
@@ -280,7 +399,7 @@ static void EmitTextureData(int level, u32 texaddr) {
 			}
 
 			if (memcmp(pushbuf.data() + prevptr, p, bytes) == 0) {
-				commands.push_back({type, bytes, prevptr});
+				commands.push_back({type, bytes, pushbufBase + prevptr});
 				// Okay, that was easy.  Bail out.
 				return;
 			}
@@ -288,7 +407,9 @@ static void EmitTextureData(int level, u32 texaddr) {
 
 		// Not there, gotta emit anew.
 		Command cmd = EmitCommandWithRAM(type, p, bytes, 16);
-		lastTextures.push_back(cmd.ptr);
+		// Might be from a previous frame, which we can't memcmp against anymore.
+		if (cmd.ptr >= pushbufBase)
+			lastTextures.push_back(cmd.ptr - pushbufBase);
 	}
 }
 
@@ -389,33 +510,79 @@ bool IsActivePending() {
 }
 
 bool Activate() {
-	if (!nextFrame) {
+	return ActivateFrames(1);
+}
+
+bool ActivateFrames(int frames) {
+	// Don't let a bad count turn into recording forever.
+	if (frames < 0)
+		return false;
+	if (!nextFrame && !active) {
 		nextFrame = true;
+		nextFrameCount = frames;
 		flipLastAction = gpuStats.numFlips;
 		return true;
 	}
 	return false;
 }
 
+void Deactivate() {
+	if (active) {
+		stopPending = true;
+	} else if (nextFrame) {
+		nextFrame = false;
+		if (writeCallback)
+			writeCallback("");
+		writeCallback = nullptr;
+	}
+}
+
 void SetCallback(const std::function<void(const std::string &)> callback) {
 	writeCallback = callback;
 }
 
 static void FinishRecording() {
 	// We're done - this was just to write the result out.
-	std::string filename = WriteRecording();
-	commands.clear();
-	pushbuf.clear();
+	FlushChunk();
+	StopWriteThread();
+	fclose(writeFile);
+	writeFile = nullptr;
+	emittedData.clear();
 
 	NOTICE_LOG(SYSTEM, "Recording finished");
 	active = false;
 	flipLastAction = gpuStats.numFlips;
 
 	if (writeCallback)
-		writeCallback(filename);
+		writeCallback(writeFilename);
 	writeCallback = nullptr;
 }
 
+void Shutdown() {
+	// Write out whatever an open-ended recording has captured so far.
+	if (active) {
+		FinishRecording();
+	} else {
+		Deactivate();
+	}
+	StopWriteThread();
+}
+
+// Called once a DISPLAY command has ended a frame.
+static void EndFrame() {
+	bool done = stopPending || pushbufBase + (u32)pushbuf.size() >= MAX_RECORDING_BYTES;
+	if (framesLeft != 0 && --framesLeft == 0) {
+		done = true;
+	}
+
+	if (done) {
+		FinishRecording();
+	} else {
+		FlushChunk();
+		flipLastAction = gpuStats.numFlips;
+	}
+}
+
 void NotifyCommand(u32 pc) {
 	if (!active) {
 		return;
@@ -475,9 +642,8 @@ void NotifyMemcpy(u32 dest, u32 src, u32 sz) {
 	}
 	if (Memory::IsVRAMAddress(dest)) {
 		FlushRegisters();
-		Command cmd{CommandType::MEMCPYDEST, sizeof(dest), (u32)pushbuf.size()};
-		pushbuf.resize(pushbuf.size() + sizeof(dest));
-		memcpy(pushbuf.data() + cmd.ptr, &dest, sizeof(dest));
+		Command cmd{CommandType::MEMCPYDEST, sizeof(dest), PushData(&dest, sizeof(dest))};
+		commands.push_back(cmd);
 
 		sz = Memory::ValidSize(dest, sz);
 		if (sz != 0) {
@@ -501,9 +667,8 @@ void NotifyMemset(u32 dest, int v, u32 sz) {
 		MemsetCommand data{dest, v, sz};
 
 		FlushRegisters();
-		Command cmd{CommandType::MEMSET, sizeof(data), (u32)pushbuf.size()};
-		pushbuf.resize(pushbuf.size() + sizeof(data));
-		memcpy(pushbuf.data() + cmd.ptr, &data, sizeof(data));
+		Command cmd{CommandType::MEMSET, sizeof(data), PushData(&data, sizeof(data))};
+		commands.push_back(cmd);
 	}
 }
 
@@ -535,16 +700,12 @@ void NotifyDisplay(u32 framebuf, int stride, int fmt) {
 	DisplayBufData disp{ { framebuf }, stride, fmt };
 
 	FlushRegisters();
-	u32 ptr = (u32)pushbuf.size();
 	u32 sz = (u32)sizeof(disp);
-	pushbuf.resize(pushbuf.size() + sz);
-	memcpy(pushbuf.data() + ptr, &disp, sz);
-
-	commands.push_back({ CommandType::DISPLAY, sz, ptr });
+	commands.push_back({ CommandType::DISPLAY, sz, PushData(&disp, sz) });
 
 	if (writePending) {
-		NOTICE_LOG(SYSTEM, "Recording complete on display");
-		FinishRecording();
+		NOTICE_LOG(SYSTEM, "Recording frame complete on display");
+		EndFrame();
 	}
 }
 
@@ -552,7 +713,7 @@ void NotifyFrame() {
 	const bool noDisplayAction = flipLastAction + 4 < gpuStats.numFlips;
 	// We do this only to catch things that don't call NotifyDisplay.
 	if (active && !commands.empty() && noDisplayAction) {
-		NOTICE_LOG(SYSTEM, "Recording complete on frame");
+		NOTICE_LOG(SYSTEM, "Recording frame complete on frame");
 
 		struct DisplayBufData {
 			PSPPointer<u8> topaddr;
@@ -563,14 +724,10 @@ void NotifyFrame() {
 		__DisplayGetFramebuf(&disp.topaddr, &disp.linesize, &disp.pixelFormat, 0);
 
 		FlushRegisters();
-		u32 ptr = (u32)pushbuf.size();
 		u32 sz = (u32)sizeof(disp);
-		pushbuf.resize(pushbuf.size() + sz);
-		memcpy(pushbuf.data() + ptr, &disp, sz);
+		commands.push_back({ CommandType::DISPLAY, sz, PushData(&disp, sz) });
 
-		commands.push_back({ CommandType::DISPLAY, sz, ptr });
-
-		FinishRecording();
+		EndFrame();
 	}
 	if (nextFrame && (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) == 0 && noDisplayAction) {
 		NOTICE_LOG(SYSTEM, "Recording starting on frame...");
@@ -26,8 +26,14 @@ namespace GPURecord {
 bool IsActive();
 bool IsActivePending();
 bool Activate();
+// Records this many frames (0 for until Deactivate()), writing them out as it goes.  Fails if negative.
+bool ActivateFrames(int frames);
+// Stops a recording at the end of the current frame.
+void Deactivate();
 // Call only if Activate() returns true.
 void SetCallback(const std::function<void(const std::string &)> callback);
+// Finishes any recording in progress and stops the write thread.  Called on GPU shutdown.
+void Shutdown();
 
 void NotifyCommand(u32 pc);
 void NotifyMemcpy(u32 dest, u32 src, u32 sz);
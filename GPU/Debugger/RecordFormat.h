@@ -33,7 +33,9 @@ static const char *HEADER_MAGIC = "PPSSPPGE";
 // Version 2: Uses snappy
 // Version 3: Adds FRAMEBUF0-FRAMEBUF9
 // Version 4: Expanded header with game ID
-static const int VERSION = 4;
+// Version 5: Multiple frames, each with its own commands and data, until EOF.
+//            Pointers are relative to all data so far, so frames can reuse earlier data.
+static const int VERSION = 5;
 static const int MIN_VERSION = 2;
 
 enum class CommandType : u8 {
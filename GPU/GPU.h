@@ -76,6 +76,9 @@ struct GPUStatistics {
 		numUploads = 0;
 		numClears = 0;
 		msProcessingDisplayLists = 0;
+		msDecodingVertices = 0;
+		msDecodingTextures = 0;
+		msRasterizing = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
 		memset(gpuCommandsAtCallLevel, 0, sizeof(gpuCommandsAtCallLevel));
@@ -101,6 +104,11 @@ struct GPUStatistics {
 	int numUploads;
 	int numClears;
 	double msProcessingDisplayLists;
+	// These are only collected with debug stats, mainly for benchmarking.
+	double msDecodingVertices;
+	double msDecodingTextures;
+	// Software only: transform, clipping and drawing after vertex decode.
+	double msRasterizing;
 	int vertexGPUCycles;
 	int otherGPUCycles;
 	int gpuCommandsAtCallLevel[4];
@@ -1085,6 +1085,7 @@ void GPUCommon::BeginFrame() {
 		dumpThisFrame_ = false;
 	}
 	GPURecord::NotifyFrame();
+	GPUDebug::NotifyBeginFrame();
 }
 
 void GPUCommon::SlowRunLoop(DisplayList &list)
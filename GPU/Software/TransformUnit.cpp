@@ -20,7 +20,9 @@
 
 #include "Common/Math/math_util.h"
 #include "Common/MemoryUtil.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -318,7 +320,11 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 	if (indices)
 		GetIndexBounds(indices, vertex_count, vertex_type, &index_lower_bound, &index_upper_bound);
+	const double decodeStart = coreCollectDebugStats ? time_now_d() : 0.0;
 	vdecoder.DecodeVerts(buf, vertices, index_lower_bound, index_upper_bound);
+	const double rasterStart = decodeStart != 0.0 ? time_now_d() : 0.0;
+	if (rasterStart != 0.0)
+		gpuStats.msDecodingVertices += rasterStart - decodeStart;
 
 	VertexReader vreader(buf, vtxfmt, vertex_type);
 
@@ -555,6 +561,9 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 		break;
 	}
 
+	if (rasterStart != 0.0)
+		gpuStats.msRasterizing += time_now_d() - rasterStart;
+
 	GPUDebug::NotifyDraw();
 }
 
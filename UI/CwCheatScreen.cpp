@@ -26,7 +26,7 @@
 #include "Core/Core.h"
 #include "Core/Config.h"
 #include "Core/CwCheat.h"
-#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/MIPS/MIPS.h"
 
 #include "UI/GameInfoCache.h"
 #include "UI/CwCheatScreen.h"
@@ -136,8 +136,8 @@ void CwCheatScreen::onFinish(DialogResult result) {
 	if (result != DR_BACK) // This only works for BACK here.
 		return;
 
-	if (MIPSComp::jit) {
-		MIPSComp::jit->ClearCache();
+	if (currentMIPS) {
+		currentMIPS->ClearJitCache();
 	}
 	g_Config.fCwCheatScrollPosition = rightScroll_->GetScrollPosition();
 }
@@ -168,8 +168,8 @@ UI::EventReturn CwCheatScreen::OnAddCheat(UI::EventParams &params) {
 
 UI::EventReturn CwCheatScreen::OnEditCheatFile(UI::EventParams &params) {
 	g_Config.bReloadCheats = true;
-	if (MIPSComp::jit) {
-		MIPSComp::jit->ClearCache();
+	if (currentMIPS) {
+		currentMIPS->ClearJitCache();
 	}
 	if (engine_) {
 #if PPSSPP_PLATFORM(UWP)
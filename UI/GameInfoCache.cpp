@@ -21,11 +21,19 @@
 #include <map>
 #include <memory>
 #include <algorithm>
+#include <limits>
+#include <cstring>
 
+#include "ext/xxhash.h"
+
+#include "Common/CPUDetect.h"
 #include "Common/GPU/thin3d.h"
 #include "Common/Thread/PrioritizedWorkQueue.h"
 #include "Common/File/VFS/VFS.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/FileSystems/ISOFileSystem.h"
@@ -195,20 +203,16 @@ u64 GameInfo::GetInstallDataSizeInBytes() {
 	return totalSize;
 }
 
-bool GameInfo::LoadFromPath(const std::string &gamePath) {
+void GameInfo::SetFilePath(const std::string &gamePath) {
 	std::lock_guard<std::mutex> guard(lock);
-	// No need to rebuild if we already have it loaded.
+	// The file loader is only created when needed, which it may not be with the disk cache.
 	if (filePath_ != gamePath) {
-		fileLoader.reset(ConstructFileLoader(gamePath));
-		if (!fileLoader)
-			return false;
+		fileLoader.reset();
 		filePath_ = gamePath;
 
 		// This is a fallback title, while we're loading / if unable to load.
 		title = File::GetFilename(filePath_);
 	}
-
-	return true;
 }
 
 std::shared_ptr<FileLoader> GameInfo::GetFileLoader() {
@@ -316,8 +320,14 @@ static bool ReadFileToString(IFileSystem *fs, const char *filename, std::string
 }
 
 static bool ReadVFSToString(const char *filename, std::string *contents, std::mutex *mtx) {
+	// Several work items may run at once, and zip backed assets can't be read in parallel.
+	static std::mutex vfsLock;
 	size_t sz;
-	uint8_t *data = VFSReadFile(filename, &sz);
+	uint8_t *data;
+	{
+		std::lock_guard<std::mutex> guard(vfsLock);
+		data = VFSReadFile(filename, &sz);
+	}
 	if (data) {
 		if (mtx) {
 			std::lock_guard<std::mutex> lock(*mtx);
@@ -330,6 +340,149 @@ static bool ReadVFSToString(const char *filename, std::string *contents, std::mu
 	return data != nullptr;
 }
 
+// Info for ISOs and PBPs is also kept on disk, so the game list fills in right away next time.
+// Entries are only used if the path, size, and modification time still match.
+struct GameInfoDiskCacheEntry {
+	std::string path;
+	u64 size = 0;
+	u64 mtime = 0;
+	int fileType = 0;
+	std::string title;
+	std::string id;
+	std::string idVersion;
+	int discTotal = 0;
+	int discNumber = 0;
+	int region = -1;
+	// Empty if there wasn't one.
+	std::string paramSFO;
+	// Empty if the game had none, in which case a screenshot may be used instead.
+	std::string icon;
+
+	void DoState(PointerWrap &p) {
+		auto s = p.Section("GameInfoDiskCacheEntry", 1);
+		if (!s)
+			return;
+
+		Do(p, path);
+		Do(p, size);
+		Do(p, mtime);
+		Do(p, fileType);
+		Do(p, title);
+		Do(p, id);
+		Do(p, idVersion);
+		Do(p, discTotal);
+		Do(p, discNumber);
+		Do(p, region);
+		Do(p, paramSFO);
+		Do(p, icon);
+	}
+};
+
+struct GameInfoDiskCacheHeader {
+	u32 magic;
+	u32 size;
+	u32 hash;
+};
+
+static const u32 GAMEINFO_DISK_CACHE_MAGIC = 0x49475050;  // PPGI
+
+static std::string GameInfoDiskCachePath(const std::string &gamePath) {
+	u64 hash = XXH64(gamePath.data(), gamePath.size(), 0);
+	return GetSysDirectory(DIRECTORY_APP_CACHE) + "/gameinfo/" + StringFromFormat("%016llx.ppgi", (unsigned long long)hash);
+}
+
+// For a PBP directory, the EBOOT.PBP inside is what might change.
+static bool GetGameInfoDiskCacheKey(const std::string &gamePath, u64 *size, u64 *mtime) {
+	if (startsWith(gamePath, "http://") || startsWith(gamePath, "https://"))
+		return false;
+
+	std::string statPath = File::IsDirectory(gamePath) ? ResolvePBPFile(gamePath) : gamePath;
+	File::FileDetails details;
+	if (!File::GetFileDetails(statPath, &details) || details.isDirectory)
+		return false;
+	*size = details.size;
+	*mtime = details.mtime;
+	return true;
+}
+
+static bool ReadGameInfoDiskCacheFile(const std::string &cachePath, GameInfoDiskCacheEntry *entry) {
+	std::string data;
+	if (!readFileToString(false, cachePath.c_str(), data) || data.size() < sizeof(GameInfoDiskCacheHeader))
+		return false;
+
+	// The header makes sure we don't read a truncated or corrupt entry.
+	GameInfoDiskCacheHeader header;
+	memcpy(&header, data.data(), sizeof(header));
+	u8 *payload = (u8 *)&data[sizeof(header)];
+	if (header.magic != GAMEINFO_DISK_CACHE_MAGIC || header.size != data.size() - sizeof(header) || header.hash != XXH32(payload, header.size, 0))
+		return false;
+
+	std::string errorString;
+	return CChunkFileReader::LoadPtr(payload, *entry, &errorString) == CChunkFileReader::ERROR_NONE;
+}
+
+static bool ReadGameInfoDiskCache(const std::string &gamePath, GameInfoDiskCacheEntry *entry) {
+	u64 size, mtime;
+	if (!GetGameInfoDiskCacheKey(gamePath, &size, &mtime))
+		return false;
+	if (!ReadGameInfoDiskCacheFile(GameInfoDiskCachePath(gamePath), entry))
+		return false;
+	return entry->path == gamePath && entry->size == size && entry->mtime == mtime;
+}
+
+static void WriteGameInfoDiskCache(const std::string &gamePath, GameInfoDiskCacheEntry &entry) {
+	entry.path = gamePath;
+	if (!GetGameInfoDiskCacheKey(gamePath, &entry.size, &entry.mtime))
+		return;
+
+	GameInfoDiskCacheHeader header;
+	header.magic = GAMEINFO_DISK_CACHE_MAGIC;
+	header.size = (u32)CChunkFileReader::MeasurePtr(entry);
+	std::string data(sizeof(header) + header.size, '\0');
+	u8 *payload = (u8 *)&data[sizeof(header)];
+	if (CChunkFileReader::SavePtr(payload, entry) != CChunkFileReader::ERROR_NONE)
+		return;
+	header.hash = XXH32(payload, header.size, 0);
+	memcpy(&data[0], &header, sizeof(header));
+
+	// Write it out fully before replacing the old one.
+	const std::string path = GameInfoDiskCachePath(gamePath);
+	const std::string tempPath = path + ".tmp";
+	File::CreateFullPath(File::GetDir(path));
+	if (writeStringToFile(false, data, tempPath.c_str())) {
+		if (File::Exists(path))
+			File::Delete(path);
+		File::Rename(tempPath, path);
+	}
+}
+
+// Drops entries for games that were removed or changed, along with anything unreadable.
+class GameInfoDiskCachePruneItem : public PrioritizedWorkQueueItem {
+public:
+	void run() override {
+		std::vector<FileInfo> files;
+		getFilesInDir((GetSysDirectory(DIRECTORY_APP_CACHE) + "/gameinfo").c_str(), &files, "ppgi:tmp");
+		for (const FileInfo &file : files) {
+			GameInfoDiskCacheEntry entry;
+			u64 size, mtime;
+			if (file.isDirectory)
+				continue;
+			if (endsWith(file.name, ".ppgi") && ReadGameInfoDiskCacheFile(file.fullName, &entry)) {
+				// Could be a different path with the same hash, only remove it if it's ours.
+				if (GameInfoDiskCachePath(entry.path) != file.fullName)
+					continue;
+				if (GetGameInfoDiskCacheKey(entry.path, &size, &mtime) && entry.size == size && entry.mtime == mtime)
+					continue;
+			}
+			File::Delete(file.fullName);
+		}
+	}
+
+	float priority() override {
+		// Anything else in the queue goes first.
+		return std::numeric_limits<float>::max();
+	}
+};
 
 class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 public:
@@ -338,16 +491,26 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 	}
 
 	~GameInfoWorkItem() override {
+		std::lock_guard<std::mutex> guard(info_->loadLock);
 		info_->DisposeFileLoader();
 	}
 
 	void run() override {
-		if (!info_->LoadFromPath(gamePath_)) {
-			info_->pending = false;
-			return;
+		std::lock_guard<std::mutex> guard(info_->loadLock);
+		info_->SetFilePath(gamePath_);
+
+		// The disk cache only has what the game list needs, and doesn't need the file opened.
+		if ((info_->wantFlags & (GAMEINFO_WANTBG | GAMEINFO_WANTSND)) == 0) {
+			info_->working = true;
+			if (LoadFromDiskCache()) {
+				FinishLoading();
+				return;
+			}
+			info_->working = false;
 		}
+
 		// In case of a remote file, check if it actually exists before locking.
-		if (!info_->GetFileLoader()->Exists()) {
+		if (!info_->GetFileLoader() || !info_->GetFileLoader()->Exists()) {
 			info_->pending = false;
 			return;
 		}
@@ -398,19 +561,12 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 				if (pbp.GetSubFileSize(PBP_ICON0_PNG) > 0) {
 					std::lock_guard<std::mutex> lock(info_->lock);
 					pbp.GetSubFileAsString(PBP_ICON0_PNG, &info_->icon.data);
+					iconForCache_ = info_->icon.data;
 				} else {
-					std::string screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.jpg";
-					std::string screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.png";
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						readFileToString(false, screenshot_png.c_str(), info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						readFileToString(false, screenshot_jpg.c_str(), info_->icon.data);
-					else
-						// Read standard icon
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
+					ReadFallbackIcon();
 				}
 				info_->icon.dataLoaded = true;
+				cacheable_ = true;
 
 				if (info_->wantFlags & GAMEINFO_WANTBG) {
 					if (pbp.GetSubFileSize(PBP_PIC0_PNG) > 0) {
@@ -573,20 +729,13 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 				}
 
 				// Fall back to unknown icon if ISO is broken/is a homebrew ISO, override is allowed though
-				if (!ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
-					std::string screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.jpg";
-					std::string screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.png";
-					// Try using png/jpg screenshots first
-					if (File::Exists(screenshot_png))
-						readFileToString(false, screenshot_png.c_str(), info_->icon.data);
-					else if (File::Exists(screenshot_jpg))
-						readFileToString(false, screenshot_jpg.c_str(), info_->icon.data);
-					else {
-						DEBUG_LOG(LOADER, "Loading unknown.png because no icon was found");
-						ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
-					}
+				if (ReadFileToString(&umd, "/PSP_GAME/ICON0.PNG", &info_->icon.data, &info_->lock)) {
+					iconForCache_ = info_->icon.data;
+				} else {
+					ReadFallbackIcon();
 				}
 				info_->icon.dataLoaded = true;
+				cacheable_ = true;
 				break;
 			}
 
@@ -620,6 +769,90 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 				break;
 		}
 
+		if (cacheable_) {
+			SaveToDiskCache();
+		}
+		FinishLoading();
+	}
+
+	float priority() override {
+		// Another work item for the same game may be running, so don't touch its file loader here.
+		if (startsWith(gamePath_, "http://") || startsWith(gamePath_, "https://")) {
+			// Increase the value so remote info loads after non-remote.
+			return info_->lastAccessedTime + 1000.0f;
+		}
+		return info_->lastAccessedTime;
+	}
+
+private:
+	void ReadFallbackIcon() {
+		std::string screenshot_jpg = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.jpg";
+		std::string screenshot_png = GetSysDirectory(DIRECTORY_SCREENSHOT) + info_->id + "_00000.png";
+		// Try using png/jpg screenshots first
+		if (File::Exists(screenshot_png))
+			readFileToString(false, screenshot_png.c_str(), info_->icon.data);
+		else if (File::Exists(screenshot_jpg))
+			readFileToString(false, screenshot_jpg.c_str(), info_->icon.data);
+		else {
+			DEBUG_LOG(LOADER, "Loading unknown.png because no icon was found");
+			ReadVFSToString("unknown.png", &info_->icon.data, &info_->lock);
+		}
+	}
+
+	bool LoadFromDiskCache() {
+		GameInfoDiskCacheEntry entry;
+		if (!ReadGameInfoDiskCache(gamePath_, &entry))
+			return false;
+
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->fileType = (IdentifiedFileType)entry.fileType;
+			if (!entry.paramSFO.empty()) {
+				info_->paramSFO.ReadSFO((const u8 *)entry.paramSFO.data(), entry.paramSFO.size());
+				info_->paramSFOLoaded = true;
+			}
+			info_->id = entry.id;
+			info_->id_version = entry.idVersion;
+			info_->disc_total = entry.discTotal;
+			info_->disc_number = entry.discNumber;
+			info_->region = entry.region;
+		}
+		info_->SetTitle(entry.title);
+
+		if (!entry.icon.empty()) {
+			std::lock_guard<std::mutex> lock(info_->lock);
+			info_->icon.data = std::move(entry.icon);
+		} else {
+			ReadFallbackIcon();
+		}
+		info_->icon.dataLoaded = true;
+		return true;
+	}
+
+	void SaveToDiskCache() {
+		GameInfoDiskCacheEntry entry;
+		entry.title = info_->GetTitle();
+		{
+			std::lock_guard<std::mutex> lock(info_->lock);
+			entry.fileType = (int)info_->fileType;
+			entry.id = info_->id;
+			entry.idVersion = info_->id_version;
+			entry.discTotal = info_->disc_total;
+			entry.discNumber = info_->disc_number;
+			entry.region = info_->region;
+			if (info_->paramSFOLoaded) {
+				u8 *sfoData = nullptr;
+				size_t sfoSize = 0;
+				if (info_->paramSFO.WriteSFO(&sfoData, &sfoSize))
+					entry.paramSFO.assign((const char *)sfoData, sfoSize);
+				delete [] sfoData;
+			}
+		}
+		entry.icon = std::move(iconForCache_);
+		WriteGameInfoDiskCache(gamePath_, entry);
+	}
+
+	void FinishLoading() {
 		info_->hasConfig = g_Config.hasGameConfig(info_->id);
 
 		if (info_->wantFlags & GAMEINFO_WANTSIZE) {
@@ -634,18 +867,12 @@ class GameInfoWorkItem : public PrioritizedWorkQueueItem {
 		// INFO_LOG(SYSTEM, "Completed writing info for %s", info_->GetTitle().c_str());
 	}
 
-	float priority() override {
-		auto fl = info_->GetFileLoader();
-		if (fl && fl->IsRemote()) {
-			// Increase the value so remote info loads after non-remote.
-			return info_->lastAccessedTime + 1000.0f;
-		}
-		return info_->lastAccessedTime;
-	}
-
-private:
 	std::string gamePath_;
 	std::shared_ptr<GameInfo> info_;
+	// Set for types kept in the disk cache, once fully loaded.
+	bool cacheable_ = false;
+	// ICON0 from the game itself, since info_->icon.data may be cleared once it's a texture.
+	std::string iconForCache_;
 	DISALLOW_COPY_AND_ASSIGN(GameInfoWorkItem);
 };
 
@@ -660,7 +887,9 @@ GameInfoCache::~GameInfoCache() {
 
 void GameInfoCache::Init() {
 	gameInfoWQ_ = new PrioritizedWorkQueue();
-	ProcessWorkQueueOnThreadWhile(gameInfoWQ_);
+	// Mostly waiting on I/O, but too many at once would just thrash the disk.
+	ProcessWorkQueueOnThreadWhile(gameInfoWQ_, std::max(1, std::min(4, cpu_info.num_cores)));
+	gameInfoWQ_->Add(new GameInfoDiskCachePruneItem());
 }
 
 void GameInfoCache::Shutdown() {
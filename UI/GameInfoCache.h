@@ -84,7 +84,7 @@ class GameInfo {
 
 	bool Delete();  // Better be sure what you're doing when calling this.
 	bool DeleteAllSaveData();
-	bool LoadFromPath(const std::string &gamePath);
+	void SetFilePath(const std::string &gamePath);
 
 	std::shared_ptr<FileLoader> GetFileLoader();
 	void DisposeFileLoader();
@@ -105,6 +105,8 @@ class GameInfo {
 	// and obviously also not when creating it and holding the only pointer
 	// to it.
 	std::mutex lock;
+	// Held by the work item loading this, since work items for different games run in parallel.
+	std::mutex loadLock;
 
 	std::string id;
 	std::string id_version;
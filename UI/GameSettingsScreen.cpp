@@ -1671,8 +1671,11 @@ void DeveloperToolsScreen::CreateViews() {
 #if !defined(MOBILE_DEVICE)
 	Choice *createTextureIni = list->Add(new Choice(dev->T("Create/Open textures.ini file for current game")));
 	createTextureIni->OnClick.Handle(this, &DeveloperToolsScreen::OnOpenTexturesIniFile);
+	Choice *createTexturePack = list->Add(new Choice(dev->T("Build texture pack for current game")));
+	createTexturePack->OnClick.Handle(this, &DeveloperToolsScreen::OnBuildTexturePack);
 	if (!PSP_IsInited()) {
 		createTextureIni->SetEnabled(false);
+		createTexturePack->SetEnabled(false);
 	}
 #endif
 }
@@ -1737,6 +1740,19 @@ UI::EventReturn DeveloperToolsScreen::OnOpenTexturesIniFile(UI::EventParams &e)
 	return UI::EVENT_DONE;
 }
 
+UI::EventReturn DeveloperToolsScreen::OnBuildTexturePack(UI::EventParams &e) {
+	auto dev = GetI18NCategory("Developer");
+	std::string gameID = g_paramSFO.GetDiscID();
+	std::string generatedFilename;
+	if (TextureReplacer::GeneratePack(gameID, &generatedFilename)) {
+		// The new pack is used the next time the game starts.
+		host->NotifyUserMessage(dev->T("Texture pack built, restart the game to use it"), 3.0f);
+	} else {
+		host->NotifyUserMessage(dev->T("Failed to build texture pack"), 3.0f);
+	}
+	return UI::EVENT_DONE;
+}
+
 UI::EventReturn DeveloperToolsScreen::OnLogConfig(UI::EventParams &e) {
 	screenManager()->push(new LogConfigScreen());
 	return UI::EVENT_DONE;
@@ -177,10 +177,8 @@ void HandleCommonMessages(const char *message, const char *value, ScreenManager
 	bool isActiveScreen = manager->topScreen() == activeScreen;
 
 	if (!strcmp(message, "clear jit")) {
-		if (MIPSComp::jit && PSP_IsInited()) {
-			MIPSComp::jit->ClearCache();
-		}
 		if (PSP_IsInited()) {
+			currentMIPS->ClearJitCache();
 			currentMIPS->UpdateCore((CPUCore)g_Config.iCpuCore);
 		}
 	} else if (!strcmp(message, "control mapping") && isActiveScreen && activeScreen->tag() != "control mapping") {
@@ -6,6 +6,7 @@
 #include "Core/Config.h"
 #include "Windows/resource.h"
 #include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
 #include "Windows/W32Util/Misc.h"
 #include "Windows/InputBox.h"
 #include "Windows/main.h"
@@ -390,6 +391,7 @@ void CtrlMemView::onChar(WPARAM wParam, LPARAM lParam)
 	{
 		u8 newValue = wParam;
 		Memory::WriteUnchecked_U8(newValue,curAddress);
+		currentMIPS->InvalidateICache(curAddress & ~3, 4);
 		scrollCursor(1);
 	} else {
 		wParam = tolower(wParam);
@@ -406,6 +408,7 @@ void CtrlMemView::onChar(WPARAM wParam, LPARAM lParam)
 			oldValue &= ~(0xF << shiftAmount);
 			u8 newValue = oldValue | (inputValue << shiftAmount);
 			Memory::WriteUnchecked_U8(newValue,curAddress);
+			currentMIPS->InvalidateICache(curAddress & ~3, 4);
 			scrollCursor(1);
 		}
 	}
@@ -3,9 +3,11 @@
 // To build on non-windows systems, just run CMake in the SDL directory, it will build both a normal ppsspp and the headless version.
 
 #include "ppsspp_config.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
+#include <map>
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
 #endif
@@ -16,8 +18,10 @@
 
 #include "Common/File/VFS/VFS.h"
 #include "Common/File/VFS/AssetReader.h"
+#include "Common/File/DirListing.h"
 #include "Common/File/FileUtil.h"
 #include "Common/GraphicsContext.h"
+#include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
@@ -25,10 +29,12 @@
 #include "Core/CoreTiming.h"
 #include "Core/System.h"
 #include "Core/WebServer.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/GPU.h"
 #include "Log.h"
 #include "LogManager.h"
 
@@ -123,6 +129,12 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
+	fprintf(stderr, "  --bench=COUNT         run each file COUNT times and print timings\n");
+	fprintf(stderr, "                        (directories are expanded to the .ppdmp files inside)\n");
+	fprintf(stderr, "  --baseline=FILE       fail if slower than the timings in FILE\n");
+	fprintf(stderr, "  --save-baseline=FILE  write timings to FILE\n");
+	fprintf(stderr, "  --threshold=PERCENT   how much slower than baseline is ok (default 10)\n");
+	fprintf(stderr, "  --syscall-profile     print the syscalls that took the most host time\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
@@ -142,7 +154,29 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 	}
 }
 
-bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout)
+// All in seconds, like gpuStats.
+struct BenchTimes {
+	double total = 0.0;
+	double lists = 0.0;
+	double verts = 0.0;
+	double textures = 0.0;
+	double raster = 0.0;
+};
+
+// Goes to stderr, so it doesn't interfere with comparing output.
+static void PrintSyscallProfile() {
+	static const int MAX_SYSCALLS = 30;
+
+	std::vector<HLESyscallProfile> profile = hleGetSyscallProfile();
+	fprintf(stderr, "Syscall profile for %s:\n", currentTestName.c_str());
+	fprintf(stderr, "%10s %10s %10s  %s\n", "ms", "calls", "us/call", "function");
+	for (size_t i = 0; i < profile.size() && i < MAX_SYSCALLS; ++i) {
+		const HLESyscallProfile &entry = profile[i];
+		fprintf(stderr, "%10.3f %10llu %10.3f  %s::%s\n", entry.seconds * 1000.0, (unsigned long long)entry.calls, entry.seconds * 1000000.0 / entry.calls, entry.module, entry.func->name);
+	}
+}
+
+bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout, BenchTimes *bench = nullptr)
 {
 	// Kinda ugly, trying to guesstimate the test name from filename...
 	currentTestName = GetTestName(coreParameter.fileToStart);
@@ -173,8 +207,9 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	static double deadline;
 	deadline = time_now_d() + timeout;
 
-	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops);
+	Core_UpdateDebugStats(g_Config.bShowDebugStats || g_Config.bLogFrameDrops || bench != nullptr);
 
+	const double runStart = time_now_d();
 	PSP_BeginHostFrame();
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->BeginFrame();
@@ -209,6 +244,17 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->EndFrame();
 
+	if (bench) {
+		bench->total = time_now_d() - runStart;
+		bench->lists = gpuStats.msProcessingDisplayLists;
+		bench->verts = gpuStats.msDecodingVertices;
+		bench->textures = gpuStats.msDecodingTextures;
+		bench->raster = gpuStats.msRasterizing;
+	}
+
+	if (hleIsSyscallProfiling())
+		PrintSyscallProfile();
+
 	PSP_Shutdown();
 
 	headlessHost->FlushDebugOutput();
@@ -221,6 +267,77 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	return passed;
 }
 
+static std::map<std::string, double> LoadBenchBaseline(const char *filename) {
+	std::map<std::string, double> baseline;
+	FILE *fp = File::OpenCFile(filename, "rt");
+	if (!fp) {
+		fprintf(stderr, "Could not read baseline %s\n", filename);
+		return baseline;
+	}
+
+	char name[1024];
+	double ms;
+	while (fscanf(fp, "%1023s %lf", name, &ms) == 2)
+		baseline[name] = ms;
+	fclose(fp);
+	return baseline;
+}
+
+// Runs each file several times, keeping the fastest of each timing.  Returns false on regression.
+static bool RunBenchmarks(HeadlessHost *headlessHost, CoreParameter &coreParameter, const std::vector<std::string> &filenames, int count, double timeout, const char *baselineFilename, const char *saveFilename, double threshold) {
+	std::map<std::string, double> baseline;
+	if (baselineFilename)
+		baseline = LoadBenchBaseline(baselineFilename);
+
+	FILE *saveFile = nullptr;
+	if (saveFilename) {
+		saveFile = File::OpenCFile(saveFilename, "wt");
+		if (!saveFile)
+			fprintf(stderr, "Could not write baseline %s\n", saveFilename);
+	}
+
+	int regressions = 0;
+	for (const std::string &filename : filenames) {
+		coreParameter.fileToStart = filename;
+		const std::string name = GetFilenameFromPath(filename);
+
+		BenchTimes best;
+		bool failed = false;
+		for (int i = 0; i < count && !failed; ++i) {
+			BenchTimes times;
+			failed = !RunAutoTest(headlessHost, coreParameter, false, false, timeout, &times);
+			if (i == 0 || times.total < best.total) best.total = times.total;
+			if (i == 0 || times.lists < best.lists) best.lists = times.lists;
+			if (i == 0 || times.verts < best.verts) best.verts = times.verts;
+			if (i == 0 || times.textures < best.textures) best.textures = times.textures;
+			if (i == 0 || times.raster < best.raster) best.raster = times.raster;
+		}
+		if (failed) {
+			printf("%s: failed to run\n", name.c_str());
+			regressions++;
+			continue;
+		}
+
+		const double totalMs = best.total * 1000.0;
+		printf("%s: total %0.2f ms, lists %0.2f ms, vertex decode %0.2f ms, texture decode %0.2f ms, raster %0.2f ms\n", name.c_str(), totalMs, best.lists * 1000.0, best.verts * 1000.0, best.textures * 1000.0, best.raster * 1000.0);
+
+		auto it = baseline.find(name);
+		if (it != baseline.end() && totalMs > it->second * (1.0 + threshold / 100.0)) {
+			printf("  REGRESSED: %0.2f ms, baseline %0.2f ms (%+0.1f%%)\n", totalMs, it->second, (totalMs / it->second - 1.0) * 100.0);
+			GitHubActionsPrint("error", "Benchmark regression for %s: %0.2f ms, baseline %0.2f ms", name.c_str(), totalMs, it->second);
+			regressions++;
+		}
+
+		if (saveFile)
+			fprintf(saveFile, "%s %0.3f\n", name.c_str(), totalMs);
+	}
+
+	if (saveFile)
+		fclose(saveFile);
+	printf("%d benchmarks, %d failed or regressed.\n", (int)filenames.size(), regressions);
+	return regressions == 0;
+}
+
 int main(int argc, const char* argv[])
 {
 	PROFILE_INIT();
@@ -242,6 +359,10 @@ int main(int argc, const char* argv[])
 	const char *mountRoot = 0;
 	const char *screenshotFilename = 0;
 	float timeout = std::numeric_limits<float>::infinity();
+	int benchCount = 0;
+	const char *benchBaseline = nullptr;
+	const char *benchSaveBaseline = nullptr;
+	double benchThreshold = 10.0;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -299,6 +420,16 @@ int main(int argc, const char* argv[])
 			timeout = strtod(argv[i] + strlen("--timeout="), NULL);
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
 			debuggerPort = (int)strtoul(argv[i] + strlen("--debugger="), NULL, 10);
+		else if (!strncmp(argv[i], "--bench=", strlen("--bench=")) && strlen(argv[i]) > strlen("--bench="))
+			benchCount = std::max(1, atoi(argv[i] + strlen("--bench=")));
+		else if (!strncmp(argv[i], "--baseline=", strlen("--baseline=")) && strlen(argv[i]) > strlen("--baseline="))
+			benchBaseline = argv[i] + strlen("--baseline=");
+		else if (!strncmp(argv[i], "--save-baseline=", strlen("--save-baseline=")) && strlen(argv[i]) > strlen("--save-baseline="))
+			benchSaveBaseline = argv[i] + strlen("--save-baseline=");
+		else if (!strncmp(argv[i], "--threshold=", strlen("--threshold=")) && strlen(argv[i]) > strlen("--threshold="))
+			benchThreshold = strtod(argv[i] + strlen("--threshold="), NULL);
+		else if (!strcmp(argv[i], "--syscall-profile"))
+			hleSetSyscallProfiling(true);
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -320,6 +451,23 @@ int main(int argc, const char* argv[])
 			testFilenames.push_back(temp);
 	}
 
+	// Directories are expanded to the GE dumps in them, sorted so results are comparable.
+	std::vector<std::string> expandedFilenames;
+	for (const std::string &filename : testFilenames) {
+		if (File::IsDirectory(filename)) {
+			std::vector<FileInfo> dumps;
+			getFilesInDir(filename.c_str(), &dumps, "ppdmp");
+			std::vector<std::string> dumpFilenames;
+			for (const FileInfo &info : dumps)
+				dumpFilenames.push_back(info.fullName);
+			std::sort(dumpFilenames.begin(), dumpFilenames.end());
+			expandedFilenames.insert(expandedFilenames.end(), dumpFilenames.begin(), dumpFilenames.end());
+		} else {
+			expandedFilenames.push_back(filename);
+		}
+	}
+	testFilenames = expandedFilenames;
+
 	if (testFilenames.empty())
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
 
@@ -439,6 +587,12 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(stateToLoad, -1);
 
+	bool benchPassed = true;
+	if (benchCount > 0) {
+		benchPassed = RunBenchmarks(headlessHost, coreParameter, testFilenames, benchCount, timeout, benchBaseline, benchSaveBaseline, benchThreshold);
+		testFilenames.clear();
+	}
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
@@ -485,5 +639,5 @@ int main(int argc, const char* argv[])
 	LogManager::Shutdown();
 	delete printfLogger;
 
-	return 0;
+	return benchPassed ? 0 : 1;
 }
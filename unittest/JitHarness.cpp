@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <cstring>
 
 #include "ppsspp_config.h"
 
@@ -101,6 +102,99 @@ static void DestroyJitHarness() {
 	currentMIPS = nullptr;
 }
 
+static void RandomizeVFPU(u32 seed) {
+	// Mix in special values, since that's where sign and rounding differences show up.
+	static const u32 specials[8] = { 0x00000000, 0x80000000, 0x3F800000, 0xBF800000, 0x7F800000, 0xFF800000, 0x00000001, 0x7F7FFFFF };
+	for (int i = 0; i < 128; ++i) {
+		seed = seed * 1103515245 + 12345;
+		if ((seed >> 29) == 0) {
+			currentMIPS->vi[i] = specials[(seed >> 16) & 7];
+		} else {
+			currentMIPS->v[i] = (float)(int)((seed >> 8) & 0xFFFF) / 256.0f - 128.0f;
+		}
+	}
+	currentMIPS->vfpuCtrl[VFPU_CTRL_SPREFIX] = 0xE4;
+	currentMIPS->vfpuCtrl[VFPU_CTRL_TPREFIX] = 0xE4;
+	currentMIPS->vfpuCtrl[VFPU_CTRL_DPREFIX] = 0;
+}
+
+static bool RunVFPUCase(const char *line, CPUCore core, u32 seed, u32 result[128]) {
+	u32 addr = PSP_GetUserMemoryBase();
+	if (!MIPSAsm::MipsAssembleOpcode(line, currentDebugMIPS, addr)) {
+		printf("ERROR: %ls\n", MIPSAsm::GetAssembleError().c_str());
+		return false;
+	}
+	Memory::Write_U32(MIPS_MAKE_SYSCALL("UnitTestFakeSyscalls", "UnitTestTerminator"), addr + 4);
+	Memory::Write_U32(MIPS_MAKE_BREAK(1), addr + 8);
+
+	// Switching cores gives us a fresh jit each time.
+	mipsr4k.UpdateCore(core);
+	RandomizeVFPU(seed);
+	currentMIPS->pc = addr;
+	coreState = CORE_RUNNING;
+	while (coreState == CORE_RUNNING) {
+		mipsr4k.RunLoopUntil(1000000);
+	}
+	memcpy(result, currentMIPS->vi, sizeof(currentMIPS->vi));
+	mipsr4k.UpdateCore(CPUCore::INTERPRETER);
+	return true;
+}
+
+// The IR frontend should match the interpreter bit for bit, including -0.0, infinities, and NaNs.
+bool TestJitVFPU() {
+	SetupJitHarness();
+
+	static const char *lines[] = {
+		"vmmul.q M000, M100, M200",
+		"vmmul.q M000, E100, M200",
+		"vmmul.t M000, M100, M200",
+		"vmmul.t M000, E000, M100",
+		"vmmul.p M000, M100, M200",
+		"vtfm4.q C000, M100, C200",
+		"vtfm4.q C000, E100, C200",
+		"vtfm3.t C000, M100, C200",
+		"vtfm3.t C100, M100, C110",
+		"vhtfm4.q C000, M100, C200",
+		"vhtfm3.t C000, M100, C200",
+		"vcrs.t C000, C100, C200",
+		"vcrs.t C000, C000, C100",
+		"vdet.p S000, C100, C200",
+		"vcrsp.t C000, C100, C200",
+		"vqmul.q C000, C100, C200",
+		"vqmul.q C000, C000, C100",
+		"vmmov.q M000, E000",
+		"vmmov.t M100, E100",
+		"vmscl.q M000, E100, S200",
+		"vmscl.t M000, M100, S200",
+		"vmscl.t M000, E000, S001",
+		"vsocp.s C000, S100",
+		"vsocp.s C000, S000",
+		"vsocp.p C000, C100",
+		"vsocp.p C000, C000",
+	};
+
+	bool success = true;
+	u32 interp[128], ir[128];
+	for (size_t i = 0; i < ARRAY_SIZE(lines) && success; ++i) {
+		for (u32 seed = 1; seed <= 16 && success; ++seed) {
+			if (!RunVFPUCase(lines[i], CPUCore::INTERPRETER, seed, interp) || !RunVFPUCase(lines[i], CPUCore::IR_JIT, seed, ir)) {
+				success = false;
+				break;
+			}
+			for (int r = 0; r < 128; ++r) {
+				if (interp[r] != ir[r]) {
+					printf("%s (seed %d): v[%d] = %08x, expected %08x\n", lines[i], seed, r, ir[r], interp[r]);
+					success = false;
+					break;
+				}
+			}
+		}
+	}
+
+	DestroyJitHarness();
+	return success;
+}
+
 bool TestJit() {
 	SetupJitHarness();
 
@@ -0,0 +1,269 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/Util/BlockAllocator.h"
+#include "unittest/UnitTest.h"
+
+// The plain first fit list BlockAllocator used to be, to check the indexed one places blocks the same way.
+class ReferenceAllocator {
+public:
+	ReferenceAllocator(u32 grain) : grain_(grain) {
+	}
+
+	void Init(u32 rangeStart, u32 rangeSize) {
+		rangeSize_ = rangeSize;
+		blocks_.clear();
+		blocks_.push_back({ rangeStart, rangeSize, false });
+	}
+
+	u32 AllocAligned(u32 &size, u32 sizeGrain, u32 grain, bool fromTop) {
+		if (size == 0 || size > rangeSize_)
+			return -1;
+		if (grain < grain_)
+			grain = grain_;
+		if (sizeGrain < grain_)
+			sizeGrain = grain_;
+		size = (size + sizeGrain - 1) & ~(sizeGrain - 1);
+
+		if (!fromTop) {
+			for (size_t i = 0; i < blocks_.size(); ++i) {
+				u32 offset = blocks_[i].start % grain;
+				if (offset != 0)
+					offset = grain - offset;
+				u32 needed = offset + size;
+				if (!blocks_[i].taken && blocks_[i].size >= needed) {
+					if (blocks_[i].size != needed)
+						InsertFreeAfter(i, blocks_[i].size - needed);
+					if (offset >= grain_)
+						i = InsertFreeBefore(i, offset);
+					blocks_[i].taken = true;
+					return blocks_[i].start;
+				}
+			}
+		} else {
+			for (size_t i = blocks_.size(); i-- > 0; ) {
+				u32 offset = (blocks_[i].start + blocks_[i].size - size) % grain;
+				u32 needed = offset + size;
+				if (!blocks_[i].taken && blocks_[i].size >= needed) {
+					if (blocks_[i].size != needed)
+						i = InsertFreeBefore(i, blocks_[i].size - needed);
+					if (offset >= grain_)
+						InsertFreeAfter(i, offset);
+					blocks_[i].taken = true;
+					return blocks_[i].start;
+				}
+			}
+		}
+		return -1;
+	}
+
+	u32 AllocAt(u32 position, u32 size) {
+		if (size > rangeSize_)
+			return -1;
+
+		u32 alignedPosition = position & ~(grain_ - 1);
+		u32 alignedSize = size + position - alignedPosition;
+		alignedSize = (alignedSize + grain_ - 1) & ~(grain_ - 1);
+
+		size_t i = Find(alignedPosition);
+		if (i == blocks_.size() || blocks_[i].taken || blocks_[i].start + blocks_[i].size < alignedPosition + alignedSize)
+			return -1;
+		if (blocks_[i].start != alignedPosition)
+			i = InsertFreeBefore(i, alignedPosition - blocks_[i].start);
+		if (blocks_[i].size != alignedSize)
+			InsertFreeAfter(i, blocks_[i].size - alignedSize);
+		blocks_[i].taken = true;
+		return position;
+	}
+
+	bool Free(u32 position, bool exact) {
+		size_t i = Find(position);
+		if (i == blocks_.size() || !blocks_[i].taken || (exact && blocks_[i].start != position))
+			return false;
+
+		blocks_[i].taken = false;
+		if (i + 1 < blocks_.size() && !blocks_[i + 1].taken) {
+			blocks_[i].size += blocks_[i + 1].size;
+			blocks_.erase(blocks_.begin() + i + 1);
+		}
+		if (i > 0 && !blocks_[i - 1].taken) {
+			blocks_[i - 1].size += blocks_[i].size;
+			blocks_.erase(blocks_.begin() + i);
+		}
+		return true;
+	}
+
+	u32 GetBlockStartFromAddress(u32 addr) const {
+		size_t i = Find(addr);
+		return i == blocks_.size() ? -1 : blocks_[i].start;
+	}
+
+	u32 GetBlockSizeFromAddress(u32 addr) const {
+		size_t i = Find(addr);
+		return i == blocks_.size() ? -1 : blocks_[i].size;
+	}
+
+	u32 GetLargestFreeBlockSize() const {
+		u32 largest = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken && b.size > largest)
+				largest = b.size;
+		}
+		return largest;
+	}
+
+	u32 GetTotalFreeBytes() const {
+		u32 sum = 0;
+		for (const Block &b : blocks_) {
+			if (!b.taken)
+				sum += b.size;
+		}
+		return sum;
+	}
+
+private:
+	struct Block {
+		u32 start;
+		u32 size;
+		bool taken;
+	};
+
+	size_t Find(u32 addr) const {
+		for (size_t i = 0; i < blocks_.size(); ++i) {
+			if (blocks_[i].start <= addr && blocks_[i].start + blocks_[i].size > addr)
+				return i;
+		}
+		return blocks_.size();
+	}
+
+	// Returns the new index of block i.
+	size_t InsertFreeBefore(size_t i, u32 size) {
+		Block b{ blocks_[i].start, size, false };
+		blocks_[i].start += size;
+		blocks_[i].size -= size;
+		blocks_.insert(blocks_.begin() + i, b);
+		return i + 1;
+	}
+
+	void InsertFreeAfter(size_t i, u32 size) {
+		blocks_[i].size -= size;
+		Block b{ blocks_[i].start + blocks_[i].size, size, false };
+		blocks_.insert(blocks_.begin() + i + 1, b);
+	}
+
+	std::vector<Block> blocks_;
+	u32 rangeSize_ = 0;
+	u32 grain_;
+};
+
+static const u32 rangeStart = 0x08800000;
+static const u32 rangeSize = 0x00100000;
+
+static bool CompareAllocators(const BlockAllocator &alloc, const ReferenceAllocator &ref, u32 seed) {
+	EXPECT_EQ_HEX(alloc.GetLargestFreeBlockSize(), ref.GetLargestFreeBlockSize());
+	EXPECT_EQ_HEX(alloc.GetTotalFreeBytes(), ref.GetTotalFreeBytes());
+
+	// Check a spread of addresses, including just outside the range.
+	for (u32 addr = rangeStart - 0x100; addr < rangeStart + rangeSize + 0x100; addr += 0x100 + (seed & 0xF0)) {
+		EXPECT_EQ_HEX(alloc.GetBlockStartFromAddress(addr), ref.GetBlockStartFromAddress(addr));
+		EXPECT_EQ_HEX(alloc.GetBlockSizeFromAddress(addr), ref.GetBlockSizeFromAddress(addr));
+	}
+	return true;
+}
+
+static bool TestRandomOperations(u32 grain, u32 seed) {
+	BlockAllocator alloc(grain);
+	ReferenceAllocator ref(grain);
+	alloc.Init(rangeStart, rangeSize);
+	ref.Init(rangeStart, rangeSize);
+
+	std::vector<u32> live;
+	for (int i = 0; i < 20000; ++i) {
+		seed = seed * 1103515245 + 12345;
+		const u32 r = seed >> 8;
+		// Mostly small, sometimes large, so there are both many blocks and failures.
+		u32 size = (r & 0x1000) ? 1 + (r >> 4) % 0x20000 : 1 + (r >> 4) % 0x800;
+		const bool fromTop = (r & 0x20) != 0;
+
+		u32 result = -1, refResult = -1;
+		u32 refSize = size;
+		switch ((r >> 12) % 8) {
+		case 0:
+		case 1:
+			result = alloc.Alloc(size, fromTop, "test");
+			refResult = ref.AllocAligned(refSize, grain, grain, fromTop);
+			break;
+
+		case 2:
+			{
+				const u32 alignShift = 4 + (r >> 16) % 10;
+				const u32 sizeGrain = (r & 0x40) ? 1 << alignShift : grain;
+				result = alloc.AllocAligned(size, sizeGrain, 1 << alignShift, fromTop, "test");
+				refResult = ref.AllocAligned(refSize, sizeGrain, 1 << alignShift, fromTop);
+			}
+			break;
+
+		case 3:
+			{
+				const u32 position = rangeStart + (r >> 4) % rangeSize;
+				result = alloc.AllocAt(position, size, "test");
+				refResult = ref.AllocAt(position, refSize);
+			}
+			break;
+
+		default:
+			if (!live.empty()) {
+				const size_t index = (r >> 4) % live.size();
+				// Sometimes free from the middle of a block, or somewhere that isn't allocated.
+				u32 position = live[index];
+				if ((r & 0x300) == 0)
+					position += (r >> 10) & 0x3F;
+				else if ((r & 0x300) == 0x100)
+					position = rangeStart + (r >> 4) % rangeSize;
+				const bool exact = (r & 0x40) != 0;
+				const bool freed = exact ? alloc.FreeExact(position) : alloc.Free(position);
+				EXPECT_TRUE(freed == ref.Free(position, exact));
+				if (freed)
+					live.erase(live.begin() + index);
+			}
+			break;
+		}
+
+		EXPECT_EQ_HEX(result, refResult);
+		EXPECT_EQ_HEX(size, refSize);
+		if (result != (u32)-1) {
+			live.push_back(result);
+		}
+
+		if ((i & 0xFF) == 0 && !CompareAllocators(alloc, ref, seed)) {
+			printf("Mismatch after %d operations\n", i);
+			return false;
+		}
+	}
+
+	return CompareAllocators(alloc, ref, seed);
+}
+
+bool TestBlockAllocator() {
+	return TestRandomOperations(16, 1) &&
+		TestRandomOperations(16, 0x1234) &&
+		TestRandomOperations(0x100, 42);
+}
@@ -0,0 +1,251 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/Serialize/Serializer.h"
+#include "Common/TimeUtil.h"
+#include "Core/CoreTiming.h"
+#include "Core/MIPS/MIPS.h"
+#include "unittest/UnitTest.h"
+
+struct ReferenceEvent {
+	s64 time;
+	int type;
+	u64 userdata;
+};
+
+struct FiredEvent {
+	int type;
+	u64 userdata;
+	int cyclesLate;
+};
+
+static std::vector<FiredEvent> fired;
+static int eventTypes[3];
+
+static void RecordEvent0(u64 userdata, int cyclesLate) {
+	fired.push_back(FiredEvent{ eventTypes[0], userdata, cyclesLate });
+}
+
+static void RecordEvent1(u64 userdata, int cyclesLate) {
+	fired.push_back(FiredEvent{ eventTypes[1], userdata, cyclesLate });
+}
+
+static void RecordEvent2(u64 userdata, int cyclesLate) {
+	fired.push_back(FiredEvent{ eventTypes[2], userdata, cyclesLate });
+}
+
+static void SetupCoreTiming() {
+	currentMIPS = &mipsr4k;
+	CoreTiming::Init();
+	eventTypes[0] = CoreTiming::RegisterEvent("Test0", &RecordEvent0);
+	eventTypes[1] = CoreTiming::RegisterEvent("Test1", &RecordEvent1);
+	eventTypes[2] = CoreTiming::RegisterEvent("Test2", &RecordEvent2);
+}
+
+static void DestroyCoreTiming() {
+	CoreTiming::Shutdown();
+	currentMIPS = nullptr;
+}
+
+static void RunAllEvents() {
+	auto anyScheduled = [] {
+		for (int type : eventTypes) {
+			if (CoreTiming::IsScheduled(type))
+				return true;
+		}
+		return false;
+	};
+	while (anyScheduled() && fired.size() < 100000) {
+		CoreTiming::Idle();
+		CoreTiming::Advance();
+	}
+}
+
+static bool RoundTripState() {
+	const std::string before = CoreTiming::GetScheduledEventsSummary();
+
+	u8 *ptr = nullptr;
+	PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+	CoreTiming::DoState(measure);
+	std::vector<u8> buffer((size_t)(uintptr_t)ptr);
+
+	ptr = &buffer[0];
+	PointerWrap save(&ptr, PointerWrap::MODE_WRITE);
+	CoreTiming::DoState(save);
+
+	CoreTiming::ClearPendingEvents();
+	ptr = &buffer[0];
+	PointerWrap load(&ptr, PointerWrap::MODE_READ);
+	CoreTiming::DoState(load);
+	EXPECT_EQ_INT((int)load.error, (int)PointerWrap::ERROR_NONE);
+
+	if (CoreTiming::GetScheduledEventsSummary() != before) {
+		printf("Events changed after save and load:\n%s\nvs\n%s\n", before.c_str(), CoreTiming::GetScheduledEventsSummary().c_str());
+		return false;
+	}
+	return true;
+}
+
+static bool TestCoreTimingCorrectness() {
+	for (int round = 0; round < 20; ++round) {
+		SetupCoreTiming();
+		fired.clear();
+
+		// Schedule a bunch of events, with lots of ties and duplicates.
+		std::vector<ReferenceEvent> reference;
+		for (int i = 0; i < 300; ++i) {
+			int type = eventTypes[rand() % 3];
+			u64 userdata = (u64)(rand() % 20) << (rand() % 2 ? 32 : 0);
+			int action = rand() % 10;
+			if (action < 7) {
+				s64 cycles = (rand() % 50) * 1000;
+				CoreTiming::ScheduleEvent(cycles, type, userdata);
+				reference.push_back(ReferenceEvent{ cycles, type, userdata });
+			} else if (action < 9) {
+				// Unschedule reports the last matching event to run.
+				s64 expected = 0;
+				for (const ReferenceEvent &ev : reference) {
+					if (ev.type == type && ev.userdata == userdata)
+						expected = std::max(expected, ev.time);
+				}
+				EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(type, userdata), (int)expected);
+				reference.erase(std::remove_if(reference.begin(), reference.end(), [&](const ReferenceEvent &ev) {
+					return ev.type == type && ev.userdata == userdata;
+				}), reference.end());
+			} else {
+				CoreTiming::RemoveEvent(type);
+				reference.erase(std::remove_if(reference.begin(), reference.end(), [&](const ReferenceEvent &ev) {
+					return ev.type == type;
+				}), reference.end());
+			}
+			EXPECT_TRUE(CoreTiming::IsScheduled(type) == std::any_of(reference.begin(), reference.end(), [&](const ReferenceEvent &ev) {
+				return ev.type == type;
+			}));
+		}
+
+		if (round == 0)
+			RET(RoundTripState());
+
+		RunAllEvents();
+
+		std::stable_sort(reference.begin(), reference.end(), [](const ReferenceEvent &a, const ReferenceEvent &b) {
+			return a.time < b.time;
+		});
+		EXPECT_EQ_INT((int)fired.size(), (int)reference.size());
+		for (size_t i = 0; i < reference.size(); ++i) {
+			if (fired[i].type != reference[i].type || fired[i].userdata != reference[i].userdata || fired[i].cyclesLate < 0) {
+				printf("Event %d fired as type %d / %016llx (%d late), expected %d / %016llx\n", (int)i, fired[i].type, (unsigned long long)fired[i].userdata, fired[i].cyclesLate, reference[i].type, (unsigned long long)reference[i].userdata);
+				return false;
+			}
+		}
+
+		DestroyCoreTiming();
+	}
+	return true;
+}
+
+// Several threads posting at once, as the audio and IO threads do.
+static bool TestCoreTimingThreadsafe() {
+	static const int THREADS = 4;
+	static const int EVENTS_PER_THREAD = 2000;
+
+	SetupCoreTiming();
+	fired.clear();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < THREADS; ++t) {
+		threads.push_back(std::thread([t] {
+			for (int i = 0; i < EVENTS_PER_THREAD; ++i)
+				CoreTiming::ScheduleEvent_Threadsafe(1000, eventTypes[0], ((u64)t << 32) | i);
+		}));
+	}
+	// Keep taking events while they're being posted.
+	for (int i = 0; i < 100; ++i)
+		CoreTiming::MoveEvents();
+	for (std::thread &th : threads)
+		th.join();
+	CoreTiming::MoveEvents();
+	RunAllEvents();
+
+	// Each thread's events must all arrive, in the order that thread posted them.
+	EXPECT_EQ_INT((int)fired.size(), THREADS * EVENTS_PER_THREAD);
+	int next[THREADS]{};
+	for (const FiredEvent &ev : fired) {
+		const int t = (int)(ev.userdata >> 32);
+		EXPECT_TRUE(t >= 0 && t < THREADS);
+		EXPECT_EQ_INT((int)(u32)ev.userdata, next[t]);
+		next[t]++;
+	}
+	DestroyCoreTiming();
+	return true;
+}
+
+// More copies of one event than UnscheduleEvent() removes in one batch.
+static bool TestCoreTimingManyDuplicates() {
+	static const int COPIES = 50;
+
+	SetupCoreTiming();
+	for (int i = 0; i < COPIES; ++i)
+		CoreTiming::ScheduleEvent(((i * 37) % COPIES) * 1000, eventTypes[1], 7);
+	CoreTiming::ScheduleEvent(500, eventTypes[1], 8);
+
+	EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(eventTypes[1], 7), (COPIES - 1) * 1000);
+	EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(eventTypes[1], 7), 0);
+	EXPECT_EQ_INT((int)CoreTiming::UnscheduleEvent(eventTypes[1], 8), 500);
+	EXPECT_FALSE(CoreTiming::IsScheduled(eventTypes[1]));
+	DestroyCoreTiming();
+	return true;
+}
+
+// Roughly what a busy game does: a few dozen live events, constantly rescheduled.
+bool TestCoreTimingBenchmark() {
+	static const int LIVE_EVENTS = 64;
+	static const int ROUNDS = 1000;
+
+	SetupCoreTiming();
+	for (int i = 0; i < LIVE_EVENTS; ++i)
+		CoreTiming::ScheduleEvent(10000 + i * 997, eventTypes[i % 3], i);
+
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < ROUNDS; ++j) {
+			const int i = (total + j * 7) % LIVE_EVENTS;
+			CoreTiming::UnscheduleEvent(eventTypes[i % 3], i);
+			CoreTiming::ScheduleEvent(10000 + ((j * 7919) & 0xFFFF), eventTypes[i % 3], i);
+		}
+		total += ROUNDS;
+	} while (time_now_d() - st < 0.25);
+	double elapsed = time_now_d() - st;
+
+	printf("CoreTiming: %0.1f ns per unschedule + schedule with %d live events\n", elapsed * 1000000000.0 / total, LIVE_EVENTS);
+	CoreTiming::ClearPendingEvents();
+	DestroyCoreTiming();
+	return true;
+}
+
+bool TestCoreTiming() {
+	srand(2020);
+	return TestCoreTimingCorrectness() && TestCoreTimingManyDuplicates() && TestCoreTimingThreadsafe();
+}
@@ -0,0 +1,337 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !PPSSPP_PLATFORM(WINDOWS)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "Common/CommonTypes.h"
+#include "Common/Net/Resolve.h"
+#include "Common/TimeUtil.h"
+#include "Core/FileLoaders/CachingFileLoader.h"
+#include "Core/FileLoaders/HTTPFileLoader.h"
+#include "unittest/UnitTest.h"
+
+#if !PPSSPP_PLATFORM(WINDOWS)
+
+static const s64 TEST_FILE_SIZE = 3 * 1024 * 1024 + 123;
+
+static u8 TestFileByte(s64 pos) {
+	return (u8)((pos * 7) ^ (pos >> 9));
+}
+
+static bool CheckTestFileData(s64 pos, const u8 *data, size_t bytes) {
+	for (size_t i = 0; i < bytes; ++i) {
+		if (data[i] != TestFileByte(pos + i)) {
+			printf("Wrong data at %lld: %02x, expected %02x\n", (long long)(pos + i), data[i], TestFileByte(pos + i));
+			return false;
+		}
+	}
+	return true;
+}
+
+enum class RangeServerMode {
+	// Kept alive connections with Content-Length.
+	KEEP_ALIVE,
+	// Like KEEP_ALIVE, but drops connections that sit idle for a moment.
+	CLOSE_WHEN_IDLE,
+	// Kept alive connections with chunked ranges.
+	CHUNKED,
+	// Kept alive, but ranges have no length at all.
+	NO_LENGTH,
+};
+
+// A tiny HTTP server for TEST_FILE_SIZE bytes of TestFileByte(), just enough for HTTPFileLoader.
+class RangeServer {
+public:
+	~RangeServer() {
+		Stop();
+	}
+
+	bool Start(RangeServerMode mode) {
+		mode_ = mode;
+		listener_ = socket(AF_INET, SOCK_STREAM, 0);
+		if (listener_ < 0)
+			return false;
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		addr.sin_port = 0;
+		socklen_t addrLen = sizeof(addr);
+		if (bind(listener_, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener_, 16) < 0 || getsockname(listener_, (sockaddr *)&addr, &addrLen) < 0) {
+			close(listener_);
+			listener_ = -1;
+			return false;
+		}
+		port_ = ntohs(addr.sin_port);
+
+		stop_ = false;
+		acceptThread_ = std::thread([this] { AcceptThread(); });
+		return true;
+	}
+
+	void Stop() {
+		if (listener_ < 0)
+			return;
+		stop_ = true;
+		acceptThread_.join();
+		close(listener_);
+		listener_ = -1;
+
+		{
+			std::lock_guard<std::mutex> guard(lock_);
+			for (int fd : openSockets_)
+				shutdown(fd, SHUT_RDWR);
+		}
+		for (std::thread &th : connectionThreads_)
+			th.join();
+		connectionThreads_.clear();
+	}
+
+	std::string URL() const {
+		return "http://127.0.0.1:" + std::to_string(port_) + "/test.iso";
+	}
+
+	int Connections() const {
+		return connections_;
+	}
+
+private:
+	void AcceptThread() {
+		while (!stop_) {
+			pollfd pfd{ listener_, POLLIN, 0 };
+			if (poll(&pfd, 1, 50) <= 0)
+				continue;
+			int fd = accept(listener_, nullptr, nullptr);
+			if (fd < 0)
+				continue;
+			connections_++;
+			std::lock_guard<std::mutex> guard(lock_);
+			openSockets_.push_back(fd);
+			connectionThreads_.push_back(std::thread([this, fd] { ServeConnection(fd); }));
+		}
+	}
+
+	bool SendAll(int fd, const std::string &data) {
+		size_t pos = 0;
+		while (pos < data.size()) {
+			ssize_t sent = send(fd, data.data() + pos, data.size() - pos, MSG_NOSIGNAL);
+			if (sent <= 0)
+				return false;
+			pos += sent;
+		}
+		return true;
+	}
+
+	void ServeConnection(int fd) {
+		std::string received;
+		bool first = true;
+		while (!stop_) {
+			if (mode_ == RangeServerMode::CLOSE_WHEN_IDLE && !first && received.empty()) {
+				pollfd pfd{ fd, POLLIN, 0 };
+				if (poll(&pfd, 1, 50) <= 0)
+					break;
+			}
+			first = false;
+
+			size_t headerEnd;
+			while ((headerEnd = received.find("\r\n\r\n")) == received.npos) {
+				char buf[4096];
+				ssize_t got = recv(fd, buf, sizeof(buf), 0);
+				if (got <= 0)
+					goto done;
+				received.append(buf, got);
+			}
+			std::string request = received.substr(0, headerEnd);
+			received.erase(0, headerEnd + 4);
+
+			if (request.compare(0, 5, "HEAD ") == 0) {
+				std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(TEST_FILE_SIZE) + "\r\nAccept-Ranges: bytes\r\n\r\n";
+				if (!SendAll(fd, response))
+					break;
+				continue;
+			}
+
+			long long first = 0, last = 0;
+			size_t rangePos = request.find("Range: bytes=");
+			if (rangePos == request.npos || sscanf(request.c_str() + rangePos, "Range: bytes=%lld-%lld", &first, &last) != 2)
+				break;
+			std::string body;
+			for (long long i = first; i <= last; ++i)
+				body.push_back((char)TestFileByte(i));
+
+			std::string response = "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" + std::to_string(TEST_FILE_SIZE) + "\r\n";
+			if (mode_ == RangeServerMode::CHUNKED) {
+				response += "Transfer-Encoding: chunked\r\n\r\n";
+				for (size_t pos = 0; pos < body.size(); pos += 3000) {
+					size_t chunkSize = std::min(body.size() - pos, (size_t)3000);
+					char chunkHeader[32];
+					snprintf(chunkHeader, sizeof(chunkHeader), "%zx\r\n", chunkSize);
+					response += chunkHeader + body.substr(pos, chunkSize) + "\r\n";
+				}
+				response += "0\r\n\r\n";
+			} else if (mode_ == RangeServerMode::NO_LENGTH) {
+				response += "\r\n" + body;
+			} else {
+				response += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+			}
+			if (!SendAll(fd, response))
+				break;
+		}
+
+	done:
+		std::lock_guard<std::mutex> guard(lock_);
+		for (size_t i = 0; i < openSockets_.size(); ++i) {
+			if (openSockets_[i] == fd) {
+				openSockets_.erase(openSockets_.begin() + i);
+				break;
+			}
+		}
+		close(fd);
+	}
+
+	RangeServerMode mode_ = RangeServerMode::KEEP_ALIVE;
+	int listener_ = -1;
+	int port_ = 0;
+	std::atomic<bool> stop_{ false };
+	std::atomic<int> connections_{ 0 };
+	std::thread acceptThread_;
+	std::mutex lock_;
+	std::vector<int> openSockets_;
+	std::vector<std::thread> connectionThreads_;
+};
+
+// The HEAD request gets its own connection, plus up to four for ranges.
+static const int MAX_EXPECTED_CONNECTIONS = 5;
+
+static bool TestHTTPParallelReads() {
+	RangeServer server;
+	EXPECT_TRUE(server.Start(RangeServerMode::KEEP_ALIVE));
+
+	HTTPFileLoader loader(server.URL());
+	EXPECT_TRUE(loader.Exists());
+	EXPECT_TRUE(loader.FileSize() == TEST_FILE_SIZE);
+
+	std::atomic<bool> success{ true };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 8; ++t) {
+		threads.push_back(std::thread([&, t] {
+			u32 seed = 1234 + t;
+			std::vector<u8> data(200000);
+			for (int i = 0; i < 25 && success; ++i) {
+				seed = seed * 1103515245 + 12345;
+				s64 pos = (seed >> 8) % TEST_FILE_SIZE;
+				size_t bytes = 1 + (seed >> 4) % data.size();
+				size_t expected = (size_t)std::min((s64)bytes, TEST_FILE_SIZE - pos);
+				if (loader.ReadAt(pos, bytes, data.data()) != expected || !CheckTestFileData(pos, data.data(), expected))
+					success = false;
+			}
+		}));
+	}
+	for (std::thread &th : threads)
+		th.join();
+
+	EXPECT_TRUE(success);
+	EXPECT_TRUE(server.Connections() <= MAX_EXPECTED_CONNECTIONS);
+	return true;
+}
+
+static bool TestHTTPReadahead(RangeServerMode mode) {
+	RangeServer server;
+	EXPECT_TRUE(server.Start(mode));
+
+	// Sequential reads, so readahead grows and is fetched over several connections at once.
+	CachingFileLoader loader(new HTTPFileLoader(server.URL()));
+	EXPECT_TRUE(loader.FileSize() == TEST_FILE_SIZE);
+	std::vector<u8> data(32768);
+	for (s64 pos = 0; pos < TEST_FILE_SIZE; pos += data.size()) {
+		size_t expected = (size_t)std::min((s64)data.size(), TEST_FILE_SIZE - pos);
+		EXPECT_EQ_INT((int)loader.ReadAt(pos, data.size(), data.data()), (int)expected);
+		EXPECT_TRUE(CheckTestFileData(pos, data.data(), expected));
+	}
+
+	EXPECT_TRUE(server.Connections() <= MAX_EXPECTED_CONNECTIONS);
+	return true;
+}
+
+static bool TestHTTPIdleClose() {
+	RangeServer server;
+	EXPECT_TRUE(server.Start(RangeServerMode::CLOSE_WHEN_IDLE));
+
+	HTTPFileLoader loader(server.URL());
+	EXPECT_TRUE(loader.FileSize() == TEST_FILE_SIZE);
+
+	u8 data[4096];
+	EXPECT_EQ_INT((int)loader.ReadAt(0, sizeof(data), data), (int)sizeof(data));
+	EXPECT_TRUE(CheckTestFileData(0, data, sizeof(data)));
+	const int connections = server.Connections();
+
+	// Give the server time to drop the idle connection.  The next read should just reconnect.
+	sleep_ms(200);
+	EXPECT_EQ_INT((int)loader.ReadAt(100000, sizeof(data), data), (int)sizeof(data));
+	EXPECT_TRUE(CheckTestFileData(100000, data, sizeof(data)));
+	EXPECT_TRUE(server.Connections() > connections);
+	return true;
+}
+
+static bool TestHTTPNoLength() {
+	RangeServer server;
+	EXPECT_TRUE(server.Start(RangeServerMode::NO_LENGTH));
+
+	HTTPFileLoader loader(server.URL());
+	EXPECT_TRUE(loader.FileSize() == TEST_FILE_SIZE);
+
+	// The server never closes, so waiting for the end would hang.  This must fail instead.
+	u8 data[4096];
+	double st = time_now_d();
+	EXPECT_EQ_INT((int)loader.ReadAt(0, sizeof(data), data), 0);
+	EXPECT_TRUE(time_now_d() - st < 5.0);
+	return true;
+}
+
+#endif
+
+bool TestHTTPFileLoader() {
+#if PPSSPP_PLATFORM(WINDOWS)
+	printf("Test server not supported on this platform, skipping\n");
+	return true;
+#else
+	net::Init();
+	bool success = TestHTTPParallelReads() &&
+		TestHTTPReadahead(RangeServerMode::KEEP_ALIVE) &&
+		TestHTTPReadahead(RangeServerMode::CHUNKED) &&
+		TestHTTPIdleClose() &&
+		TestHTTPNoLength();
+	net::Shutdown();
+	return success;
+#endif
+}
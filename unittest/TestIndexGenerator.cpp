@@ -0,0 +1,196 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Common/IndexGenerator.h"
+#include "GPU/ge_constants.h"
+#include "unittest/UnitTest.h"
+
+// Straightforward versions of what IndexGenerator should produce, one triangle (or line) at a time.
+template <class T>
+static std::vector<u16> ReferenceIndices(int prim, int count, const T *inds, int offset, bool clockwise) {
+	std::vector<u16> result;
+	auto at = [&](int i) -> u16 {
+		return inds ? (u16)(offset + inds[i]) : (u16)(offset + i);
+	};
+	const int v1 = clockwise ? 1 : 2;
+	const int v2 = clockwise ? 2 : 1;
+	switch (prim) {
+	case GE_PRIM_POINTS:
+		for (int i = 0; i < count; ++i)
+			result.push_back(at(i));
+		break;
+	case GE_PRIM_LINES:
+	case GE_PRIM_RECTANGLES:
+		for (int i = 0; i + 1 < count; i += 2) {
+			result.push_back(at(i));
+			result.push_back(at(i + 1));
+		}
+		break;
+	case GE_PRIM_LINE_STRIP:
+		for (int i = 0; i + 1 < count; ++i) {
+			result.push_back(at(i));
+			result.push_back(at(i + 1));
+		}
+		break;
+	case GE_PRIM_TRIANGLES:
+		for (int i = 0; i + 2 < count; i += 3) {
+			result.push_back(at(i));
+			result.push_back(at(i + v1));
+			result.push_back(at(i + v2));
+		}
+		break;
+	case GE_PRIM_TRIANGLE_STRIP:
+		for (int i = 0; i + 2 < count; ++i) {
+			bool flip = (i & 1) != 0;
+			result.push_back(at(i));
+			result.push_back(at(i + (flip ? v2 : v1)));
+			result.push_back(at(i + (flip ? v1 : v2)));
+		}
+		break;
+	case GE_PRIM_TRIANGLE_FAN:
+		for (int i = 0; i + 2 < count; ++i) {
+			result.push_back(at(0));
+			result.push_back(at(i + v1));
+			result.push_back(at(i + v2));
+		}
+		break;
+	}
+	return result;
+}
+
+static bool CompareIndices(const char *title, int prim, int count, bool clockwise, const u16 *generated, const std::vector<u16> &expected) {
+	for (size_t i = 0; i < expected.size(); ++i) {
+		if (generated[i] != expected[i]) {
+			printf("%s: prim %d, count %d, %s: index %d is %d, expected %d\n", title, prim, count, clockwise ? "cw" : "ccw", (int)i, generated[i], expected[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+template <class T>
+static bool TestTranslate(IndexGenerator &gen, u16 *dest, T *src, int prim, int count, bool clockwise) {
+	// Put the source right at the end of a buffer, like the last indices in PSP RAM.
+	for (int i = 0; i < count; ++i)
+		src[i] = (T)((u32)rand() * 2654435761U);
+
+	gen.Setup(dest);
+	gen.Advance(500);
+	gen.TranslatePrim(prim, count, src, 100, clockwise);
+	std::vector<u16> expected = ReferenceIndices(prim, count, src, 400, clockwise);
+	if (gen.VertexCount() != (int)expected.size()) {
+		printf("Translate: prim %d, count %d: %d indices, expected %d\n", prim, count, gen.VertexCount(), (int)expected.size());
+		return false;
+	}
+	return CompareIndices("Translate", prim, count, clockwise, dest, expected);
+}
+
+static bool TestIndexCorrectness() {
+	static const int MAX_COUNT = 100;
+	std::vector<u16> dest(MAX_COUNT * 16);
+	std::vector<u8> src8(MAX_COUNT);
+	std::vector<u16_le> src16(MAX_COUNT);
+	std::vector<u32_le> src32(MAX_COUNT);
+
+	IndexGenerator gen;
+	for (int prim = GE_PRIM_POINTS; prim <= GE_PRIM_RECTANGLES; ++prim) {
+		for (int count = 3; count < MAX_COUNT; ++count) {
+			for (int cw = 0; cw < 2; ++cw) {
+				bool clockwise = cw != 0;
+				gen.Setup(&dest[0]);
+				gen.Advance(1234);
+				gen.AddPrim(prim, count, clockwise);
+				std::vector<u16> expected = ReferenceIndices<u8>(prim, count, nullptr, 1234, clockwise);
+				RET(CompareIndices("Generate", prim, count, clockwise, &dest[0], expected));
+
+				RET(TestTranslate(gen, &dest[0], &src8[MAX_COUNT - count], prim, count, clockwise));
+				RET(TestTranslate(gen, &dest[0], &src16[MAX_COUNT - count], prim, count, clockwise));
+				RET(TestTranslate(gen, &dest[0], &src32[MAX_COUNT - count], prim, count, clockwise));
+			}
+		}
+	}
+
+	return true;
+}
+
+template <class T>
+static double TimeTranslate(IndexGenerator &gen, u16 *dest, const T *src, int prim, int count) {
+	static const int ROUNDS = 200;
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < ROUNDS; ++j) {
+			gen.Setup(dest);
+			gen.TranslatePrim(prim, count, src, 0, (j & 1) != 0);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	return total * (double)count / (time_now_d() - st);
+}
+
+static double TimeGenerate(IndexGenerator &gen, u16 *dest, int prim, int count) {
+	static const int ROUNDS = 200;
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < ROUNDS; ++j) {
+			gen.Setup(dest);
+			gen.AddPrim(prim, count, (j & 1) != 0);
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	return total * (double)count / (time_now_d() - st);
+}
+
+static void BenchmarkIndexGenerator() {
+	static const int COUNT = 4096;
+	static const char *const primNames[] = { "points", "lines", "line strip", "triangles", "triangle strip", "triangle fan", "rectangles" };
+
+	std::vector<u16> dest(COUNT * 16);
+	std::vector<u8> src8(COUNT);
+	std::vector<u16_le> src16(COUNT);
+	std::vector<u32_le> src32(COUNT);
+	for (int i = 0; i < COUNT; ++i) {
+		src8[i] = rand() & 0xFF;
+		src16[i] = rand() & 0xFFFF;
+		src32[i] = rand() & 0xFFFF;
+	}
+
+	IndexGenerator gen;
+	for (int prim = GE_PRIM_POINTS; prim <= GE_PRIM_RECTANGLES; ++prim) {
+		double gen0 = TimeGenerate(gen, &dest[0], prim, COUNT);
+		double tr8 = TimeTranslate(gen, &dest[0], &src8[0], prim, COUNT);
+		double tr16 = TimeTranslate(gen, &dest[0], &src16[0], prim, COUNT);
+		double tr32 = TimeTranslate(gen, &dest[0], &src32[0], prim, COUNT);
+		printf("%s: %0.1f Mverts/s generated, %0.1f / %0.1f / %0.1f Mverts/s translated from u8 / u16 / u32\n", primNames[prim], gen0 / 1000000.0, tr8 / 1000000.0, tr16 / 1000000.0, tr32 / 1000000.0);
+	}
+}
+
+bool TestIndexGenerator() {
+	srand(4242);
+	if (!TestIndexCorrectness())
+		return false;
+
+	BenchmarkIndexGenerator();
+	return true;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <cstdio>
+#if !PPSSPP_PLATFORM(WINDOWS)
+#include <unistd.h>
+#endif
+
+#include "Common/CommonTypes.h"
+#include "Common/ExceptionHandlerSetup.h"
+#include "Core/MemFault.h"
+#include "Core/MemMap.h"
+#include "Core/MemWriteTracker.h"
+#include "unittest/UnitTest.h"
+
+static const u32 testAddress = 0x08800000;
+
+static bool TestWatchedWrites() {
+	const u32 pageSize = Memory::WriteTracker_PageSize();
+
+	u32 stamp = Memory::WriteTracker_Watch(testAddress, pageSize * 2);
+	EXPECT_TRUE(stamp != 0);
+	EXPECT_FALSE(Memory::WriteTracker_WrittenSince(testAddress, pageSize * 2, stamp));
+
+	// This faults, and the handler stamps the page and lets the write through.
+	Memory::Write_U32(0x12345678, testAddress + pageSize + 4);
+	EXPECT_EQ_HEX(Memory::Read_U32(testAddress + pageSize + 4), 0x12345678);
+	EXPECT_TRUE(Memory::WriteTracker_WrittenSince(testAddress + pageSize, pageSize, stamp));
+	EXPECT_FALSE(Memory::WriteTracker_WrittenSince(testAddress, pageSize, stamp));
+
+	// Writes through the uncached mirror count too.
+	stamp = Memory::WriteTracker_Watch(testAddress, pageSize);
+	Memory::Write_U32(0xCAFEBABE, testAddress | 0x40000000);
+	EXPECT_EQ_HEX(Memory::Read_U32(testAddress), 0xCAFEBABE);
+	EXPECT_TRUE(Memory::WriteTracker_WrittenSince(testAddress, pageSize, stamp));
+
+	// Ignored writes don't count, and the page is watched again afterward.
+	stamp = Memory::WriteTracker_Watch(testAddress, pageSize);
+	Memory::WriteTracker_BeginIgnoringWrites();
+	Memory::Write_U32(0, testAddress);
+	Memory::WriteTracker_EndIgnoringWrites();
+	EXPECT_FALSE(Memory::WriteTracker_WrittenSince(testAddress, pageSize, stamp));
+	Memory::Write_U32(1, testAddress);
+	EXPECT_TRUE(Memory::WriteTracker_WrittenSince(testAddress, pageSize, stamp));
+
+	return true;
+}
+
+static bool TestOSWrites() {
+#if !PPSSPP_PLATFORM(WINDOWS)
+	const u32 pageSize = Memory::WriteTracker_PageSize();
+	int fds[2];
+	EXPECT_EQ_INT(pipe(fds), 0);
+	EXPECT_EQ_INT((int)write(fds[1], "psp!", 4), 4);
+
+	// The kernel won't fault on our behalf, so this is how sockets and files write into RAM.
+	u32 stamp = Memory::WriteTracker_Watch(testAddress, pageSize);
+	u8 *ptr = Memory::GetPointer(testAddress);
+	Memory::WriteTracker_NotifyHostWrite(ptr, 4);
+	int bytes = (int)read(fds[0], ptr, 4);
+	close(fds[0]);
+	close(fds[1]);
+	EXPECT_EQ_INT(bytes, 4);
+	EXPECT_EQ_HEX(Memory::Read_U32(testAddress), 0x21707370);
+	EXPECT_TRUE(Memory::WriteTracker_WrittenSince(testAddress, pageSize, stamp));
+
+	// Host buffers outside PSP memory are just ignored.
+	u8 hostBuffer[4];
+	stamp = Memory::WriteTracker_Watch(testAddress, pageSize);
+	Memory::WriteTracker_NotifyHostWrite(hostBuffer, sizeof(hostBuffer));
+	EXPECT_FALSE(Memory::WriteTracker_WrittenSince(testAddress, pageSize, stamp));
+#endif
+	return true;
+}
+
+bool TestMemWriteTracker() {
+	if (!Memory::WriteTracker_Supported()) {
+		printf("Write tracking not supported on this platform, skipping\n");
+		return true;
+	}
+
+	InstallExceptionHandler(&Memory::HandleFault);
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	Memory::Init();
+
+	bool success = TestWatchedWrites() && TestOSWrites();
+
+	Memory::Shutdown();
+	UninstallExceptionHandler();
+	return success;
+}
@@ -0,0 +1,270 @@
+// Copyright (c) 2020- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Common/Common.h"
+#include "Common/ColorConv.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "unittest/UnitTest.h"
+
+static void RandomFill(void *p, size_t sz) {
+	u8 *bytes = (u8 *)p;
+	for (size_t i = 0; i < sz; ++i)
+		bytes[i] = (u8)(rand() >> 4);
+}
+
+static u32 SwapRB(u32 c) {
+	return (c & 0xFF00FF00) | ((c >> 16) & 0xFF) | ((c & 0xFF) << 16);
+}
+
+static u32 RGBA4444ToRGBA8888Ref(u16 c) { return RGBA4444ToRGBA8888(c); }
+static u32 RGBA5551ToRGBA8888Ref(u16 c) { return RGBA5551ToRGBA8888(c); }
+static u32 RGB565ToRGBA8888Ref(u16 c) { return RGB565ToRGBA8888(c); }
+
+static bool TestConvert16To32(const char *title, Convert16bppTo32bppFunc func, u32 (*ref)(u16), bool swapRB) {
+	static const int MAX_COUNT = 67;
+	std::vector<u16> src(MAX_COUNT + 1);
+	std::vector<u32> dst(MAX_COUNT + 1);
+
+	// Try all sizes at both aligned and unaligned offsets.
+	for (int offset = 0; offset < 2; ++offset) {
+		for (int count = 1; count < MAX_COUNT; ++count) {
+			RandomFill(&src[0], src.size() * sizeof(u16));
+			func(&dst[offset], &src[offset], count);
+			for (int i = 0; i < count; ++i) {
+				u32 expected = ref(src[offset + i]);
+				if (swapRB)
+					expected = SwapRB(expected);
+				if (dst[offset + i] != expected) {
+					printf("%s: count %d, pixel %d of %04x is %08x, expected %08x\n", title, count, i, src[offset + i], dst[offset + i], expected);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+template <typename ClutT>
+static bool TestDeIndex4(const char *title) {
+	static const int MAX_COUNT = 100;
+	std::vector<u8> indexed(MAX_COUNT / 2 + 1);
+	std::vector<ClutT> dest(MAX_COUNT + 2);
+	ClutT clut[16];
+
+	for (int offset = 0; offset < 2; ++offset) {
+		for (int count = 2; count < MAX_COUNT; count += 2) {
+			RandomFill(&indexed[0], indexed.size());
+			RandomFill(clut, sizeof(clut));
+			DeIndexTexture4Simple(&dest[offset], &indexed[offset], count, clut);
+			for (int i = 0; i < count; ++i) {
+				u8 index = (indexed[offset + i / 2] >> ((i & 1) * 4)) & 0xF;
+				if (dest[offset + i] != clut[index]) {
+					printf("%s: count %d, pixel %d is %08x, expected %08x\n", title, count, i, (u32)dest[offset + i], (u32)clut[index]);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// The plain per pixel DXT decoding the optimized decoders replaced, to check them against.
+static u32 RefDXTColor(const DXT1Block &block, int x, int y, bool ignore1bitAlpha) {
+	const u16 c1 = block.color1;
+	const u16 c2 = block.color2;
+	const int r[2] = { (c1 << 3) & 0xF8, (c2 << 3) & 0xF8 };
+	const int g[2] = { (c1 >> 3) & 0xFC, (c2 >> 3) & 0xFC };
+	const int b[2] = { (c1 >> 8) & 0xF8, (c2 >> 8) & 0xF8 };
+	const u32 alpha = ignore1bitAlpha ? 0 : 0xFF000000;
+
+	auto makecol = [&](int red, int green, int blue) {
+		return alpha | (red << 16) | (green << 8) | blue;
+	};
+
+	const int index = (block.lines[y] >> (x * 2)) & 3;
+	if (index < 2)
+		return makecol(r[index], g[index], b[index]);
+	if (c1 > c2) {
+		const int near = index - 2, far = 3 - index;
+		return makecol((r[near] * 2 + r[far]) / 3, (g[near] * 2 + g[far]) / 3, (b[near] * 2 + b[far]) / 3);
+	}
+	if (index == 2)
+		return makecol((r[0] + r[1]) / 2, (g[0] + g[1]) / 2, (b[0] + b[1]) / 2);
+	return 0;
+}
+
+static u32 RefDXT1(const DXT1Block &block, int x, int y, bool ignore1bitAlpha) {
+	return RefDXTColor(block, x, y, ignore1bitAlpha);
+}
+
+static u32 RefDXT3(const DXT3Block &block, int x, int y) {
+	return RefDXTColor(block.color, x, y, true) | ((u32)((block.alphaLines[y] >> (x * 4)) & 0xF) << 28);
+}
+
+static u32 RefDXT5(const DXT5Block &block, int x, int y) {
+	const u64 alphadata = ((u64)(u16)block.alphadata1 << 32) | (u32)block.alphadata2;
+	const int index = (int)((alphadata >> ((y * 4 + x) * 3)) & 7);
+	const int a1 = block.alpha1, a2 = block.alpha2;
+
+	int alpha;
+	if (index < 2) {
+		alpha = index == 0 ? a1 : a2;
+	} else if (a1 > a2) {
+		const int n = index - 1;
+		alpha = (a1 * (((7 - n) << 8) / 7) + a2 * ((n << 8) / 7) + 255) >> 8;
+	} else if (index < 6) {
+		const int n = index - 1;
+		alpha = (a1 * (((5 - n) << 8) / 5) + a2 * ((n << 8) / 5) + 255) >> 8;
+	} else {
+		alpha = index == 6 ? 0 : 255;
+	}
+	return RefDXTColor(block.color, x, y, true) | ((u32)(u8)alpha << 24);
+}
+
+// Decodes random blocks, with every line count, and checks each pixel against the reference.
+template <typename BlockT, typename Decode, typename Ref>
+static bool TestDXT(const char *title, Decode decode, Ref ref) {
+	for (int n = 0; n < 2000; ++n) {
+		BlockT block;
+		RandomFill(&block, sizeof(block));
+		const int height = (n % 4) + 1;
+
+		// Write past the end of the line to catch stray writes.
+		u32 dst[4 * 6];
+		memset(dst, 0xCC, sizeof(dst));
+		decode(dst, &block, 6, height);
+
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < 4; ++x) {
+				const u32 expected = ref(block, x, y);
+				if (dst[y * 6 + x] != expected) {
+					printf("%s: pixel %d,%d is %08x, expected %08x\n", title, x, y, dst[y * 6 + x], expected);
+					return false;
+				}
+			}
+			if (dst[y * 6 + 4] != 0xCCCCCCCC || dst[y * 6 + 5] != 0xCCCCCCCC) {
+				printf("%s: wrote outside block on line %d\n", title, y);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void DecodeDXT1(u32 *dst, const DXT1Block *src, int pitch, int height) {
+	DecodeDXT1Block(dst, src, pitch, height, false);
+}
+
+static bool TestTextureDecodeCorrectness() {
+	RET(TestConvert16To32("RGB565ToRGBA8888", &ConvertRGB565ToRGBA8888, &RGB565ToRGBA8888Ref, false));
+	RET(TestConvert16To32("RGBA5551ToRGBA8888", &ConvertRGBA5551ToRGBA8888, &RGBA5551ToRGBA8888Ref, false));
+	RET(TestConvert16To32("RGBA4444ToRGBA8888", &ConvertRGBA4444ToRGBA8888, &RGBA4444ToRGBA8888Ref, false));
+	RET(TestConvert16To32("RGB565ToBGRA8888", &ConvertRGB565ToBGRA8888, &RGB565ToRGBA8888Ref, true));
+	RET(TestConvert16To32("RGBA5551ToBGRA8888", &ConvertRGBA5551ToBGRA8888, &RGBA5551ToRGBA8888Ref, true));
+	RET(TestConvert16To32("RGBA4444ToBGRA8888", &ConvertRGBA4444ToBGRA8888, &RGBA4444ToRGBA8888Ref, true));
+
+	RET(TestDeIndex4<u16>("CLUT4 16-bit"));
+	RET(TestDeIndex4<u32>("CLUT4 32-bit"));
+
+	RET(TestDXT<DXT1Block>("DXT1", &DecodeDXT1, [](const DXT1Block &block, int x, int y) {
+		return RefDXT1(block, x, y, false);
+	}));
+	RET(TestDXT<DXT1Block>("DXT1 ignoring alpha", [](u32 *dst, const DXT1Block *src, int pitch, int height) {
+		DecodeDXT1Block(dst, src, pitch, height, true);
+	}, [](const DXT1Block &block, int x, int y) {
+		return RefDXT1(block, x, y, true);
+	}));
+	RET(TestDXT<DXT3Block>("DXT3", &DecodeDXT3Block, &RefDXT3));
+	RET(TestDXT<DXT5Block>("DXT5", &DecodeDXT5Block, &RefDXT5));
+	return true;
+}
+
+// Returns megapixels per second for a func that decodes pixels each call.
+template <typename F>
+static double TimeDecode(int pixels, F func) {
+	static const int ROUNDS = 20;
+	int total = 0;
+	double st = time_now_d();
+	do {
+		for (int j = 0; j < ROUNDS; ++j) {
+			func();
+			++total;
+		}
+	} while (time_now_d() - st < 0.25);
+	return total * (double)pixels / (time_now_d() - st) / 1000000.0;
+}
+
+template <typename BlockT>
+static double TimeDXT(const std::vector<u8> &src, std::vector<u32> &dst, int w, int h, void (*decode)(u32 *dst, const BlockT *src, int pitch, int height)) {
+	const BlockT *blocks = (const BlockT *)&src[0];
+	return TimeDecode(w * h, [&] {
+		for (int y = 0; y < h; y += 4) {
+			for (int x = 0; x < w; x += 4) {
+				decode(&dst[y * w + x], blocks++, w, 4);
+			}
+		}
+		blocks = (const BlockT *)&src[0];
+	});
+}
+
+bool TestTextureDecoderBenchmark() {
+	static const int W = 512;
+	static const int H = 512;
+	std::vector<u8> src(W * H * 4);
+	std::vector<u32> dst(W * H);
+	RandomFill(&src[0], src.size());
+	const u16 *src16 = (const u16 *)&src[0];
+	u32 clut32[16];
+	u16 clut16[16];
+	RandomFill(clut32, sizeof(clut32));
+	RandomFill(clut16, sizeof(clut16));
+
+	printf("DXT1: %0.1f Mpixels/s\n", TimeDXT<DXT1Block>(src, dst, W, H, &DecodeDXT1));
+	printf("DXT3: %0.1f Mpixels/s\n", TimeDXT<DXT3Block>(src, dst, W, H, &DecodeDXT3Block));
+	printf("DXT5: %0.1f Mpixels/s\n", TimeDXT<DXT5Block>(src, dst, W, H, &DecodeDXT5Block));
+
+	printf("CLUT4 16-bit: %0.1f Mpixels/s\n", TimeDecode(W * H, [&] {
+		for (int y = 0; y < H; ++y)
+			DeIndexTexture4Simple((u16 *)&dst[0] + y * W, &src[y * W / 2], W, clut16);
+	}));
+	printf("CLUT4 32-bit: %0.1f Mpixels/s\n", TimeDecode(W * H, [&] {
+		for (int y = 0; y < H; ++y)
+			DeIndexTexture4Simple(&dst[y * W], &src[y * W / 2], W, clut32);
+	}));
+
+	printf("RGB565 to 8888: %0.1f Mpixels/s\n", TimeDecode(W * H, [&] {
+		ConvertRGB565ToRGBA8888(&dst[0], src16, W * H);
+	}));
+	printf("RGBA5551 to 8888: %0.1f Mpixels/s\n", TimeDecode(W * H, [&] {
+		ConvertRGBA5551ToRGBA8888(&dst[0], src16, W * H);
+	}));
+	printf("RGBA4444 to 8888: %0.1f Mpixels/s\n", TimeDecode(W * H, [&] {
+		ConvertRGBA4444ToRGBA8888(&dst[0], src16, W * H);
+	}));
+	return true;
+}
+
+bool TestTextureDecoder() {
+	srand(1234);
+	return TestTextureDecodeCorrectness();
+}
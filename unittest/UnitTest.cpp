@@ -570,14 +570,25 @@ typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
 	TestFunc func;
+	// Only run when asked for by name, not with "all".
+	bool benchmark;
 };
 
-#define TEST_ITEM(name) { #name, &Test ##name, }
+#define TEST_ITEM(name) { #name, &Test ##name, false, }
+#define BENCHMARK_ITEM(name) { #name, &Test ##name, true, }
 
 bool TestArmEmitter();
 bool TestArm64Emitter();
 bool TestX64Emitter();
 bool TestShaderGenerators();
+bool TestIndexGenerator();
+bool TestTextureDecoder();
+bool TestTextureDecoderBenchmark();
+bool TestCoreTiming();
+bool TestCoreTimingBenchmark();
+bool TestMemWriteTracker();
+bool TestHTTPFileLoader();
+bool TestBlockAllocator();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -596,11 +607,20 @@ TestItem availableTests[] = {
 	TEST_ITEM(MathUtil),
 	TEST_ITEM(Parsers),
 	TEST_ITEM(Jit),
+	TEST_ITEM(JitVFPU),
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(ShaderGenerators),
+	TEST_ITEM(IndexGenerator),
+	TEST_ITEM(TextureDecoder),
+	TEST_ITEM(CoreTiming),
+	TEST_ITEM(MemWriteTracker),
+	TEST_ITEM(HTTPFileLoader),
+	TEST_ITEM(BlockAllocator),
+	BENCHMARK_ITEM(TextureDecoderBenchmark),
+	BENCHMARK_ITEM(CoreTimingBenchmark),
 };
 
 int main(int argc, const char *argv[]) {
@@ -628,6 +648,8 @@ int main(int argc, const char *argv[]) {
 		int passes = 0;
 		int fails = 0;
 		for (auto f : availableTests) {
+			if (f.benchmark)
+				continue;
 			if (f.func()) {
 				++passes;
 			} else {
@@ -646,7 +668,7 @@ int main(int argc, const char *argv[]) {
 		fprintf(stderr, "\n");
 		fprintf(stderr, "Available tests:\n");
 		for (auto f : availableTests) {
-			fprintf(stderr, "  * %s\n", f.name);
+			fprintf(stderr, "  * %s%s\n", f.name, f.benchmark ? " (benchmark)" : "");
 		}
 		return 1;
 	} else {